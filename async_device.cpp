@@ -0,0 +1,226 @@
+#include "async_device.hpp"
+
+namespace STM32_Utility {
+
+    namespace {
+
+        auto async_slots(OWDevice& device, std::uint8_t* const slots, std::size_t const size) noexcept
+        {
+            return async_transfer(
+                [&device, slots, size](TransferCallback const callback, void* const context) noexcept {
+                    return device.start_slots(slots, size, callback, context);
+                });
+        }
+
+        Task<Expected<>> async_select(OWDevice& device, std::uint64_t const rom) noexcept
+        {
+            if (rom != 0ULL) {
+                auto command = std::array<std::uint8_t, 9UL>{OWDevice::MATCH_ROM};
+                for (std::size_t byte = 0UL; byte < 8UL; ++byte) {
+                    command[1UL + byte] = static_cast<std::uint8_t>(rom >> (8UL * byte));
+                }
+                co_return co_await async_transmit(device, command.data(), command.size());
+            }
+
+            co_return co_await async_transmit(device, &OWDevice::SKIP_ROM, 1UL);
+        }
+
+        // same slot framing as OWDevice::search_next, split from async_search to keep both frames small,
+        // false when the search ends without a ROM
+        Task<Expected<bool>> async_search_next(OWDevice& device,
+                                     std::uint8_t const command,
+                                     std::uint64_t& rom,
+                                     std::size_t& last_discrepancy) noexcept
+        {
+            if (auto const presence = co_await async_reset(device); !presence || !*presence) {
+                co_return presence;
+            }
+            if (auto const result = co_await async_transmit(device, &command, 1UL); !result) {
+                co_return std::unexpected{result.error()};
+            }
+
+            auto next_rom = 0ULL;
+            auto last_zero = std::size_t{0UL};
+            auto direction = false;
+
+            // one awaited transfer per bit, the pass past the last bit only writes its direction
+            for (std::size_t bit = 0UL; bit <= 64UL; ++bit) {
+                auto slots = std::array<std::uint8_t, 3UL>{
+                    direction ? OWDevice::SLOT_HIGH : OWDevice::SLOT_LOW, OWDevice::SLOT_HIGH, OWDevice::SLOT_HIGH};
+                auto const first = bit == 0UL ? 1UL : 0UL;
+                auto const last = bit == 64UL ? 1UL : slots.size();
+
+                if (auto const result = co_await async_slots(device, slots.data() + first, last - first); !result) {
+                    co_return std::unexpected{result.error()};
+                }
+                if (bit == 64UL) {
+                    break;
+                }
+
+                if (!OWDevice::search_branch(bit,
+                                             slots[1] == OWDevice::SLOT_HIGH,
+                                             slots[2] == OWDevice::SLOT_HIGH,
+                                             rom,
+                                             last_discrepancy,
+                                             direction,
+                                             last_zero)) {
+                    co_return false;
+                }
+                if (direction) {
+                    next_rom |= 1ULL << bit;
+                }
+            }
+
+            rom = next_rom;
+            last_discrepancy = last_zero;
+
+            co_return true;
+        }
+
+        Task<Expected<std::size_t>> async_search(OWDevice& device,
+                                                 std::uint8_t const command,
+                                                 std::uint64_t* const roms,
+                                                 std::size_t const size) noexcept
+        {
+            assert(roms);
+
+            auto rom = 0ULL;
+            auto last_discrepancy = std::size_t{0UL};
+            auto count = std::size_t{0UL};
+
+            while (count < size) {
+                auto const found = co_await async_search_next(device, command, rom, last_discrepancy);
+                if (!found) {
+                    co_return std::unexpected{found.error()};
+                }
+                if (!*found) {
+                    break;
+                }
+
+                // a ROM failing its CRC still steers the search, the devices past it are found all the same
+                if (ow_rom_is_valid(rom)) {
+                    roms[count++] = rom;
+                }
+                if (last_discrepancy == 0UL) {
+                    break;
+                }
+            }
+
+            co_return count;
+        }
+
+    }; // namespace
+
+    Task<Expected<bool>> async_reset(OWDevice& device) noexcept
+    {
+        auto pulse = OWDevice::RESET_PULSE;
+
+        OWDevice::set_baud_rate(device.uart_bus, OWDevice::RESET_BAUD_RATE);
+        auto const result = co_await async_slots(device, &pulse, 1UL);
+        OWDevice::set_baud_rate(device.uart_bus, OWDevice::SLOT_BAUD_RATE);
+
+        if (!result) {
+            co_return std::unexpected{result.error()};
+        }
+
+        co_return pulse != OWDevice::RESET_PULSE;
+    }
+
+    Task<Expected<>> async_transmit(OWDevice& device, std::uint8_t const* const data, std::size_t const size) noexcept
+    {
+        assert(data);
+
+        auto slots = std::array<std::uint8_t, 8UL * OWDevice::FRAME_BYTES>{};
+
+        for (std::size_t offset = 0UL; offset < size; offset += OWDevice::FRAME_BYTES) {
+            auto const frame_size = std::min(OWDevice::FRAME_BYTES, size - offset);
+
+            OWDevice::encode_slots(data + offset, frame_size, slots.data());
+            if (auto const result = co_await async_slots(device, slots.data(), 8UL * frame_size); !result) {
+                co_return result;
+            }
+        }
+
+        co_return Expected<>{};
+    }
+
+    Task<Expected<>> async_receive(OWDevice& device, std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        assert(data);
+
+        auto slots = std::array<std::uint8_t, 8UL * OWDevice::FRAME_BYTES>{};
+
+        for (std::size_t offset = 0UL; offset < size; offset += OWDevice::FRAME_BYTES) {
+            auto const frame_size = std::min(OWDevice::FRAME_BYTES, size - offset);
+
+            std::fill_n(slots.data(), 8UL * frame_size, OWDevice::SLOT_HIGH);
+            if (auto const result = co_await async_slots(device, slots.data(), 8UL * frame_size); !result) {
+                co_return result;
+            }
+            OWDevice::decode_slots(slots.data(), frame_size, data + offset);
+        }
+
+        co_return Expected<>{};
+    }
+
+    Task<Expected<std::size_t>> async_search_rom(OWDevice& device,
+                                                 std::uint64_t* const roms,
+                                                 std::size_t const size) noexcept
+    {
+        co_return co_await async_search(device, OWDevice::SEARCH_ROM, roms, size);
+    }
+
+    Task<Expected<std::size_t>> async_alarm_search(OWDevice& device,
+                                                   std::uint64_t* const roms,
+                                                   std::size_t const size) noexcept
+    {
+        co_return co_await async_search(device, OWDevice::ALARM_SEARCH, roms, size);
+    }
+
+    Task<std::optional<OWScratchpad>> async_read_scratchpad(OWDevice& device, std::uint64_t const rom) noexcept
+    {
+        if (auto const presence = co_await async_reset(device); !presence || !*presence) {
+            co_return std::nullopt;
+        }
+
+        auto scratchpad = OWScratchpad{};
+        if (!co_await async_select(device, rom) ||
+            !co_await async_transmit(device, &OWDevice::READ_SCRATCHPAD, 1UL) ||
+            !co_await async_receive(device, scratchpad.data(), scratchpad.size()) ||
+            ow_crc8(scratchpad.data(), scratchpad.size()) != 0U) {
+            co_return std::nullopt;
+        }
+
+        co_return scratchpad;
+    }
+
+    Task<Expected<>> async_convert_all(OWDevice& device) noexcept
+    {
+        auto const command = std::array<std::uint8_t, 2UL>{OWDevice::SKIP_ROM, OWDevice::CONVERT_T};
+
+        if (auto const presence = co_await async_reset(device); !presence || !*presence) {
+            co_return std::unexpected{presence.error_or(HAL_ERROR)};
+        }
+        if (auto const result = co_await async_transmit(device, command.data(), command.size()); !result) {
+            co_return result;
+        }
+
+        // a read slot stays low until the conversion is done
+        auto const start = HAL_GetTick();
+        while (true) {
+            auto slot = OWDevice::SLOT_HIGH;
+            if (auto const result = co_await async_slots(device, &slot, 1UL); !result) {
+                co_return result;
+            }
+            if (slot == OWDevice::SLOT_HIGH) {
+                co_return Expected<>{};
+            }
+            if (HAL_GetTick() - start > OWDevice::CONVERSION_TIMEOUT) {
+                co_return std::unexpected{HAL_TIMEOUT};
+            }
+
+            co_await async_delay(1UL);
+        }
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef ASYNC_DEVICE_HPP
+#define ASYNC_DEVICE_HPP
+
+#include "common.hpp"
+#include "coroutine.hpp"
+#include "i2c_bus.hpp"
+#include "i2c_device.hpp"
+#include "ow_device.hpp"
+#include "spi_dma_device.hpp"
+
+namespace STM32_Utility {
+
+    // Awaitable counterparts of the DMA and queued transfers: co_await suspends the calling task until
+    // the completion callback, so other tasks run while the bus is busy. Data must outlive the co_await.
+
+    inline auto async_transfer(SPIDMADevice& device,
+                               std::uint8_t* const tx_data,
+                               std::uint8_t* const rx_data,
+                               std::size_t const size) noexcept
+    {
+        return async_transfer([&device, tx_data, rx_data, size](TransferCallback const callback,
+                                                                void* const context) noexcept {
+            return device.submit(SPITransfer{.tx_data = tx_data,
+                                             .rx_data = rx_data,
+                                             .size = size,
+                                             .callback = callback,
+                                             .context = context});
+        });
+    }
+
+    inline auto async_transmit(SPIDMADevice& device, std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        return async_transfer(device, data, nullptr, size);
+    }
+
+    inline auto async_receive(SPIDMADevice& device, std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        return async_transfer(device, nullptr, data, size);
+    }
+
+    inline auto async_read(I2CBus& bus,
+                           I2CDevice const& device,
+                           std::uint16_t const address,
+                           std::uint8_t* const data,
+                           std::size_t const size) noexcept
+    {
+        return async_transfer([&bus, &device, address, data, size](TransferCallback const callback,
+                                                                   void* const context) noexcept {
+            return bus.enqueue_read(device, address, data, size, callback, context);
+        });
+    }
+
+    inline auto async_write(I2CBus& bus,
+                            I2CDevice const& device,
+                            std::uint16_t const address,
+                            std::uint8_t* const data,
+                            std::size_t const size) noexcept
+    {
+        return async_transfer([&bus, &device, address, data, size](TransferCallback const callback,
+                                                                   void* const context) noexcept {
+            return bus.enqueue_write(device, address, data, size, callback, context);
+        });
+    }
+
+    // 1-Wire counterparts of OWDevice, every slot frame runs on the UART DMA and completes through
+    // OWDevice::transfer_complete_callback, so a ROM search suspends for each of its bits. A failed
+    // transfer or frame allocation gives its error, never a result that looks like an empty bus.
+    Task<Expected<bool>> async_reset(OWDevice& device) noexcept;
+
+    Task<Expected<>> async_transmit(OWDevice& device, std::uint8_t const* const data, std::size_t const size) noexcept;
+    Task<Expected<>> async_receive(OWDevice& device, std::uint8_t* const data, std::size_t const size) noexcept;
+
+    Task<Expected<std::size_t>> async_search_rom(OWDevice& device,
+                                                 std::uint64_t* const roms,
+                                                 std::size_t const size) noexcept;
+    Task<Expected<std::size_t>> async_alarm_search(OWDevice& device,
+                                                   std::uint64_t* const roms,
+                                                   std::size_t const size) noexcept;
+
+    // rom 0 - SKIP ROM, a single device on the bus
+    Task<std::optional<OWScratchpad>> async_read_scratchpad(OWDevice& device, std::uint64_t const rom) noexcept;
+
+    // convert_all that sleeps between polls instead of spinning, HAL_ERROR without a presence pulse and
+    // HAL_TIMEOUT when the conversion does not finish
+    Task<Expected<>> async_convert_all(OWDevice& device) noexcept;
+
+}; // namespace STM32_Utility
+
+#endif // ASYNC_DEVICE_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "clock.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    namespace {
+
+        bool is_on_apb2(void const* const instance) noexcept
+        {
+            auto const address = reinterpret_cast<std::uintptr_t>(instance);
+
+            return address >= APB2PERIPH_BASE && address < AHB1PERIPH_BASE;
+        }
+
+    }; // namespace
+
+    std::uint32_t get_timer_clock_frequency(TIMHandle const timer) noexcept
+    {
+        assert(timer);
+
+        if (is_on_apb2(timer->Instance)) {
+            auto const pclk = HAL_RCC_GetPCLK2Freq();
+            return (RCC->CFGR & RCC_CFGR_PPRE2) == RCC_CFGR_PPRE2_DIV1 ? pclk : 2UL * pclk;
+        } else {
+            auto const pclk = HAL_RCC_GetPCLK1Freq();
+            return (RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1 ? pclk : 2UL * pclk;
+        }
+    }
+
+    std::uint32_t get_uart_clock_frequency(UARTHandle const uart_bus) noexcept
+    {
+        assert(uart_bus);
+
+        return is_on_apb2(uart_bus->Instance) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+    }
+
+    std::uint32_t get_spi_clock_frequency(SPIHandle const spi_bus) noexcept
+    {
+        assert(spi_bus);
+
+        auto const pclk = is_on_apb2(spi_bus->Instance) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+
+        return pclk >> ((spi_bus->Init.BaudRatePrescaler >> 3U) + 1U);
+    }
+
+    std::uint32_t get_spi_prescaler(SPIHandle const spi_bus, std::uint32_t const frequency) noexcept
+    {
+        assert(spi_bus);
+
+        auto const pclk = is_on_apb2(spi_bus->Instance) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+
+        auto shift = std::uint32_t{0UL};
+        while (shift < 7U && (pclk >> (shift + 1U)) > frequency) {
+            ++shift;
+        }
+
+        return shift << 3U;
+    }
+
+    void enable_cycle_counter() noexcept
+    {
+        if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0UL) {
+            CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+        }
+    }
+
+    void delay_microseconds(std::uint32_t const delay) noexcept
+    {
+        enable_cycle_counter();
+
+        auto const start = DWT->CYCCNT;
+        auto const cycles = delay * (SystemCoreClock / 1000000UL);
+
+        while (DWT->CYCCNT - start < cycles) {
+            __NOP();
+        }
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include "common.hpp"
+
+namespace STM32_Utility {
+
+    std::uint32_t get_timer_clock_frequency(TIMHandle const timer) noexcept;
+
+    std::uint32_t get_uart_clock_frequency(UARTHandle const uart_bus) noexcept;
+
+    // SCK frequency set by the prescaler in the handle's init
+    std::uint32_t get_spi_clock_frequency(SPIHandle const spi_bus) noexcept;
+
+    // BaudRatePrescaler for the fastest SCK not above frequency, the slowest one when none fits
+    std::uint32_t get_spi_prescaler(SPIHandle const spi_bus, std::uint32_t const frequency) noexcept;
+
+    // DWT->CYCCNT counting HCLK cycles, left running if already enabled
+    void enable_cycle_counter() noexcept;
+
+    // busy waits on DWT->CYCCNT, enabling it first if needed
+    void delay_microseconds(std::uint32_t const delay) noexcept;
+
+    // HAL timeout in ticks for shifting bits at frequency: twice the bus time for clock stretching and
+    // ISR latency, rounded up, plus one tick since the first one may end right after the start
+    inline constexpr std::uint32_t get_transfer_timeout(std::uint64_t const bits,
+                                                        std::uint32_t const frequency) noexcept
+    {
+        if (frequency == 0UL) {
+            return HAL_MAX_DELAY;
+        }
+
+        auto const microseconds = (2ULL * bits * 1000000ULL + frequency - 1ULL) / frequency;
+
+        return static_cast<std::uint32_t>((microseconds + 999ULL) / 1000ULL) + 1UL;
+    }
+
+}; // namespace STM32_Utility
+
+#endif // CLOCK_HPP
\ No newline at end of file
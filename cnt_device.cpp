@@ -1,37 +1,224 @@
 #include "cnt_device.hpp"
-#include <cstdio>
+#include "clock.hpp"
+#include "log.hpp"
+#include "stats.hpp"
 
 namespace STM32_Utility {
 
     std::uint32_t CNTDevice::get_count(this CNTDevice const& self) noexcept
     {
-        return self.count = (self.get_current_count() % __HAL_TIM_GET_AUTORELOAD(self.timer));
+        return self.get_current_count() % __HAL_TIM_GET_AUTORELOAD(self.timer);
     }
 
-    std::uint32_t CNTDevice::get_count_difference(this CNTDevice const& self) noexcept
+    std::int32_t CNTDevice::get_count_difference(this CNTDevice& self) noexcept
     {
-        auto const prev_count = self.count;
+        auto const position = self.get_position();
+        auto const difference = position - self.previous_position;
 
-        return self.get_count() - prev_count;
+        self.previous_position = position;
+
+        return static_cast<std::int32_t>(difference);
+    }
+
+    std::int64_t CNTDevice::get_position(this CNTDevice const& self) noexcept
+    {
+        auto count = std::uint32_t{0UL};
+
+        return self.read_position(count);
+    }
+
+    std::int64_t CNTDevice::get_position_at(this CNTDevice const& self, std::uint32_t const count) noexcept
+    {
+        auto current = std::uint32_t{0UL};
+        auto const position = self.read_position(current);
+        auto const period = self.get_period();
+
+        // counts since the latch, wrapped into the half period on either side
+        auto difference = (static_cast<std::int64_t>(current) - static_cast<std::int64_t>(count)) % period;
+        if (difference < 0LL) {
+            difference += period;
+        }
+        if (2LL * difference > period) {
+            difference -= period;
+        }
+
+        return position - difference;
+    }
+
+    CNTSnapshot CNTDevice::get_snapshot(this CNTDevice const& self) noexcept
+    {
+        auto sequence = std::uint32_t{0UL};
+        auto snapshot = CNTSnapshot{};
+
+        do {
+            sequence = self.published;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            snapshot = self.snapshots[sequence & 1UL];
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while (sequence != self.published);
+
+        return snapshot;
     }
 
-    void CNTDevice::initialize(this CNTDevice const& self) noexcept
+    void CNTDevice::sample(this CNTDevice& self, std::uint32_t const timestamp) noexcept
     {
+        auto const position = self.get_position();
+        auto const elapsed = timestamp - self.edge_timestamp;
+        auto const sequence = self.published + 1U;
+        auto velocity = self.snapshots[(sequence - 1UL) & 1UL].velocity;
+
+        if (self.captured) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            auto const capture_position = self.capture_position;
+            auto const capture_cycles = self.capture_cycles;
+
+            // M/T: counts between two latched edges over the cycles between them, after a standstill the
+            // cycle counter may have wrapped meanwhile, so that edge only starts the next measurement
+            if (!self.has_edge || elapsed > STANDSTILL_TIMEOUT) {
+                velocity = 0.0F32;
+            } else if (capture_cycles != self.edge_cycles) {
+                velocity = static_cast<std::float32_t>(HAL_RCC_GetHCLKFreq()) *
+                           static_cast<std::float32_t>(capture_position - self.edge_position) /
+                           static_cast<std::float32_t>(capture_cycles - self.edge_cycles);
+            }
+
+            self.has_edge = true;
+            self.edge_position = capture_position;
+            self.edge_cycles = capture_cycles;
+            self.edge_timestamp = timestamp;
+
+            self.captured = false;
+            self.arm_capture();
+        } else if (!self.has_edge || elapsed > STANDSTILL_TIMEOUT) {
+            velocity = 0.0F32;
+        } else if (auto const cycles = stats_get_cycles() - self.edge_cycles; cycles != 0UL) {
+            // no edge since the last one bounds the speed from above
+            auto const bound = static_cast<std::float32_t>(HAL_RCC_GetHCLKFreq()) * MAX_COUNTS_PER_EDGE /
+                               static_cast<std::float32_t>(cycles);
+            velocity = std::clamp(velocity, -bound, bound);
+        }
+
+        self.snapshots[sequence & 1UL] = CNTSnapshot{.position = position, .velocity = velocity, .timestamp = timestamp};
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.published = sequence;
+    }
+
+    void CNTDevice::update_callback(this CNTDevice& self, TIMHandle const timer) noexcept
+    {
+        if (timer != self.timer) {
+            return;
+        }
+
+        self.base_sequence = self.base_sequence + 1UL;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+
+        self.base = self.base + self.get_wrap();
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.base_sequence = self.base_sequence + 1UL;
+    }
+
+    void CNTDevice::capture_callback(this CNTDevice& self, TIMHandle const timer) noexcept
+    {
+        if (timer != self.timer || timer->Channel != HAL_TIM_ACTIVE_CHANNEL_1) {
+            return;
+        }
+
+        // the encoder's captures latch the count, not the time, so the edge is dated on interrupt entry
+        auto const cycles = stats_get_cycles();
+
+        __HAL_TIM_DISABLE_IT(self.timer, TIM_IT_CC1);
+
+        self.capture_position = self.get_position_at(HAL_TIM_ReadCapturedValue(self.timer, TIM_CHANNEL_1));
+        self.capture_cycles = cycles;
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.captured = true;
+    }
+
+    void CNTDevice::initialize(this CNTDevice& self) noexcept
+    {
+        enable_cycle_counter();
+
+        self.base = 0LL;
+        self.previous_position = 0LL;
+        self.captured = false;
+        self.has_edge = false;
+
+        __HAL_TIM_SET_COUNTER(self.timer, 0UL);
+        __HAL_TIM_CLEAR_FLAG(self.timer, TIM_FLAG_UPDATE);
+        __HAL_TIM_ENABLE_IT(self.timer, TIM_IT_UPDATE);
+        self.arm_capture();
+
         if (HAL_TIM_Encoder_Start(self.timer, TIM_CHANNEL_ALL) != HAL_OK) {
-            std::puts("ENCODER ERROR\n\r");
+            log_fault("ENCODER ERROR");
         }
     }
 
     void CNTDevice::deinitialize(this CNTDevice const& self) noexcept
     {
+        __HAL_TIM_DISABLE_IT(self.timer, TIM_IT_UPDATE | TIM_IT_CC1);
+
         if (HAL_TIM_Encoder_Stop(self.timer, TIM_CHANNEL_ALL) != HAL_OK) {
-            std::puts("ENCODER ERROR\n\r");
+            log_fault("ENCODER ERROR");
         }
     }
 
+    std::int64_t CNTDevice::read_position(this CNTDevice const& self, std::uint32_t& count) noexcept
+    {
+        auto sequence = std::uint32_t{0UL};
+        auto position = 0LL;
+
+        do {
+            sequence = self.base_sequence;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            // a wrap between the first read and the flag leaves the first count on the wrong side of it,
+            // while the second count is read after any wrap the flag shows
+            auto const first_count = self.get_current_count();
+            auto const update_pending = __HAL_TIM_GET_FLAG(self.timer, TIM_FLAG_UPDATE) != RESET;
+            auto const second_count = self.get_current_count();
+
+            count = update_pending ? second_count : first_count;
+            position = self.base + count;
+
+            // counter wrapped but update_callback has not run yet
+            if (update_pending) {
+                position += self.get_wrap();
+            }
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while ((sequence & 1UL) != 0UL || sequence != self.base_sequence);
+
+        return position;
+    }
+
     std::uint32_t CNTDevice::get_current_count(this CNTDevice const& self) noexcept
     {
         return static_cast<std::uint32_t>(__HAL_TIM_GET_COUNTER(self.timer));
     }
 
+    std::int64_t CNTDevice::get_period(this CNTDevice const& self) noexcept
+    {
+        return static_cast<std::int64_t>(__HAL_TIM_GET_AUTORELOAD(self.timer)) + 1LL;
+    }
+
+    std::int64_t CNTDevice::get_wrap(this CNTDevice const& self) noexcept
+    {
+        // DIR follows the latest count, which is the wrapping one unless the encoder reverses within the
+        // interrupt latency, where the count alone would be ambiguous once half a period has gone by
+        return __HAL_TIM_IS_TIM_COUNTING_DOWN(self.timer) ? -self.get_period() : self.get_period();
+    }
+
+    void CNTDevice::arm_capture(this CNTDevice const& self) noexcept
+    {
+        // an edge between clearing and enabling still interrupts, with its own count latched
+        __HAL_TIM_CLEAR_FLAG(self.timer, TIM_FLAG_CC1 | TIM_FLAG_CC1OF);
+        __HAL_TIM_ENABLE_IT(self.timer, TIM_IT_CC1);
+    }
+
 }; // namespace STM32_Utility
\ No newline at end of file
@@ -2,22 +2,78 @@
 #define CNT_DEVICE_HPP
 
 #include "common.hpp"
+#include <atomic>
 
 namespace STM32_Utility {
 
+    struct CNTSnapshot {
+        std::int64_t position = 0LL;
+        std::float32_t velocity = 0.0F32;
+        std::uint32_t timestamp = 0UL;
+    };
+
     struct CNTDevice {
     public:
         std::uint32_t get_count(this CNTDevice const& self) noexcept;
-        std::uint32_t get_count_difference(this CNTDevice const& self) noexcept;
+        std::int32_t get_count_difference(this CNTDevice& self) noexcept;
+
+        std::int64_t get_position(this CNTDevice const& self) noexcept;
+
+        // position when the counter held count, e.g. latched by an input capture less than half a period ago
+        std::int64_t get_position_at(this CNTDevice const& self, std::uint32_t const count) noexcept;
+
+        // latest snapshot, copied again only when a newer one was published meanwhile
+        CNTSnapshot get_snapshot(this CNTDevice const& self) noexcept;
 
-        void initialize(this CNTDevice const& self) noexcept;
+        // call periodically from one context, timestamp in microseconds, readers may preempt it
+        void sample(this CNTDevice& self, std::uint32_t const timestamp) noexcept;
+
+        // call from HAL_TIM_PeriodElapsedCallback, at a higher priority than any reader
+        void update_callback(this CNTDevice& self, TIMHandle const timer) noexcept;
+
+        // call from HAL_TIM_IC_CaptureCallback, at the priority of update_callback
+        void capture_callback(this CNTDevice& self, TIMHandle const timer) noexcept;
+
+        // the encoder inputs on channels 1 and 2 must be configured as TI1 and TI2 captures
+        void initialize(this CNTDevice& self) noexcept;
         void deinitialize(this CNTDevice const& self) noexcept;
 
         TIMHandle timer = nullptr;
-        std::uint32_t mutable count = 0UL;
+
+        std::int64_t volatile base = 0LL;
+        std::uint32_t volatile base_sequence = 0UL;
+
+        // sample writes the buffer not published, so no reader ever waits for it to finish
+        std::array<CNTSnapshot, 2UL> snapshots = {};
+        std::uint32_t volatile published = 0UL;
+
+        // first TI1 edge since the capture was armed, the interrupt stays off until sample rearms it
+        std::int64_t volatile capture_position = 0LL;
+        std::uint32_t volatile capture_cycles = 0UL;
+        bool volatile captured = false;
+
+        std::int64_t previous_position = 0LL;
+        std::int64_t edge_position = 0LL;
+        std::uint32_t edge_cycles = 0UL;
+        std::uint32_t edge_timestamp = 0UL;
+        bool has_edge = false;
 
     private:
+        // position together with the counter value it was computed from
+        std::int64_t read_position(this CNTDevice const& self, std::uint32_t& count) noexcept;
+
         std::uint32_t get_current_count(this CNTDevice const& self) noexcept;
+        std::int64_t get_period(this CNTDevice const& self) noexcept;
+
+        // period added to the base by the wrap the update flag reports
+        std::int64_t get_wrap(this CNTDevice const& self) noexcept;
+
+        void arm_capture(this CNTDevice const& self) noexcept;
+
+        static constexpr std::uint32_t STANDSTILL_TIMEOUT = 100000UL;
+
+        // TI1 rising edges come every 4 counts in TI12 mode and every 2 in the others
+        static constexpr std::float32_t MAX_COUNTS_PER_EDGE = 4.0F32;
     };
 
 }; // namespace STM32_Utility
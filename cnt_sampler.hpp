@@ -0,0 +1,191 @@
+#ifndef CNT_SAMPLER_HPP
+#define CNT_SAMPLER_HPP
+
+#include "clock.hpp"
+#include "cnt_device.hpp"
+#include "common.hpp"
+#include "log.hpp"
+#include "stats.hpp"
+#include <atomic>
+#include <cassert>
+
+namespace STM32_Utility {
+
+    template <std::size_t AXES>
+    struct CNTVector {
+        std::array<std::int64_t, AXES> positions = {};
+        // DWT->CYCCNT at the trigger
+        std::uint32_t timestamp = 0UL;
+        // vectors published so far including this one, 0 - nothing sampled yet
+        std::uint32_t sequence = 0UL;
+    };
+
+    // Latches several encoders at one hardware instant. The trigger timer's update drives its TRGO, which
+    // each encoder timer takes as an internal trigger to capture its counter into CCR3, so all positions
+    // come from the same edge instead of from reads one after another. The trigger's update interrupt
+    // turns the captures into positions and publishes them to a double buffer, so a reader preempting it
+    // still copies the previous vector whole and never waits for the interrupt to finish.
+    template <std::size_t AXES>
+    struct CNTSampler {
+    public:
+        static_assert(AXES > 0UL);
+
+        using Vector = CNTVector<AXES>;
+
+        // latest vector, copied again only when a newer one was published meanwhile
+        Vector get_vector(this CNTSampler const& self) noexcept;
+
+        // after HAL_TIM_Encoder_Init and before the encoders' initialize, the trigger input of a timer
+        // may only change while it does not count
+        void initialize(this CNTSampler& self) noexcept;
+
+        HAL_StatusTypeDef start(this CNTSampler& self) noexcept;
+        void stop(this CNTSampler& self) noexcept;
+
+        // call from HAL_TIM_PeriodElapsedCallback, at a lower priority than the encoders' update_callback
+        void update_callback(this CNTSampler& self, TIMHandle const timer) noexcept;
+
+        // its update rate is the sampling rate
+        TIMHandle trigger = nullptr;
+
+        std::array<CNTDevice*, AXES> encoders = {};
+
+        // TIM_TS_ITRx connecting each encoder timer to the trigger timer, see the internal trigger table
+        std::array<std::uint32_t, AXES> trigger_inputs = {};
+
+        std::array<Vector, 2UL> buffers = {};
+        std::atomic<std::uint32_t> published = 0UL;
+
+        // HCLK cycles per count of the trigger timer, dates the interrupt back to the trigger
+        std::uint32_t cycles_per_count = 1UL;
+
+        // captures overwritten before update_callback read them, each one a lost vector
+        std::uint32_t overruns = 0UL;
+
+    private:
+        // channels 1 and 2 take the encoder inputs
+        static constexpr std::uint32_t CAPTURE_CHANNEL = TIM_CHANNEL_3;
+    };
+
+    template <std::size_t AXES>
+    typename CNTSampler<AXES>::Vector CNTSampler<AXES>::get_vector(this CNTSampler const& self) noexcept
+    {
+        auto sequence = std::uint32_t{0UL};
+        auto vector = Vector{};
+
+        // update_callback only writes the other buffer until it publishes
+        do {
+            sequence = self.published.load(std::memory_order_acquire);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            vector = self.buffers[sequence & 1UL];
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while (sequence != self.published.load(std::memory_order_acquire));
+
+        return vector;
+    }
+
+    template <std::size_t AXES>
+    void CNTSampler<AXES>::initialize(this CNTSampler& self) noexcept
+    {
+        assert(self.trigger);
+
+        for (std::size_t axis = 0UL; axis < AXES; ++axis) {
+            auto const timer = self.encoders[axis]->timer;
+            auto const slave_mode = READ_BIT(timer->Instance->SMCR, TIM_SMCR_SMS);
+
+            assert(READ_BIT(timer->Instance->CR1, TIM_CR1_CEN) == 0UL);
+
+            // TS may only change with the slave mode disabled
+            CLEAR_BIT(timer->Instance->SMCR, TIM_SMCR_SMS);
+            MODIFY_REG(timer->Instance->SMCR, TIM_SMCR_TS, self.trigger_inputs[axis]);
+            SET_BIT(timer->Instance->SMCR, slave_mode);
+
+            auto config = TIM_IC_InitTypeDef{.ICPolarity = TIM_ICPOLARITY_RISING,
+                                             .ICSelection = TIM_ICSELECTION_TRC,
+                                             .ICPrescaler = TIM_ICPSC_DIV1,
+                                             .ICFilter = 0UL};
+            if (HAL_TIM_IC_ConfigChannel(timer, &config, CAPTURE_CHANNEL) != HAL_OK) {
+                log_fault("ENCODER SAMPLER ERROR");
+            }
+        }
+
+        auto config = TIM_MasterConfigTypeDef{.MasterOutputTrigger = TIM_TRGO_UPDATE,
+                                              .MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE};
+        if (HAL_TIMEx_MasterConfigSynchronization(self.trigger, &config) != HAL_OK) {
+            log_fault("ENCODER SAMPLER ERROR");
+        }
+    }
+
+    template <std::size_t AXES>
+    HAL_StatusTypeDef CNTSampler<AXES>::start(this CNTSampler& self) noexcept
+    {
+        enable_cycle_counter();
+
+        self.cycles_per_count = HAL_RCC_GetHCLKFreq() / get_timer_clock_frequency(self.trigger) *
+                                (static_cast<std::uint32_t>(self.trigger->Instance->PSC) + 1UL);
+
+        for (auto const encoder : self.encoders) {
+            __HAL_TIM_CLEAR_FLAG(encoder->timer, TIM_FLAG_CC3 | TIM_FLAG_CC3OF);
+
+            if (auto const result = HAL_TIM_IC_Start(encoder->timer, CAPTURE_CHANNEL); result != HAL_OK) {
+                return result;
+            }
+        }
+
+        __HAL_TIM_SET_COUNTER(self.trigger, 0UL);
+
+        return HAL_TIM_Base_Start_IT(self.trigger);
+    }
+
+    template <std::size_t AXES>
+    void CNTSampler<AXES>::stop(this CNTSampler& self) noexcept
+    {
+        if (HAL_TIM_Base_Stop_IT(self.trigger) != HAL_OK) {
+            log_fault("ENCODER SAMPLER ERROR");
+        }
+
+        for (auto const encoder : self.encoders) {
+            if (HAL_TIM_IC_Stop(encoder->timer, CAPTURE_CHANNEL) != HAL_OK) {
+                log_fault("ENCODER SAMPLER ERROR");
+            }
+        }
+    }
+
+    template <std::size_t AXES>
+    void CNTSampler<AXES>::update_callback(this CNTSampler& self, TIMHandle const timer) noexcept
+    {
+        if (timer != self.trigger) {
+            return;
+        }
+
+        // the trigger timer has counted on since its update, so its counter gives the interrupt latency
+        auto const latency = static_cast<std::uint32_t>(__HAL_TIM_GET_COUNTER(self.trigger)) * self.cycles_per_count;
+        auto const timestamp = stats_get_cycles() - latency;
+
+        auto const sequence = self.published.load(std::memory_order_relaxed) + 1UL;
+        auto& vector = self.buffers[sequence & 1UL];
+
+        for (std::size_t axis = 0UL; axis < AXES; ++axis) {
+            auto const& encoder = *self.encoders[axis];
+
+            if (__HAL_TIM_GET_FLAG(encoder.timer, TIM_FLAG_CC3OF)) {
+                self.overruns += 1UL;
+            }
+            __HAL_TIM_CLEAR_FLAG(encoder.timer, TIM_FLAG_CC3 | TIM_FLAG_CC3OF);
+
+            auto const count = HAL_TIM_ReadCapturedValue(encoder.timer, CAPTURE_CHANNEL);
+            vector.positions[axis] = encoder.get_position_at(count);
+        }
+
+        vector.timestamp = timestamp;
+        vector.sequence = sequence;
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.published.store(sequence, std::memory_order_release);
+    }
+
+}; // namespace STM32_Utility
+
+#endif // CNT_SAMPLER_HPP
\ No newline at end of file
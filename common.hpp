@@ -6,6 +6,7 @@
 #include "stm32f4xx_hal_i2c.h"
 #include "stm32f4xx_hal_spi.h"
 #include "stm32f4xx_hal_tim.h"
+#include "stm32f4xx_hal_uart.h"
 #include "stm32f4xx_hal_usart.h"
 
 #include <algorithm>
@@ -13,6 +14,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <expected>
 #include <stdfloat>
 #include <utility>
 
@@ -21,9 +23,40 @@ namespace STM32_Utility {
     using SPIHandle = SPI_HandleTypeDef*;
     using TIMHandle = TIM_HandleTypeDef*;
     using GPIOHandle = GPIO_TypeDef*;
-    using UARTHandle = USART_HandleTypeDef*;
+    using UARTHandle = UART_HandleTypeDef*;
+    using USARTHandle = USART_HandleTypeDef*;
     using I2CHandle = I2C_HandleTypeDef*;
 
+    // result of a blocking transfer, the HAL status when it failed
+    template <typename T = void>
+    using Expected = std::expected<T, HAL_StatusTypeDef>;
+
+    inline Expected<> to_expected(HAL_StatusTypeDef const result) noexcept
+    {
+        return result == HAL_OK ? Expected<>{} : Expected<>{std::unexpect, result};
+    }
+
+    using TransferCallback = void (*)(void* const context, HAL_StatusTypeDef const status) noexcept;
+
+    struct CriticalSection {
+    public:
+        CriticalSection() noexcept : primask{__get_PRIMASK()}
+        {
+            __disable_irq();
+        }
+
+        ~CriticalSection() noexcept
+        {
+            __set_PRIMASK(this->primask);
+        }
+
+        CriticalSection(CriticalSection const& other) = delete;
+        CriticalSection& operator=(CriticalSection const& other) = delete;
+
+    private:
+        std::uint32_t primask;
+    };
+
 }; // namespace STM32_Utility
 
 #endif // COMMON_HPP
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "coroutine.hpp"
+#include "log.hpp"
+#include <bit>
+
+namespace STM32_Utility {
+
+    namespace {
+
+        struct alignas(std::max_align_t) Frame {
+            std::array<std::byte, COROUTINE_FRAME_SIZE> bytes;
+        };
+
+        std::array<Frame, COROUTINE_FRAMES> frames = {};
+        std::uint32_t frames_used = 0UL;
+
+    }; // namespace
+
+    void* coroutine_allocate(std::size_t const size) noexcept
+    {
+        if (size > COROUTINE_FRAME_SIZE) {
+            log_fault("COROUTINE FRAME SIZE: %u", static_cast<std::uint32_t>(size));
+            return nullptr;
+        }
+
+        auto const critical_section = CriticalSection{};
+
+        auto const index = static_cast<std::size_t>(std::countr_one(frames_used));
+        if (index >= frames.size()) {
+            return nullptr;
+        }
+
+        frames_used |= std::uint32_t{1UL} << index;
+
+        return frames[index].bytes.data();
+    }
+
+    void coroutine_deallocate(void* const frame) noexcept
+    {
+        if (frame == nullptr) {
+            return;
+        }
+
+        auto const index = static_cast<std::size_t>(reinterpret_cast<Frame*>(frame) - frames.data());
+        assert(index < frames.size());
+
+        auto const critical_section = CriticalSection{};
+
+        frames_used &= ~(std::uint32_t{1UL} << index);
+    }
+
+    bool Scheduler::spawn(this Scheduler& self, Task<>&& task) noexcept
+    {
+        auto const handle = task.release();
+        if (!handle) {
+            return false;
+        }
+
+        auto const slot = std::ranges::find(self.tasks, std::coroutine_handle<>{});
+        if (slot == self.tasks.end()) {
+            handle.destroy();
+            return false;
+        }
+
+        handle.promise().scheduler = &self;
+        *slot = handle;
+        self.schedule(handle);
+
+        return true;
+    }
+
+    void Scheduler::schedule(this Scheduler& self, std::coroutine_handle<> const handle) noexcept
+    {
+        // every task waits on one thing at a time, so this only fails for handles scheduled twice
+        if (!self.ready.push(handle)) {
+            log_fault("SCHEDULER QUEUE FULL");
+        }
+    }
+
+    bool Scheduler::sleep(this Scheduler& self,
+                          std::coroutine_handle<> const handle,
+                          std::uint32_t const delay) noexcept
+    {
+        auto const slot = std::ranges::find_if(self.sleepers, [](Sleeper const& sleeper) { return !sleeper.handle; });
+        if (slot == self.sleepers.end()) {
+            return false;
+        }
+
+        *slot = Sleeper{.handle = handle, .start = HAL_GetTick(), .delay = delay};
+
+        return true;
+    }
+
+    bool Scheduler::run_once(this Scheduler& self) noexcept
+    {
+        self.wake_sleepers();
+
+        // coroutines scheduled while resuming wait for the next call, so yielding ones take turns
+        auto const count = self.ready.size();
+        auto resumed = 0UL;
+        while (resumed < count) {
+            auto const handle = self.ready.pop();
+            if (!handle.has_value()) {
+                break;
+            }
+
+            handle->resume();
+            ++resumed;
+        }
+
+        self.reap_tasks();
+
+        return resumed != 0UL;
+    }
+
+    void Scheduler::run(this Scheduler& self) noexcept
+    {
+        while (!self.is_idle()) {
+            if (!self.run_once()) {
+                // an interrupt pending since the check still ends __WFI with PRIMASK set
+                auto const critical_section = CriticalSection{};
+                if (self.ready.is_empty()) {
+                    __WFI();
+                }
+            }
+        }
+    }
+
+    bool Scheduler::is_idle(this Scheduler const& self) noexcept
+    {
+        return std::ranges::all_of(self.tasks, [](std::coroutine_handle<> const task) { return !task; });
+    }
+
+    void Scheduler::wake_sleepers(this Scheduler& self) noexcept
+    {
+        auto const now = HAL_GetTick();
+
+        for (auto& sleeper : self.sleepers) {
+            if (sleeper.handle && now - sleeper.start >= sleeper.delay) {
+                self.schedule(std::exchange(sleeper.handle, {}));
+            }
+        }
+    }
+
+    void Scheduler::reap_tasks(this Scheduler& self) noexcept
+    {
+        for (auto& task : self.tasks) {
+            if (task && task.done()) {
+                std::exchange(task, {}).destroy();
+            }
+        }
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
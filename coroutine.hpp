@@ -0,0 +1,387 @@
+#ifndef COROUTINE_HPP
+#define COROUTINE_HPP
+
+#include "common.hpp"
+#include "ring_buffer.hpp"
+#include <bit>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+// frames of all live coroutines, nested ones included, come from a static pool of
+// STM32_UTILITY_COROUTINE_FRAMES blocks of STM32_UTILITY_COROUTINE_FRAME_SIZE bytes
+#ifndef STM32_UTILITY_COROUTINE_FRAMES
+#define STM32_UTILITY_COROUTINE_FRAMES 8
+#endif
+
+#ifndef STM32_UTILITY_COROUTINE_FRAME_SIZE
+#define STM32_UTILITY_COROUTINE_FRAME_SIZE 256
+#endif
+
+// top-level tasks a Scheduler runs at once
+#ifndef STM32_UTILITY_COROUTINE_TASKS
+#define STM32_UTILITY_COROUTINE_TASKS 4
+#endif
+
+namespace STM32_Utility {
+
+    inline constexpr std::size_t COROUTINE_FRAMES = STM32_UTILITY_COROUTINE_FRAMES;
+    inline constexpr std::size_t COROUTINE_FRAME_SIZE = STM32_UTILITY_COROUTINE_FRAME_SIZE;
+    inline constexpr std::size_t COROUTINE_TASKS = STM32_UTILITY_COROUTINE_TASKS;
+
+    static_assert(COROUTINE_FRAMES <= 32UL);
+    static_assert(COROUTINE_FRAME_SIZE % alignof(std::max_align_t) == 0UL);
+
+    // nullptr when the frame is too large or the pool is exhausted
+    void* coroutine_allocate(std::size_t const size) noexcept;
+    void coroutine_deallocate(void* const frame) noexcept;
+
+    struct Scheduler;
+
+    // results able to tell a task whose frame could not be allocated from one that ran
+    template <typename T>
+    inline constexpr bool is_task_result_v = std::is_void_v<T>;
+
+    template <typename T>
+    inline constexpr bool is_task_result_v<Expected<T>> = true;
+
+    template <typename T>
+    inline constexpr bool is_task_result_v<std::optional<T>> = true;
+
+    struct TaskPromiseBase {
+    public:
+        struct FinalAwaiter {
+        public:
+            bool await_ready(this FinalAwaiter const&) noexcept
+            {
+                return false;
+            }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(this FinalAwaiter const&,
+                                                  std::coroutine_handle<Promise> const handle) noexcept
+            {
+                auto const continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume(this FinalAwaiter const&) noexcept
+            {}
+        };
+
+        std::suspend_always initial_suspend(this TaskPromiseBase const&) noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend(this TaskPromiseBase const&) noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception(this TaskPromiseBase const&) noexcept
+        {
+            std::abort();
+        }
+
+        static void* operator new(std::size_t const size) noexcept
+        {
+            return coroutine_allocate(size);
+        }
+
+        static void operator delete(void* const frame) noexcept
+        {
+            coroutine_deallocate(frame);
+        }
+
+        std::coroutine_handle<> continuation = {};
+        Scheduler* scheduler = nullptr;
+    };
+
+    template <typename T>
+    struct Task;
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+    public:
+        Task<T> get_return_object(this TaskPromise& self) noexcept;
+
+        static Task<T> get_return_object_on_allocation_failure() noexcept;
+
+        void return_value(this TaskPromise& self, T value) noexcept
+        {
+            self.value = std::move(value);
+        }
+
+        T value = {};
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+    public:
+        Task<void> get_return_object(this TaskPromise& self) noexcept;
+
+        static Task<void> get_return_object_on_allocation_failure() noexcept;
+
+        void return_void(this TaskPromise const&) noexcept
+        {}
+    };
+
+    // Lazily started coroutine, run by Scheduler::spawn or by co_await from another task, which then
+    // resumes when it finishes. A task whose frame could not be allocated is empty, spawn refuses it and
+    // co_await gives HAL_ERROR in an Expected result, an Expected<> for Task<>, or nullopt in an optional.
+    template <typename T = void>
+    struct Task {
+    public:
+        static_assert(is_task_result_v<T>, "task result cannot report a failed frame allocation");
+
+        using promise_type = TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+        using Result = std::conditional_t<std::is_void_v<T>, Expected<>, T>;
+
+        struct Awaiter {
+        public:
+            bool await_ready(this Awaiter const& self) noexcept
+            {
+                return !self.handle || self.handle.done();
+            }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(this Awaiter const& self,
+                                                  std::coroutine_handle<Promise> const parent) noexcept
+            {
+                self.handle.promise().continuation = parent;
+                self.handle.promise().scheduler = parent.promise().scheduler;
+                return self.handle;
+            }
+
+            Result await_resume(this Awaiter const& self) noexcept
+            {
+                if (!self.handle) {
+                    if constexpr (std::is_constructible_v<Result, std::nullopt_t>) {
+                        return std::nullopt;
+                    } else {
+                        return std::unexpected{HAL_ERROR};
+                    }
+                }
+
+                if constexpr (std::is_void_v<T>) {
+                    return {};
+                } else {
+                    return std::move(self.handle.promise().value);
+                }
+            }
+
+            Handle handle = {};
+        };
+
+        Task() noexcept = default;
+
+        explicit Task(Handle const task) noexcept : handle{task}
+        {}
+
+        Task(Task&& other) noexcept : handle{std::exchange(other.handle, {})}
+        {}
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other) {
+                if (this->handle) {
+                    this->handle.destroy();
+                }
+                this->handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        ~Task() noexcept
+        {
+            if (this->handle) {
+                this->handle.destroy();
+            }
+        }
+
+        Task(Task const& other) = delete;
+        Task& operator=(Task const& other) = delete;
+
+        Awaiter operator co_await(this Task const& self) noexcept
+        {
+            return Awaiter{self.handle};
+        }
+
+        Handle release(this Task& self) noexcept
+        {
+            return std::exchange(self.handle, {});
+        }
+
+    private:
+        Handle handle = {};
+    };
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object(this TaskPromise& self) noexcept
+    {
+        return Task<T>{Task<T>::Handle::from_promise(self)};
+    }
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object_on_allocation_failure() noexcept
+    {
+        return Task<T>{};
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object(this TaskPromise& self) noexcept
+    {
+        return Task<void>{Task<void>::Handle::from_promise(self)};
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object_on_allocation_failure() noexcept
+    {
+        return Task<void>{};
+    }
+
+    // Run-to-completion scheduler: coroutines resumed by interrupt callbacks are queued and resumed
+    // from run, never from the interrupt itself, and the core sleeps in __WFI while nothing is ready.
+    struct Scheduler {
+    public:
+        struct Sleeper {
+            std::coroutine_handle<> handle = {};
+            std::uint32_t start = 0UL;
+            std::uint32_t delay = 0UL;
+        };
+
+        bool spawn(this Scheduler& self, Task<>&& task) noexcept;
+
+        // safe to call from interrupts
+        void schedule(this Scheduler& self, std::coroutine_handle<> const handle) noexcept;
+
+        bool sleep(this Scheduler& self, std::coroutine_handle<> const handle, std::uint32_t const delay) noexcept;
+
+        // resumes every ready coroutine once, false when none was ready
+        bool run_once(this Scheduler& self) noexcept;
+
+        // returns once every spawned task finished
+        void run(this Scheduler& self) noexcept;
+
+        bool is_idle(this Scheduler const& self) noexcept;
+
+        std::array<std::coroutine_handle<>, COROUTINE_TASKS> tasks = {};
+        std::array<Sleeper, COROUTINE_TASKS> sleepers = {};
+
+        MPSCRingBuffer<std::coroutine_handle<>, std::bit_ceil(COROUTINE_TASKS)> ready = {};
+
+    private:
+        void wake_sleepers(this Scheduler& self) noexcept;
+        void reap_tasks(this Scheduler& self) noexcept;
+    };
+
+    struct YieldAwaiter {
+    public:
+        bool await_ready(this YieldAwaiter const&) noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        void await_suspend(this YieldAwaiter const&, std::coroutine_handle<Promise> const handle) noexcept
+        {
+            assert(handle.promise().scheduler);
+
+            handle.promise().scheduler->schedule(handle);
+        }
+
+        void await_resume(this YieldAwaiter const&) noexcept
+        {}
+    };
+
+    struct DelayAwaiter {
+    public:
+        bool await_ready(this DelayAwaiter const& self) noexcept
+        {
+            return self.delay == 0UL;
+        }
+
+        // resumes right away when every sleeper slot is taken
+        template <typename Promise>
+        bool await_suspend(this DelayAwaiter const& self, std::coroutine_handle<Promise> const handle) noexcept
+        {
+            assert(handle.promise().scheduler);
+
+            return handle.promise().scheduler->sleep(handle, self.delay);
+        }
+
+        void await_resume(this DelayAwaiter const&) noexcept
+        {}
+
+        std::uint32_t delay = 0UL;
+    };
+
+    // Suspends until the transfer started by start(callback, context) completes, start returning false
+    // resumes right away with HAL_BUSY. The callback may run before start returns.
+    template <typename Start>
+    struct TransferAwaiter {
+    public:
+        bool await_ready(this TransferAwaiter const&) noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        bool await_suspend(this TransferAwaiter& self, std::coroutine_handle<Promise> const handle) noexcept
+        {
+            assert(handle.promise().scheduler);
+
+            self.handle = handle;
+            self.scheduler = handle.promise().scheduler;
+
+            if (!self.start(&complete, &self)) {
+                self.status = HAL_BUSY;
+                return false;
+            }
+
+            return true;
+        }
+
+        Expected<> await_resume(this TransferAwaiter const& self) noexcept
+        {
+            return to_expected(self.status);
+        }
+
+        Start start;
+
+        std::coroutine_handle<> handle = {};
+        Scheduler* scheduler = nullptr;
+        HAL_StatusTypeDef volatile status = HAL_OK;
+
+    private:
+        static void complete(void* const context, HAL_StatusTypeDef const result) noexcept
+        {
+            auto& self = *static_cast<TransferAwaiter*>(context);
+
+            self.status = result;
+            self.scheduler->schedule(self.handle);
+        }
+    };
+
+    inline YieldAwaiter async_yield() noexcept
+    {
+        return YieldAwaiter{};
+    }
+
+    // milliseconds of HAL_GetTick
+    inline DelayAwaiter async_delay(std::uint32_t const delay) noexcept
+    {
+        return DelayAwaiter{.delay = delay};
+    }
+
+    template <typename Start>
+    inline TransferAwaiter<Start> async_transfer(Start&& start) noexcept
+    {
+        return TransferAwaiter<Start>{.start = std::forward<Start>(start)};
+    }
+
+}; // namespace STM32_Utility
+
+#endif // COROUTINE_HPP
\ No newline at end of file
@@ -5,18 +5,16 @@ namespace STM32_Utility {
 
     namespace {
 
-        constexpr auto GPIO_PORTS = std::array{GPIOA, GPIOB, GPIOC};
-
         GPIO_TypeDef* pin_to_port(GPIO const pin) noexcept
         {
-            auto const index = std::to_underlying(pin) / 16U;
+            auto const base = gpio_pin_to_port_base(pin);
 
-            return index < GPIO_PORTS.size() ? GPIO_PORTS[index] : nullptr;
+            return base != 0UL ? reinterpret_cast<GPIO_TypeDef*>(base) : nullptr;
         }
 
         std::uint16_t pin_to_mask(GPIO const pin) noexcept
         {
-            return 1U << (std::to_underlying(pin) % 16U);
+            return gpio_pin_to_mask(pin);
         }
 
     }; // namespace
@@ -144,6 +144,59 @@ namespace STM32_Utility {
         PH15,
     };
 
+    inline constexpr auto GPIO_PORT_BASES = std::array<std::uintptr_t, 8UL>{
+        GPIOA_BASE,
+        GPIOB_BASE,
+        GPIOC_BASE,
+#ifdef GPIOD_BASE
+        GPIOD_BASE,
+#else
+        0UL,
+#endif
+#ifdef GPIOE_BASE
+        GPIOE_BASE,
+#else
+        0UL,
+#endif
+#ifdef GPIOF_BASE
+        GPIOF_BASE,
+#else
+        0UL,
+#endif
+#ifdef GPIOG_BASE
+        GPIOG_BASE,
+#else
+        0UL,
+#endif
+#ifdef GPIOH_BASE
+        GPIOH_BASE,
+#else
+        0UL,
+#endif
+    };
+
+    inline constexpr std::size_t gpio_pin_to_port_index(GPIO const pin) noexcept
+    {
+        return static_cast<std::size_t>(std::to_underlying(pin)) / 16UL;
+    }
+
+    inline constexpr std::uintptr_t gpio_pin_to_port_base(GPIO const pin) noexcept
+    {
+        return pin != GPIO::NC && gpio_pin_to_port_index(pin) < GPIO_PORT_BASES.size()
+                   ? GPIO_PORT_BASES[gpio_pin_to_port_index(pin)]
+                   : 0UL;
+    }
+
+    inline constexpr std::uint32_t gpio_pin_to_index(GPIO const pin) noexcept
+    {
+        return static_cast<std::uint32_t>(std::to_underlying(pin)) % 16UL;
+    }
+
+    inline constexpr std::uint16_t gpio_pin_to_mask(GPIO const pin) noexcept
+    {
+        return pin != GPIO::NC ? static_cast<std::uint16_t>(1U << gpio_pin_to_index(pin)) : 0U;
+    }
+
     GPIO_PinState gpio_read_pin(GPIO const pin) noexcept;
 
     void gpio_write_pin(GPIO const pin, GPIO_PinState const gpio_state) noexcept;
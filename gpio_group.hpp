@@ -0,0 +1,169 @@
+#ifndef GPIO_GROUP_HPP
+#define GPIO_GROUP_HPP
+
+#include "common.hpp"
+#include "gpio.hpp"
+
+namespace STM32_Utility {
+
+    template <GPIO... PINS>
+    struct GPIOGroup {
+    public:
+        static_assert(sizeof...(PINS) > 0UL && sizeof...(PINS) <= 32UL);
+        static_assert(((PINS != GPIO::NC) && ...));
+        static_assert(((gpio_pin_to_port_base(PINS) != 0UL) && ...), "GPIO port not available on this device");
+        static_assert(
+            [] {
+                auto const pins = std::array<GPIO, sizeof...(PINS)>{PINS...};
+                for (std::size_t index = 0UL; index < pins.size(); ++index) {
+                    for (std::size_t other = index + 1UL; other < pins.size(); ++other) {
+                        if (pins[index] == pins[other]) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }(),
+            "GPIO pin listed twice");
+
+        static void write(std::uint32_t const value) noexcept
+        {
+            [value]<std::size_t... PORTS>(std::index_sequence<PORTS...>) {
+                (write_port<PORTS>(value), ...);
+            }(std::make_index_sequence<GPIO_PORT_BASES.size()>{});
+        }
+
+        static std::uint32_t read() noexcept
+        {
+            return []<std::size_t... PORTS>(std::index_sequence<PORTS...>) {
+                return (read_port<PORTS>() | ...);
+            }(std::make_index_sequence<GPIO_PORT_BASES.size()>{});
+        }
+
+        static void set() noexcept
+        {
+            write(VALUE_MASK);
+        }
+
+        static void reset() noexcept
+        {
+            write(0U);
+        }
+
+        static constexpr std::size_t SIZE = sizeof...(PINS);
+        static constexpr std::uint32_t VALUE_MASK = SIZE == 32UL ? 0xFFFFFFFFU : (1U << SIZE) - 1U;
+
+    private:
+        static constexpr auto PIN_ARRAY = std::array<GPIO, SIZE>{PINS...};
+
+        static constexpr bool is_on_port(std::size_t const index, std::size_t const port) noexcept
+        {
+            return gpio_pin_to_port_index(PIN_ARRAY[index]) == port;
+        }
+
+        static constexpr std::uint32_t port_mask(std::size_t const port) noexcept
+        {
+            auto mask = std::uint32_t{0U};
+            for (std::size_t index = 0UL; index < SIZE; ++index) {
+                if (is_on_port(index, port)) {
+                    mask |= gpio_pin_to_mask(PIN_ARRAY[index]);
+                }
+            }
+            return mask;
+        }
+
+        // pins of the port occupy consecutive value bits mapped to consecutive port bits
+        static constexpr bool is_contiguous(std::size_t const port) noexcept
+        {
+            auto first = SIZE;
+            auto last = SIZE;
+            for (std::size_t index = 0UL; index < SIZE; ++index) {
+                if (is_on_port(index, port)) {
+                    if (first == SIZE) {
+                        first = index;
+                    } else if (last + 1UL != index ||
+                               gpio_pin_to_index(PIN_ARRAY[index]) != gpio_pin_to_index(PIN_ARRAY[last]) + 1UL) {
+                        return false;
+                    }
+                    last = index;
+                }
+            }
+            return first != SIZE;
+        }
+
+        static constexpr std::size_t first_index(std::size_t const port) noexcept
+        {
+            for (std::size_t index = 0UL; index < SIZE; ++index) {
+                if (is_on_port(index, port)) {
+                    return index;
+                }
+            }
+            return SIZE;
+        }
+
+        template <std::size_t PORT>
+        static std::uint32_t value_to_port_bits(std::uint32_t const value) noexcept
+        {
+            if constexpr (is_contiguous(PORT)) {
+                constexpr auto FIRST = first_index(PORT);
+                constexpr auto FIRST_BIT = gpio_pin_to_index(PIN_ARRAY[FIRST]);
+
+                return ((value >> FIRST) << FIRST_BIT) & port_mask(PORT);
+            } else {
+                return [value]<std::size_t... INDICES>(std::index_sequence<INDICES...>) {
+                    return ((is_on_port(INDICES, PORT)
+                                 ? ((value >> INDICES) & 1U) << gpio_pin_to_index(PIN_ARRAY[INDICES])
+                                 : 0U) |
+                            ...);
+                }(std::make_index_sequence<SIZE>{});
+            }
+        }
+
+        template <std::size_t PORT>
+        static std::uint32_t port_bits_to_value(std::uint32_t const port_bits) noexcept
+        {
+            if constexpr (is_contiguous(PORT)) {
+                constexpr auto FIRST = first_index(PORT);
+                constexpr auto FIRST_BIT = gpio_pin_to_index(PIN_ARRAY[FIRST]);
+
+                return ((port_bits & port_mask(PORT)) >> FIRST_BIT) << FIRST;
+            } else {
+                return [port_bits]<std::size_t... INDICES>(std::index_sequence<INDICES...>) {
+                    return ((is_on_port(INDICES, PORT)
+                                 ? ((port_bits >> gpio_pin_to_index(PIN_ARRAY[INDICES])) & 1U) << INDICES
+                                 : 0U) |
+                            ...);
+                }(std::make_index_sequence<SIZE>{});
+            }
+        }
+
+        template <std::size_t PORT>
+        static void write_port(std::uint32_t const value) noexcept
+        {
+            if constexpr (constexpr auto MASK = port_mask(PORT); MASK != 0UL) {
+                auto const set_bits = value_to_port_bits<PORT>(value);
+
+                port<PORT>()->BSRR = set_bits | ((~set_bits & MASK) << 16U);
+            }
+        }
+
+        template <std::size_t PORT>
+        static std::uint32_t read_port() noexcept
+        {
+            if constexpr (port_mask(PORT) != 0UL) {
+                return port_bits_to_value<PORT>(port<PORT>()->IDR);
+            } else {
+                return 0U;
+            }
+        }
+
+        template <std::size_t PORT>
+        static GPIO_TypeDef* port() noexcept
+        {
+            return reinterpret_cast<GPIO_TypeDef*>(GPIO_PORT_BASES[PORT]);
+        }
+    };
+
+}; // namespace STM32_Utility
+
+#endif // GPIO_GROUP_HPP
\ No newline at end of file
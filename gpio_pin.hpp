@@ -0,0 +1,55 @@
+#ifndef GPIO_PIN_HPP
+#define GPIO_PIN_HPP
+
+#include "common.hpp"
+#include "gpio.hpp"
+
+namespace STM32_Utility {
+
+    template <GPIO PIN>
+    struct GPIOPin {
+    public:
+        static_assert(PIN != GPIO::NC);
+        static_assert(gpio_pin_to_port_base(PIN) != 0UL, "GPIO port not available on this device");
+
+        static GPIO_PinState read() noexcept
+        {
+            return (port()->IDR & MASK) != 0UL ? GPIO_PIN_SET : GPIO_PIN_RESET;
+        }
+
+        static void write(GPIO_PinState const gpio_state) noexcept
+        {
+            port()->BSRR = gpio_state == GPIO_PIN_SET ? SET_MASK : RESET_MASK;
+        }
+
+        static void toggle() noexcept
+        {
+            auto const odr = port()->ODR;
+            port()->BSRR = (odr & MASK) != 0UL ? RESET_MASK : SET_MASK;
+        }
+
+        static void set() noexcept
+        {
+            port()->BSRR = SET_MASK;
+        }
+
+        static void reset() noexcept
+        {
+            port()->BSRR = RESET_MASK;
+        }
+
+        static constexpr std::uintptr_t PORT_BASE = gpio_pin_to_port_base(PIN);
+        static constexpr std::uint32_t MASK = gpio_pin_to_mask(PIN);
+        static constexpr std::uint32_t SET_MASK = MASK;
+        static constexpr std::uint32_t RESET_MASK = MASK << 16U;
+
+    private:
+        static GPIO_TypeDef* port() noexcept
+        {
+            return reinterpret_cast<GPIO_TypeDef*>(PORT_BASE);
+        }
+    };
+
+}; // namespace STM32_Utility
+
+#endif // GPIO_PIN_HPP
\ No newline at end of file
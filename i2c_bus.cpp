@@ -0,0 +1,209 @@
+#include "i2c_bus.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    bool I2CBus::enqueue(this I2CBus& self, I2CTransaction const& transaction) noexcept
+    {
+        assert(transaction.data || transaction.size == 0UL);
+
+        if (transaction.size > MAX_TRANSFER_SIZE) {
+            return false;
+        }
+
+        {
+            auto const critical_section = CriticalSection{};
+
+            if (self.count == self.queue.size()) {
+                return false;
+            }
+
+            self.queue[(self.head + self.count) % self.queue.size()] = transaction;
+            self.count = self.count + 1UL;
+        }
+
+        self.start_next();
+
+        return true;
+    }
+
+    bool I2CBus::enqueue_read(this I2CBus& self,
+                              I2CDevice const& device,
+                              std::uint16_t const address,
+                              std::uint8_t* const data,
+                              std::size_t const size,
+                              TransferCallback const callback,
+                              void* const context) noexcept
+    {
+        return self.enqueue(I2CTransaction{.operation = I2COperation::MEMORY_READ,
+                                           .dev_address = device.dev_address,
+                                           .mem_address = address,
+                                           .mem_address_size = device.mem_address_size,
+                                           .data = data,
+                                           .size = size,
+                                           .callback = callback,
+                                           .context = context});
+    }
+
+    bool I2CBus::enqueue_write(this I2CBus& self,
+                               I2CDevice const& device,
+                               std::uint16_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size,
+                               TransferCallback const callback,
+                               void* const context) noexcept
+    {
+        return self.enqueue(I2CTransaction{.operation = I2COperation::MEMORY_WRITE,
+                                           .dev_address = device.dev_address,
+                                           .mem_address = address,
+                                           .mem_address_size = device.mem_address_size,
+                                           .data = data,
+                                           .size = size,
+                                           .callback = callback,
+                                           .context = context});
+    }
+
+    bool I2CBus::is_busy(this I2CBus const& self) noexcept
+    {
+        return self.count != 0UL;
+    }
+
+    bool I2CBus::is_full(this I2CBus const& self) noexcept
+    {
+        return self.count == self.queue.size();
+    }
+
+    HAL_StatusTypeDef I2CBus::wait(this I2CBus const& self) noexcept
+    {
+        while (self.is_busy()) {
+            // a completion pending since the check still ends __WFI with PRIMASK set
+            auto const critical_section = CriticalSection{};
+            if (self.is_busy()) {
+                __WFI();
+            }
+        }
+
+        return self.status;
+    }
+
+    void I2CBus::transfer_complete_callback(this I2CBus& self, I2CHandle const i2c_bus) noexcept
+    {
+        if (i2c_bus == self.i2c_bus && self.running) {
+            self.finish(HAL_OK);
+        }
+    }
+
+    void I2CBus::transfer_error_callback(this I2CBus& self, I2CHandle const i2c_bus) noexcept
+    {
+        if (i2c_bus == self.i2c_bus && self.running) {
+            self.finish(HAL_ERROR);
+        }
+    }
+
+    HAL_StatusTypeDef I2CBus::start(this I2CBus& self) noexcept
+    {
+        auto const& transaction = self.queue[self.head];
+        auto const dev_address = static_cast<std::uint16_t>(transaction.dev_address << 1U);
+        auto const size = static_cast<std::uint16_t>(transaction.size);
+
+        switch (transaction.operation) {
+            case I2COperation::MEMORY_READ:
+                return self.use_dma ? HAL_I2C_Mem_Read_DMA(self.i2c_bus,
+                                                           dev_address,
+                                                           transaction.mem_address,
+                                                           transaction.mem_address_size,
+                                                           transaction.data,
+                                                           size)
+                                    : HAL_I2C_Mem_Read_IT(self.i2c_bus,
+                                                          dev_address,
+                                                          transaction.mem_address,
+                                                          transaction.mem_address_size,
+                                                          transaction.data,
+                                                          size);
+            case I2COperation::MEMORY_WRITE:
+                return self.use_dma ? HAL_I2C_Mem_Write_DMA(self.i2c_bus,
+                                                            dev_address,
+                                                            transaction.mem_address,
+                                                            transaction.mem_address_size,
+                                                            transaction.data,
+                                                            size)
+                                    : HAL_I2C_Mem_Write_IT(self.i2c_bus,
+                                                           dev_address,
+                                                           transaction.mem_address,
+                                                           transaction.mem_address_size,
+                                                           transaction.data,
+                                                           size);
+            case I2COperation::TRANSMIT:
+                return self.use_dma ? HAL_I2C_Master_Transmit_DMA(self.i2c_bus, dev_address, transaction.data, size)
+                                    : HAL_I2C_Master_Transmit_IT(self.i2c_bus, dev_address, transaction.data, size);
+            case I2COperation::RECEIVE:
+                return self.use_dma ? HAL_I2C_Master_Receive_DMA(self.i2c_bus, dev_address, transaction.data, size)
+                                    : HAL_I2C_Master_Receive_IT(self.i2c_bus, dev_address, transaction.data, size);
+            default:
+                return HAL_ERROR;
+        }
+    }
+
+    void I2CBus::start_next(this I2CBus& self) noexcept
+    {
+        // a transaction failing to start is reported with interrupts enabled, its callback may enqueue again
+        while (true) {
+            auto failed = I2CTransaction{};
+            auto result = HAL_OK;
+            {
+                auto const critical_section = CriticalSection{};
+
+                if (self.count == 0UL || self.running) {
+                    return;
+                }
+                if (result = self.start(); result == HAL_OK) {
+                    self.running = true;
+                    return;
+                }
+                failed = self.pop();
+                self.status = result;
+                if (failed.error_code) {
+                    *failed.error_code = HAL_I2C_GetError(self.i2c_bus);
+                }
+            }
+
+            if (failed.callback) {
+                failed.callback(failed.context, result);
+            }
+        }
+    }
+
+    void I2CBus::finish(this I2CBus& self, HAL_StatusTypeDef const result) noexcept
+    {
+        auto finished = I2CTransaction{};
+        {
+            auto const critical_section = CriticalSection{};
+
+            finished = self.pop();
+            self.running = false;
+            self.status = result;
+            if (finished.error_code) {
+                *finished.error_code = HAL_I2C_GetError(self.i2c_bus);
+            }
+        }
+
+        self.start_next();
+
+        if (finished.callback) {
+            finished.callback(finished.context, result);
+        }
+    }
+
+    I2CTransaction I2CBus::pop(this I2CBus& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        auto const transaction = self.queue[self.head];
+
+        self.head = (self.head + 1UL) % self.queue.size();
+        self.count = self.count - 1UL;
+
+        return transaction;
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
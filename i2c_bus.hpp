@@ -0,0 +1,93 @@
+#ifndef I2C_BUS_HPP
+#define I2C_BUS_HPP
+
+#include "common.hpp"
+#include "i2c_device.hpp"
+
+namespace STM32_Utility {
+
+    enum struct I2COperation : std::uint8_t {
+        MEMORY_READ,
+        MEMORY_WRITE,
+        TRANSMIT,
+        RECEIVE,
+    };
+
+    struct I2CTransaction {
+        I2COperation operation = I2COperation::MEMORY_READ;
+
+        std::uint16_t dev_address = 0U;
+        std::uint16_t mem_address = 0U;
+        std::uint16_t mem_address_size = I2C_MEMADD_SIZE_8BIT;
+
+        std::uint8_t* data = nullptr;
+        std::size_t size = 0UL;
+
+        TransferCallback callback = nullptr;
+        void* context = nullptr;
+
+        // receives HAL_I2C_GetError of the transfer ahead of the callback, before the next transaction
+        // starts and clears it
+        std::uint32_t* error_code = nullptr;
+    };
+
+    struct I2CBus {
+    public:
+        // false when the queue is full or the transaction is longer than the HAL's 16 bit transfer size
+        bool enqueue(this I2CBus& self, I2CTransaction const& transaction) noexcept;
+
+        bool enqueue_read(this I2CBus& self,
+                          I2CDevice const& device,
+                          std::uint16_t const address,
+                          std::uint8_t* const data,
+                          std::size_t const size,
+                          TransferCallback const callback,
+                          void* const context = nullptr) noexcept;
+
+        bool enqueue_write(this I2CBus& self,
+                           I2CDevice const& device,
+                           std::uint16_t const address,
+                           std::uint8_t* const data,
+                           std::size_t const size,
+                           TransferCallback const callback,
+                           void* const context = nullptr) noexcept;
+
+        bool is_busy(this I2CBus const& self) noexcept;
+        bool is_full(this I2CBus const& self) noexcept;
+
+        // sleeps until the queue drains, the status of the last transaction, earlier ones report through
+        // their callbacks
+        HAL_StatusTypeDef wait(this I2CBus const& self) noexcept;
+
+        // call from HAL_I2C_MasterTxCpltCallback, HAL_I2C_MasterRxCpltCallback,
+        // HAL_I2C_MemTxCpltCallback and HAL_I2C_MemRxCpltCallback
+        void transfer_complete_callback(this I2CBus& self, I2CHandle const i2c_bus) noexcept;
+
+        // call from HAL_I2C_ErrorCallback
+        void transfer_error_callback(this I2CBus& self, I2CHandle const i2c_bus) noexcept;
+
+        I2CHandle i2c_bus = nullptr;
+        bool use_dma = false;
+
+        static constexpr std::size_t QUEUE_SIZE = 16UL;
+
+        // XferSize and XferCount of the HAL handle are 16 bit
+        static constexpr std::size_t MAX_TRANSFER_SIZE = 0xFFFFUL;
+
+        std::array<I2CTransaction, QUEUE_SIZE> queue = {};
+        std::uint32_t volatile head = 0UL;
+        std::uint32_t volatile count = 0UL;
+        bool volatile running = false;
+        HAL_StatusTypeDef volatile status = HAL_OK;
+
+    private:
+        HAL_StatusTypeDef start(this I2CBus& self) noexcept;
+        void start_next(this I2CBus& self) noexcept;
+        void finish(this I2CBus& self, HAL_StatusTypeDef const result) noexcept;
+
+        I2CTransaction pop(this I2CBus& self) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // I2C_BUS_HPP
\ No newline at end of file
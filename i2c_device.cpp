@@ -1,78 +1,216 @@
 #include "i2c_device.hpp"
+#include "log.hpp"
+#include "stats.hpp"
 #include <cassert>
-#include <cstdio>
 
 namespace STM32_Utility {
 
-    void
+    Expected<>
     I2CDevice::transmit_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        return self.transmit_bytes(data, size, self.get_timeout(size));
+    }
+
+    Expected<> I2CDevice::transmit_bytes(this I2CDevice const& self,
+                                         std::uint8_t* const data,
+                                         std::size_t const size,
+                                         std::uint32_t const timeout) noexcept
     {
         assert(data);
 
-        HAL_I2C_Master_Transmit(self.i2c_bus, self.dev_address << 1, data, size, TIMEOUT);
+        return self.transfer(TransferOperation::TRANSMIT, size, timeout, [&] {
+            return HAL_I2C_Master_Transmit(self.i2c_bus, self.dev_address << 1, data, size, timeout);
+        });
+    }
+
+    Expected<> I2CDevice::transmit_byte(this I2CDevice const& self, std::uint8_t const data) noexcept
+    {
+        return self.transmit_bytes(std::array<std::uint8_t, 1UL>{data});
     }
 
-    void I2CDevice::transmit_byte(this I2CDevice const& self, std::uint8_t const data) noexcept
+    Expected<>
+    I2CDevice::receive_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
     {
-        self.transmit_bytes(std::array<std::uint8_t, 1UL>{data});
+        return self.receive_bytes(data, size, self.get_timeout(size));
     }
 
-    void I2CDevice::receive_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
+    Expected<> I2CDevice::receive_bytes(this I2CDevice const& self,
+                                        std::uint8_t* const data,
+                                        std::size_t const size,
+                                        std::uint32_t const timeout) noexcept
     {
         assert(data);
 
-        HAL_I2C_Master_Receive(self.i2c_bus, self.dev_address << 1, data, size, TIMEOUT);
+        return self.transfer(TransferOperation::RECEIVE, size, timeout, [&] {
+            return HAL_I2C_Master_Receive(self.i2c_bus, self.dev_address << 1, data, size, timeout);
+        });
     }
 
-    std::uint8_t I2CDevice::receive_byte(this I2CDevice const& self) noexcept
+    Expected<std::uint8_t> I2CDevice::receive_byte(this I2CDevice const& self) noexcept
     {
-        return self.receive_bytes<1UL>()[0];
+        return self.receive_bytes<1UL>().transform([](auto const& data) { return data[0]; });
     }
 
-    void I2CDevice::read_bytes(this I2CDevice const& self,
-                               std::uint8_t const address,
-                               std::uint8_t* const data,
-                               std::size_t const size) noexcept
+    Expected<> I2CDevice::read_bytes(this I2CDevice const& self,
+                                     std::uint16_t const address,
+                                     std::uint8_t* const data,
+                                     std::size_t const size) noexcept
+    {
+        return self.read_bytes(address, data, size, self.get_timeout(size));
+    }
+
+    Expected<> I2CDevice::read_bytes(this I2CDevice const& self,
+                                     std::uint16_t const address,
+                                     std::uint8_t* const data,
+                                     std::size_t const size,
+                                     std::uint32_t const timeout) noexcept
     {
         assert(data);
 
-        HAL_I2C_Mem_Read(self.i2c_bus, self.dev_address << 1, address, sizeof(address), data, size, TIMEOUT);
+        return self.transfer(TransferOperation::READ, size, timeout, [&] {
+            return HAL_I2C_Mem_Read(
+                self.i2c_bus, self.dev_address << 1, address, self.mem_address_size, data, size, timeout);
+        });
     }
 
-    std::uint8_t I2CDevice::read_byte(this I2CDevice const& self, std::uint8_t const address) noexcept
+    Expected<std::uint8_t> I2CDevice::read_byte(this I2CDevice const& self, std::uint16_t const address) noexcept
     {
-        return self.read_bytes<1UL>(address)[0];
+        return self.read_bytes<1UL>(address).transform([](auto const& data) { return data[0]; });
     }
 
-    void I2CDevice::write_bytes(this I2CDevice const& self,
-                                std::uint8_t const address,
-                                std::uint8_t* const data,
-                                std::size_t const size) noexcept
+    Expected<> I2CDevice::write_bytes(this I2CDevice const& self,
+                                      std::uint16_t const address,
+                                      std::uint8_t* const data,
+                                      std::size_t const size) noexcept
+    {
+        return self.write_bytes(address, data, size, self.get_timeout(size));
+    }
+
+    Expected<> I2CDevice::write_bytes(this I2CDevice const& self,
+                                      std::uint16_t const address,
+                                      std::uint8_t* const data,
+                                      std::size_t const size,
+                                      std::uint32_t const timeout) noexcept
     {
         assert(data);
 
-        HAL_I2C_Mem_Write(self.i2c_bus, self.dev_address << 1, address, sizeof(address), data, size, TIMEOUT);
+        return self.transfer(TransferOperation::WRITE, size, timeout, [&] {
+            return HAL_I2C_Mem_Write(
+                self.i2c_bus, self.dev_address << 1, address, self.mem_address_size, data, size, timeout);
+        });
+    }
+
+    Expected<>
+    I2CDevice::write_byte(this I2CDevice const& self, std::uint16_t const address, std::uint8_t const data) noexcept
+    {
+        return self.write_bytes(address, std::array<std::uint8_t, 1UL>{data});
+    }
+
+    Expected<> I2CDevice::transfer_segments(this I2CDevice const& self,
+                                            std::initializer_list<I2CSegment> const segments) noexcept
+    {
+        assert(segments.size() > 0UL);
+
+        auto operation = TransferOperation::WRITE;
+        auto size = 0UL;
+        for (auto const& segment : segments) {
+            assert(segment.data && segment.size > 0UL);
+
+            if (segment.size > MAX_SEGMENT_SIZE) {
+                return std::unexpected{HAL_ERROR};
+            }
+            if (segment.direction == I2CDirection::READ) {
+                operation = TransferOperation::READ;
+            }
+            size += segment.size;
+        }
+
+        auto const timeout = self.get_timeout(size);
+
+        return self.transfer(operation, size, timeout, [&] {
+            return self.run_segments(segments, timeout);
+        });
     }
 
-    void I2CDevice::write_byte(this I2CDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept
+    I2CAddressMap I2CDevice::bus_scan(this I2CDevice const& self) noexcept
     {
-        self.write_bytes(address, std::array<std::uint8_t, 1UL>{data});
+        auto present = I2CAddressMap{};
+
+        if (i2c_is_bus_stuck(self.i2c_bus)) {
+            return present;
+        }
+
+        auto const timeout = i2c_get_timeout(self.i2c_bus, 0UL);
+        for (std::uint8_t i = I2C_FIRST_ADDRESS; i <= I2C_LAST_ADDRESS; ++i) {
+            if (HAL_I2C_IsDeviceReady(self.i2c_bus, i << 1U, SCAN_TRIALS, timeout) == HAL_OK) {
+                present.set(i);
+            }
+        }
+
+        return present;
     }
 
-    void I2CDevice::bus_scan(this I2CDevice const& self) noexcept
+    TransferStatsSnapshot I2CDevice::get_stats(this I2CDevice const& self) noexcept
     {
-        for (std::uint8_t i = 0U; i < (1U << 7U); ++i) {
-            if (HAL_I2C_IsDeviceReady(self.i2c_bus, i << 1U, SCAN_RETRIES, TIMEOUT) == HAL_OK) {
-                std::printf("address: %u\n\r", i);
+        return stats_get_snapshot(self.i2c_bus, self.dev_address);
+    }
+
+    HAL_StatusTypeDef I2CDevice::run_segments(this I2CDevice const& self,
+                                              std::initializer_list<I2CSegment> const segments,
+                                              std::uint32_t const timeout) noexcept
+    {
+        auto const dev_address = static_cast<std::uint16_t>(self.dev_address << 1U);
+        auto const start = HAL_GetTick();
+        auto index = 0UL;
+
+        for (auto const& segment : segments) {
+            auto const first = index == 0UL;
+            auto const last = ++index == segments.size();
+            auto const options = first ? (last ? I2C_FIRST_AND_LAST_FRAME : I2C_FIRST_FRAME)
+                                       : (last ? I2C_LAST_FRAME : I2C_NEXT_FRAME);
+            auto const size = static_cast<std::uint16_t>(segment.size);
+
+            auto const result =
+                segment.direction == I2CDirection::READ
+                    ? HAL_I2C_Master_Seq_Receive_IT(self.i2c_bus, dev_address, segment.data, size, options)
+                    : HAL_I2C_Master_Seq_Transmit_IT(self.i2c_bus, dev_address, segment.data, size, options);
+            if (result != HAL_OK) {
+                // a refused later segment leaves the transfer open without a stop
+                if (!first) {
+                    HAL_I2C_Master_Abort_IT(self.i2c_bus, dev_address);
+                }
+                return result;
+            }
+
+            while (HAL_I2C_GetState(self.i2c_bus) != HAL_I2C_STATE_READY) {
+                if (HAL_GetTick() - start > timeout) {
+                    HAL_I2C_Master_Abort_IT(self.i2c_bus, dev_address);
+                    return HAL_TIMEOUT;
+                }
+            }
+
+            // a NACK ends the transfer with a stop
+            if (HAL_I2C_GetError(self.i2c_bus) != HAL_I2C_ERROR_NONE) {
+                return HAL_ERROR;
             }
         }
+
+        return HAL_OK;
+    }
+
+    std::uint32_t I2CDevice::get_timeout(this I2CDevice const& self, std::size_t const size) noexcept
+    {
+        return self.timeout != 0UL ? self.timeout : i2c_get_timeout(self.i2c_bus, size);
     }
 
     void I2CDevice::initialize(this I2CDevice const& self) noexcept
     {
-        if (HAL_I2C_IsDeviceReady(self.i2c_bus, self.dev_address << 1, SCAN_RETRIES, TIMEOUT) != HAL_OK) {
-            std::puts("I2C ERROR\n\r");
+        auto const result = stats_measure(self.i2c_bus, self.dev_address, TransferOperation::PROBE, 0UL, [&] {
+            return HAL_I2C_IsDeviceReady(self.i2c_bus, self.dev_address << 1, PROBE_TRIALS, self.get_timeout(0UL));
+        });
+        if (result != HAL_OK) {
+            log_fault("I2C ERROR");
         }
     }
 
-}; // namespace STM32_Utility
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -1,107 +1,260 @@
 #ifndef I2C_DEVICE_HPP
 #define I2C_DEVICE_HPP
 
+#include "clock.hpp"
 #include "common.hpp"
+#include "gpio.hpp"
+#include "i2c_recovery.hpp"
+#include "stats.hpp"
+#include <bitset>
+#include <cassert>
+#include <initializer_list>
 
 namespace STM32_Utility {
 
+    // bit n set - a device acknowledged 7-bit address n
+    using I2CAddressMap = std::bitset<128UL>;
+
+    // 0x00 - 0x07 and 0x78 - 0x7F are reserved by the I2C specification
+    inline constexpr std::uint8_t I2C_FIRST_ADDRESS = 0x08U;
+    inline constexpr std::uint8_t I2C_LAST_ADDRESS = 0x77U;
+
+    enum struct I2CDirection : std::uint8_t {
+        WRITE,
+        READ,
+    };
+
+    // One part of a combined transfer. Consecutive segments of one direction continue each other without a
+    // start in between, a change of direction repeats the start, and only the last one ends with a stop.
+    struct I2CSegment {
+        I2CDirection direction = I2CDirection::WRITE;
+        std::uint8_t* data = nullptr;
+        std::size_t size = 0UL;
+    };
+
     struct I2CDevice {
     public:
         template <std::size_t SIZE>
-        void transmit_bytes(this I2CDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> transmit_bytes(this I2CDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
 
-        void transmit_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<>
+        transmit_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        void transmit_byte(this I2CDevice const& self, std::uint8_t const data) noexcept;
+        // the overloads taking a timeout use it in ticks for this call instead of timeout below
+        Expected<> transmit_bytes(this I2CDevice const& self,
+                                  std::uint8_t* const data,
+                                  std::size_t const size,
+                                  std::uint32_t const timeout) noexcept;
+
+        Expected<> transmit_byte(this I2CDevice const& self, std::uint8_t const data) noexcept;
 
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> receive_bytes(this I2CDevice const& self) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> receive_bytes(this I2CDevice const& self) noexcept;
+
+        Expected<> receive_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        void receive_bytes(this I2CDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<> receive_bytes(this I2CDevice const& self,
+                                 std::uint8_t* const data,
+                                 std::size_t const size,
+                                 std::uint32_t const timeout) noexcept;
 
-        std::uint8_t receive_byte(this I2CDevice const& self) noexcept;
+        Expected<std::uint8_t> receive_byte(this I2CDevice const& self) noexcept;
 
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> read_bytes(this I2CDevice const& self, std::uint8_t const address) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> read_bytes(this I2CDevice const& self,
+                                                             std::uint16_t const address) noexcept;
 
-        void read_bytes(this I2CDevice const& self,
-                        std::uint8_t const address,
-                        std::uint8_t* const data,
-                        std::size_t const size) noexcept;
+        Expected<> read_bytes(this I2CDevice const& self,
+                              std::uint16_t const address,
+                              std::uint8_t* const data,
+                              std::size_t const size) noexcept;
 
-        std::uint8_t read_byte(this I2CDevice const& self, std::uint8_t const address) noexcept;
+        Expected<> read_bytes(this I2CDevice const& self,
+                              std::uint16_t const address,
+                              std::uint8_t* const data,
+                              std::size_t const size,
+                              std::uint32_t const timeout) noexcept;
+
+        Expected<std::uint8_t> read_byte(this I2CDevice const& self, std::uint16_t const address) noexcept;
 
         template <std::size_t SIZE>
-        void write_bytes(this I2CDevice const& self,
-                         std::uint8_t const address,
-                         std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> write_bytes(this I2CDevice const& self,
+                               std::uint16_t const address,
+                               std::array<std::uint8_t, SIZE> const& data) noexcept;
+
+        Expected<> write_bytes(this I2CDevice const& self,
+                               std::uint16_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size) noexcept;
+
+        Expected<> write_bytes(this I2CDevice const& self,
+                               std::uint16_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size,
+                               std::uint32_t const timeout) noexcept;
+
+        Expected<>
+        write_byte(this I2CDevice const& self, std::uint16_t const address, std::uint8_t const data) noexcept;
 
-        void write_bytes(this I2CDevice const& self,
-                         std::uint8_t const address,
-                         std::uint8_t* const data,
-                         std::size_t const size) noexcept;
+        // one transfer of all segments through the HAL_I2C_Master_Seq_* primitives, waiting for each,
+        // HAL_ERROR for a segment over MAX_SEGMENT_SIZE
+        Expected<> transfer_segments(this I2CDevice const& self,
+                                     std::initializer_list<I2CSegment> const segments) noexcept;
 
-        void write_byte(this I2CDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept;
+        // blocking probe of every non-reserved address, see I2CScanner for a background scan
+        I2CAddressMap bus_scan(this I2CDevice const& self) noexcept;
 
-        void bus_scan(this I2CDevice const& self) noexcept;
+        TransferStatsSnapshot get_stats(this I2CDevice const& self) noexcept;
 
         void initialize(this I2CDevice const& self) noexcept;
 
+        // XferSize and XferCount of the HAL handle are 16 bit
+        static constexpr std::size_t MAX_SEGMENT_SIZE = 0xFFFFUL;
+
         I2CHandle i2c_bus = nullptr;
         std::uint16_t dev_address = 0U;
 
+        // width of the register or memory address, I2C_MEMADD_SIZE_8BIT or I2C_MEMADD_SIZE_16BIT
+        std::uint16_t mem_address_size = I2C_MEMADD_SIZE_8BIT;
+
+        // HAL timeout in ticks, 0 - sized for each transfer from its length and the bus clock speed
+        std::uint32_t timeout = 0UL;
+        I2CRetryPolicy retry = {};
+
+        // pins for bus recovery, NC - no recovery
+        GPIO scl = GPIO::NC;
+        GPIO sda = GPIO::NC;
+
     private:
-        static constexpr std::uint32_t TIMEOUT{100U};
-        static constexpr std::uint32_t SCAN_RETRIES{10U};
+        // retries failed transfers per the policy, recovering the bus after anything but a NACK
+        template <typename Transfer>
+        Expected<> transfer(this I2CDevice const& self,
+                            TransferOperation const operation,
+                            std::size_t const size,
+                            std::uint32_t const timeout,
+                            Transfer&& hal_transfer) noexcept;
+
+        HAL_StatusTypeDef run_segments(this I2CDevice const& self,
+                                       std::initializer_list<I2CSegment> const segments,
+                                       std::uint32_t const timeout) noexcept;
+
+        std::uint32_t get_timeout(this I2CDevice const& self, std::size_t const size) noexcept;
+
+        static constexpr std::uint32_t PROBE_TRIALS{10U};
+        static constexpr std::uint32_t SCAN_TRIALS{2U};
     };
 
     template <std::size_t SIZE>
-    void I2CDevice::transmit_bytes(this I2CDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept
+    Expected<> I2CDevice::transmit_bytes(this I2CDevice const& self,
+                                         std::array<std::uint8_t, SIZE> const& data) noexcept
     {
-        HAL_I2C_Master_Transmit(self.i2c_bus, self.dev_address << 1, (std::uint8_t*)data.data(), data.size(), TIMEOUT);
+        auto const timeout = self.get_timeout(SIZE);
+
+        return self.transfer(TransferOperation::TRANSMIT, SIZE, timeout, [&] {
+            return HAL_I2C_Master_Transmit(self.i2c_bus,
+                                           self.dev_address << 1,
+                                           const_cast<std::uint8_t*>(data.data()),
+                                           data.size(),
+                                           timeout);
+        });
     }
 
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> I2CDevice::receive_bytes(this I2CDevice const& self) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> I2CDevice::receive_bytes(this I2CDevice const& self) noexcept
     {
+        auto const timeout = self.get_timeout(SIZE);
         auto data = std::array<std::uint8_t, SIZE>{};
 
-        HAL_I2C_Master_Receive(self.i2c_bus, self.dev_address << 1, data.data(), data.size(), TIMEOUT);
-
-        return data;
+        return self
+            .transfer(TransferOperation::RECEIVE,
+                      SIZE,
+                      timeout,
+                      [&] {
+                          return HAL_I2C_Master_Receive(self.i2c_bus,
+                                                        self.dev_address << 1,
+                                                        data.data(),
+                                                        data.size(),
+                                                        timeout);
+                      })
+            .transform([&] { return data; });
     }
 
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> I2CDevice::read_bytes(this I2CDevice const& self,
-                                                         std::uint8_t const address) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> I2CDevice::read_bytes(this I2CDevice const& self,
+                                                                    std::uint16_t const address) noexcept
     {
+        auto const timeout = self.get_timeout(SIZE);
         auto data = std::array<std::uint8_t, SIZE>{};
 
-        HAL_I2C_Mem_Read(self.i2c_bus,
-                         self.dev_address << 1,
-                         address,
-                         sizeof(address),
-                         data.data(),
-                         data.size(),
-                         TIMEOUT);
-
-        return data;
+        return self
+            .transfer(TransferOperation::READ,
+                      SIZE,
+                      timeout,
+                      [&] {
+                          return HAL_I2C_Mem_Read(self.i2c_bus,
+                                                  self.dev_address << 1,
+                                                  address,
+                                                  self.mem_address_size,
+                                                  data.data(),
+                                                  data.size(),
+                                                  timeout);
+                      })
+            .transform([&] { return data; });
     }
 
     template <std::size_t SIZE>
-    void I2CDevice::write_bytes(this I2CDevice const& self,
-                                std::uint8_t const address,
-                                std::array<std::uint8_t, SIZE> const& data) noexcept
+    Expected<> I2CDevice::write_bytes(this I2CDevice const& self,
+                                      std::uint16_t const address,
+                                      std::array<std::uint8_t, SIZE> const& data) noexcept
     {
-        HAL_I2C_Mem_Write(self.i2c_bus,
-                          self.dev_address << 1,
-                          address,
-                          sizeof(address),
-                          (std::uint8_t*)data.data(),
-                          data.size(),
-                          TIMEOUT);
+        auto const timeout = self.get_timeout(SIZE);
+
+        return self.transfer(TransferOperation::WRITE, SIZE, timeout, [&] {
+            return HAL_I2C_Mem_Write(self.i2c_bus,
+                                     self.dev_address << 1,
+                                     address,
+                                     self.mem_address_size,
+                                     const_cast<std::uint8_t*>(data.data()),
+                                     data.size(),
+                                     timeout);
+        });
+    }
+
+    template <typename Transfer>
+    Expected<> I2CDevice::transfer(this I2CDevice const& self,
+                                   TransferOperation const operation,
+                                   std::size_t const size,
+                                   std::uint32_t const timeout,
+                                   Transfer&& hal_transfer) noexcept
+    {
+        assert(self.i2c_bus);
+
+        auto backoff = self.retry.backoff_microseconds;
+
+        for (auto attempt = 1U;; ++attempt) {
+            // the HAL waits 25 ms on a held bus before giving up, fail right away instead
+            auto const result = stats_measure(self.i2c_bus, self.dev_address, operation, size, [&] {
+                return i2c_is_bus_stuck(self.i2c_bus) ? HAL_BUSY : hal_transfer();
+            });
+            if (result == HAL_OK) {
+                return {};
+            }
+
+            // a NACK leaves the bus idle, anything else on an idle peripheral may have wedged it
+            auto const nack = result == HAL_ERROR && stats_is_nack(self.i2c_bus);
+            if (self.i2c_bus->State == HAL_I2C_STATE_READY && !nack) {
+                (void)i2c_recover_bus(self.i2c_bus, self.scl, self.sda);
+            }
+
+            if (attempt >= self.retry.attempts) {
+                return std::unexpected{result};
+            }
+
+            delay_microseconds(backoff);
+            backoff *= 2UL;
+        }
     }
 
 }; // namespace STM32_Utility
 
-#endif // I2C_DEVICE_HPP
+#endif // I2C_DEVICE_HPP
\ No newline at end of file
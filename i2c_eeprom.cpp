@@ -0,0 +1,74 @@
+#include "i2c_eeprom.hpp"
+#include "i2c_recovery.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace STM32_Utility {
+
+    Expected<> I2CEEPROM::read(this I2CEEPROM const& self,
+                               std::uint16_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size) noexcept
+    {
+        if (!self.is_in_range(address, size)) {
+            return std::unexpected{HAL_ERROR};
+        }
+
+        // reads continue across pages
+        return self.device.read_bytes(address, data, size);
+    }
+
+    Expected<> I2CEEPROM::write(this I2CEEPROM const& self,
+                                std::uint16_t const address,
+                                std::uint8_t* const data,
+                                std::size_t const size) noexcept
+    {
+        assert(self.page_size > 0UL);
+
+        if (!self.is_in_range(address, size)) {
+            return std::unexpected{HAL_ERROR};
+        }
+
+        for (auto offset = std::size_t{0UL}; offset < size;) {
+            auto const page_address = static_cast<std::uint16_t>(address + offset);
+            auto const chunk = std::min(size - offset, self.page_size - page_address % self.page_size);
+
+            if (auto const written = self.device.write_bytes(page_address, data + offset, chunk); !written) {
+                return written;
+            }
+            if (auto const ready = self.wait_ready(); !ready) {
+                return ready;
+            }
+
+            offset += chunk;
+        }
+
+        return {};
+    }
+
+    Expected<> I2CEEPROM::wait_ready(this I2CEEPROM const& self) noexcept
+    {
+        auto const start = HAL_GetTick();
+        auto const timeout = i2c_get_timeout(self.device.i2c_bus, 0UL);
+
+        while (HAL_I2C_IsDeviceReady(self.device.i2c_bus, self.device.dev_address << 1, 1U, timeout) != HAL_OK) {
+            if (HAL_GetTick() - start > self.write_timeout) {
+                return std::unexpected{HAL_TIMEOUT};
+            }
+        }
+
+        return {};
+    }
+
+    bool I2CEEPROM::is_in_range(this I2CEEPROM const& self,
+                                std::uint16_t const address,
+                                std::size_t const size) noexcept
+    {
+        // the HAL sends only the low byte of an 8 bit mem_address
+        auto const addressable =
+            self.device.mem_address_size == I2C_MEMADD_SIZE_8BIT ? std::size_t{0x100UL} : std::size_t{0x10000UL};
+
+        return address + size <= std::min(self.memory_size, addressable);
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef I2C_EEPROM_HPP
+#define I2C_EEPROM_HPP
+
+#include "common.hpp"
+#include "i2c_device.hpp"
+
+namespace STM32_Utility {
+
+    // 24Cxx style EEPROM. A page write wraps at the page end instead of continuing on the next page, so
+    // writes are split at page boundaries, and after each page the chip NACKs its address until the write
+    // cycle ends, which is polled for instead of waiting the worst case write time.
+    struct I2CEEPROM {
+    public:
+        Expected<> read(this I2CEEPROM const& self,
+                        std::uint16_t const address,
+                        std::uint8_t* const data,
+                        std::size_t const size) noexcept;
+
+        Expected<> write(this I2CEEPROM const& self,
+                         std::uint16_t const address,
+                         std::uint8_t* const data,
+                         std::size_t const size) noexcept;
+
+        // polls the address until the chip acknowledges, HAL_TIMEOUT after write_timeout
+        Expected<> wait_ready(this I2CEEPROM const& self) noexcept;
+
+        // mem_address_size I2C_MEMADD_SIZE_16BIT for chips above 2 KiB
+        I2CDevice device = {};
+
+        std::size_t page_size = 32UL;
+
+        // bytes of the chip, a transfer running past the end fails with HAL_ERROR instead of wrapping to 0,
+        // as does one past the 256 bytes an 8 bit mem_address reaches
+        std::size_t memory_size = 0x10000UL;
+
+        // longest write cycle in ticks
+        std::uint32_t write_timeout = 5UL;
+
+    private:
+        bool is_in_range(this I2CEEPROM const& self, std::uint16_t const address, std::size_t const size) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // I2C_EEPROM_HPP
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "i2c_recovery.hpp"
+#include "clock.hpp"
+#include "log.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    namespace {
+
+        // 100 kHz, slow enough for any slave
+        constexpr std::uint32_t HALF_PERIOD_MICROSECONDS = 5UL;
+        constexpr std::uint32_t MAX_CLOCK_PULSES = 9UL;
+
+        struct PinMode {
+            std::uint32_t moder = 0UL;
+            std::uint32_t otyper = 0UL;
+        };
+
+        GPIOHandle pin_to_port(GPIO const pin) noexcept
+        {
+            return reinterpret_cast<GPIOHandle>(gpio_pin_to_port_base(pin));
+        }
+
+        PinMode set_open_drain_output(GPIO const pin) noexcept
+        {
+            auto const port = pin_to_port(pin);
+            auto const index = gpio_pin_to_index(pin);
+            auto const mode = PinMode{.moder = port->MODER, .otyper = port->OTYPER};
+            auto const mode_mask = std::uint32_t{3U} << (2U * index);
+            auto const output_mode = std::uint32_t{1U} << (2U * index);
+
+            gpio_set_pin(pin);
+            port->OTYPER = mode.otyper | (std::uint32_t{1U} << index);
+            port->MODER = (mode.moder & ~mode_mask) | output_mode;
+
+            return mode;
+        }
+
+        void restore_mode(GPIO const pin, PinMode const& mode) noexcept
+        {
+            auto const port = pin_to_port(pin);
+            auto const index = gpio_pin_to_index(pin);
+            auto const mode_mask = std::uint32_t{3U} << (2U * index);
+            auto const type_mask = std::uint32_t{1U} << index;
+
+            port->MODER = (port->MODER & ~mode_mask) | (mode.moder & mode_mask);
+            port->OTYPER = (port->OTYPER & ~type_mask) | (mode.otyper & type_mask);
+        }
+
+        void clock_pulse(GPIO const scl) noexcept
+        {
+            gpio_reset_pin(scl);
+            delay_microseconds(HALF_PERIOD_MICROSECONDS);
+            gpio_set_pin(scl);
+            delay_microseconds(HALF_PERIOD_MICROSECONDS);
+        }
+
+        void generate_stop(GPIO const scl, GPIO const sda) noexcept
+        {
+            gpio_reset_pin(scl);
+            gpio_reset_pin(sda);
+            delay_microseconds(HALF_PERIOD_MICROSECONDS);
+            gpio_set_pin(scl);
+            delay_microseconds(HALF_PERIOD_MICROSECONDS);
+            gpio_set_pin(sda);
+            delay_microseconds(HALF_PERIOD_MICROSECONDS);
+        }
+
+    }; // namespace
+
+    std::uint32_t i2c_get_timeout(I2CHandle const i2c_bus, std::size_t const bytes) noexcept
+    {
+        assert(i2c_bus);
+
+        // 9 clocks per byte, address, register address and repeated start address, START and STOP
+        return get_transfer_timeout(9ULL * (bytes + 3ULL) + 2ULL, i2c_bus->Init.ClockSpeed);
+    }
+
+    bool i2c_is_bus_stuck(I2CHandle const i2c_bus) noexcept
+    {
+        assert(i2c_bus);
+
+        return i2c_bus->State == HAL_I2C_STATE_READY && __HAL_I2C_GET_FLAG(i2c_bus, I2C_FLAG_BUSY);
+    }
+
+    Expected<> i2c_recover_bus(I2CHandle const i2c_bus, GPIO const scl, GPIO const sda) noexcept
+    {
+        assert(i2c_bus);
+
+        if (scl == GPIO::NC || sda == GPIO::NC) {
+            return std::unexpected{HAL_ERROR};
+        }
+
+        // releases the pins from the peripheral for the clock-out
+        __HAL_I2C_DISABLE(i2c_bus);
+
+        auto const scl_mode = set_open_drain_output(scl);
+        auto const sda_mode = set_open_drain_output(sda);
+
+        for (auto pulse = 0UL; pulse < MAX_CLOCK_PULSES && gpio_read_pin(sda) == GPIO_PIN_RESET; ++pulse) {
+            clock_pulse(scl);
+        }
+        generate_stop(scl, sda);
+
+        auto const released = gpio_read_pin(sda) == GPIO_PIN_SET;
+
+        restore_mode(sda, sda_mode);
+        restore_mode(scl, scl_mode);
+
+        // clears BUSY latched during the clock-out
+        SET_BIT(i2c_bus->Instance->CR1, I2C_CR1_SWRST);
+        CLEAR_BIT(i2c_bus->Instance->CR1, I2C_CR1_SWRST);
+
+        if (HAL_I2C_Init(i2c_bus) != HAL_OK || !released) {
+            log_fault("I2C RECOVERY ERROR");
+            return std::unexpected{HAL_BUSY};
+        }
+
+        return {};
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef I2C_RECOVERY_HPP
+#define I2C_RECOVERY_HPP
+
+#include "common.hpp"
+#include "gpio.hpp"
+
+namespace STM32_Utility {
+
+    struct I2CRetryPolicy {
+        // 1 - fail on the first error
+        std::uint8_t attempts = 1U;
+        // wait before the second attempt, doubled before each next one
+        std::uint32_t backoff_microseconds = 100UL;
+    };
+
+    // HAL timeout in ticks for a transfer of bytes with a register address at the bus clock speed
+    std::uint32_t i2c_get_timeout(I2CHandle const i2c_bus, std::size_t const bytes) noexcept;
+
+    // BUSY flag set while the peripheral is idle means a slave holds SDA low
+    bool i2c_is_bus_stuck(I2CHandle const i2c_bus) noexcept;
+
+    // clocks SCL until the slave holding SDA lets go, generates STOP on the pins and reinitializes
+    // the peripheral, HAL_ERROR without scl and sda pins, HAL_BUSY when SDA stays low
+    Expected<> i2c_recover_bus(I2CHandle const i2c_bus, GPIO const scl, GPIO const sda) noexcept;
+
+}; // namespace STM32_Utility
+
+#endif // I2C_RECOVERY_HPP
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "i2c_scanner.hpp"
+#include "i2c_recovery.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    bool I2CScanner::start(this I2CScanner& self) noexcept
+    {
+        auto addresses = I2CAddressMap{};
+        for (auto address = I2C_FIRST_ADDRESS; address <= I2C_LAST_ADDRESS; ++address) {
+            addresses.set(address);
+        }
+
+        return self.begin(addresses);
+    }
+
+    void I2CScanner::invalidate(this I2CScanner& self, std::uint8_t const first, std::uint8_t const last) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        for (auto address = std::max(first, I2C_FIRST_ADDRESS); address <= std::min(last, I2C_LAST_ADDRESS);
+             ++address) {
+            self.stale.set(address);
+        }
+    }
+
+    bool I2CScanner::rescan(this I2CScanner& self) noexcept
+    {
+        return self.begin(self.stale);
+    }
+
+    bool I2CScanner::is_busy(this I2CScanner const& self) noexcept
+    {
+        return self.running;
+    }
+
+    I2CAddressMap I2CScanner::get_present(this I2CScanner const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        return self.present;
+    }
+
+    I2CAddressMap I2CScanner::get_changed(this I2CScanner const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        return self.changed;
+    }
+
+    bool I2CScanner::begin(this I2CScanner& self, I2CAddressMap const& addresses) noexcept
+    {
+        assert(self.bus);
+
+        {
+            auto const critical_section = CriticalSection{};
+
+            if (self.running || i2c_is_bus_stuck(self.bus->i2c_bus)) {
+                return false;
+            }
+
+            self.pending = addresses;
+            self.stale &= ~addresses;
+            self.changed.reset();
+            self.address = I2C_FIRST_ADDRESS;
+            self.retried = false;
+            self.running = true;
+        }
+
+        self.probe_next();
+
+        return true;
+    }
+
+    void I2CScanner::probe_next(this I2CScanner& self) noexcept
+    {
+        while (self.address <= I2C_LAST_ADDRESS && !self.pending[self.address]) {
+            self.address = static_cast<std::uint8_t>(self.address + 1U);
+        }
+
+        if (self.address > I2C_LAST_ADDRESS) {
+            self.finish(HAL_OK);
+        } else if (i2c_is_bus_stuck(self.bus->i2c_bus)) {
+            self.finish(HAL_BUSY);
+        } else if (!self.bus->enqueue(I2CTransaction{.operation = I2COperation::TRANSMIT,
+                                                     .dev_address = self.address,
+                                                     .callback = &probe_callback,
+                                                     .context = &self,
+                                                     .error_code = &self.error_code})) {
+            self.finish(HAL_BUSY);
+        }
+    }
+
+    void I2CScanner::probe_done(this I2CScanner& self, HAL_StatusTypeDef const result) noexcept
+    {
+        // anything but HAL_OK or HAL_ERROR means the probe never reached the bus
+        if (result != HAL_OK && result != HAL_ERROR) {
+            self.finish(result);
+            return;
+        }
+
+        // the bus may have started the next transaction already, which clears the HAL's error code
+        auto const nack = (self.error_code & HAL_I2C_ERROR_AF) != 0UL;
+        if (result == HAL_ERROR && !nack && !self.retried) {
+            self.retried = true;
+        } else {
+            auto const acknowledged = result == HAL_OK;
+            if (self.present[self.address] != acknowledged) {
+                self.present.flip(self.address);
+                self.changed.set(self.address);
+            }
+
+            self.pending.reset(self.address);
+            self.address = static_cast<std::uint8_t>(self.address + 1U);
+            self.retried = false;
+        }
+
+        self.probe_next();
+    }
+
+    void I2CScanner::finish(this I2CScanner& self, HAL_StatusTypeDef const result) noexcept
+    {
+        // unprobed addresses are picked up by the next rescan
+        self.stale |= self.pending;
+        self.pending.reset();
+        self.running = false;
+
+        if (self.callback) {
+            self.callback(self.context, result);
+        }
+    }
+
+    void I2CScanner::probe_callback(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        static_cast<I2CScanner*>(context)->probe_done(result);
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
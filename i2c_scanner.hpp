@@ -0,0 +1,62 @@
+#ifndef I2C_SCANNER_HPP
+#define I2C_SCANNER_HPP
+
+#include "common.hpp"
+#include "i2c_bus.hpp"
+#include "i2c_device.hpp"
+
+namespace STM32_Utility {
+
+    // Probes addresses with zero-length writes queued on an I2CBus, one at a time, so the scan runs
+    // from the bus interrupts and interleaves with other transactions. Each address is retried once
+    // unless it NACKs, a held bus ends the scan with HAL_BUSY before the HAL's busy flag wait.
+    struct I2CScanner {
+    public:
+        // probes every non-reserved address
+        bool start(this I2CScanner& self) noexcept;
+
+        // marks first to last for the next rescan, e.g. after a hot-plug event on a connector
+        void invalidate(this I2CScanner& self, std::uint8_t const first, std::uint8_t const last) noexcept;
+
+        // probes only the addresses invalidated since the last scan
+        bool rescan(this I2CScanner& self) noexcept;
+
+        bool is_busy(this I2CScanner const& self) noexcept;
+
+        I2CAddressMap get_present(this I2CScanner const& self) noexcept;
+
+        // addresses that appeared or disappeared during the last scan
+        I2CAddressMap get_changed(this I2CScanner const& self) noexcept;
+
+        I2CBus* bus = nullptr;
+
+        // called from the bus interrupt when a scan ends
+        TransferCallback callback = nullptr;
+        void* context = nullptr;
+
+        I2CAddressMap present = {};
+        I2CAddressMap changed = {};
+        I2CAddressMap pending = {};
+        I2CAddressMap stale = {};
+
+        // HAL_I2C_GetError of the last probe, written by the bus
+        std::uint32_t error_code = HAL_I2C_ERROR_NONE;
+
+        std::uint8_t volatile address = 0U;
+        bool volatile retried = false;
+        bool volatile running = false;
+
+    private:
+        bool begin(this I2CScanner& self, I2CAddressMap const& addresses) noexcept;
+
+        void probe_next(this I2CScanner& self) noexcept;
+        void probe_done(this I2CScanner& self, HAL_StatusTypeDef const result) noexcept;
+
+        void finish(this I2CScanner& self, HAL_StatusTypeDef const result) noexcept;
+
+        static void probe_callback(void* const context, HAL_StatusTypeDef const result) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // I2C_SCANNER_HPP
\ No newline at end of file
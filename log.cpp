@@ -0,0 +1,130 @@
+#include "log.hpp"
+#include "ring_buffer.hpp"
+#include <atomic>
+#include <cstdio>
+
+namespace STM32_Utility {
+
+    namespace {
+
+        constinit MPSCRingBuffer<LogRecord, LOG_BUFFER_SIZE> log_buffer = {};
+        constinit std::atomic<std::uint32_t> log_dropped_records = 0UL;
+
+        void print_argument(char const* const specifier, char const conversion, LogArgument const argument) noexcept
+        {
+            switch (conversion) {
+                case 'd':
+                case 'i':
+                    std::printf(specifier, static_cast<int>(argument.integer));
+                    break;
+                case 'u':
+                case 'x':
+                case 'X':
+                case 'o':
+                case 'c':
+                    std::printf(specifier, static_cast<unsigned>(argument.unsigned_integer));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                    std::printf(specifier, static_cast<double>(argument.floating));
+                    break;
+                case 's':
+                    std::printf(specifier, static_cast<char const*>(argument.pointer));
+                    break;
+                case 'p':
+                    std::printf(specifier, argument.pointer);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void print_record(LogRecord const& record) noexcept
+        {
+            std::printf("[%lu] ", static_cast<unsigned long>(record.timestamp));
+
+            auto argument = 0UL;
+            auto text = record.format;
+
+            while (*text != '\0') {
+                if (*text != '%') {
+                    std::putchar(*text++);
+                    continue;
+                }
+                if (text[1] == '%') {
+                    std::putchar('%');
+                    text += 2;
+                    continue;
+                }
+
+                // copy the conversion specification, skipping length modifiers as all arguments are 32 bit
+                auto specifier = std::array<char, 16UL>{'%'};
+                auto length = 1UL;
+                ++text;
+                while (*text != '\0' && std::strchr("diuxXocfFeEgGsp", *text) == nullptr) {
+                    if (std::strchr("hlLqjzt", *text) == nullptr && length < specifier.size() - 2UL) {
+                        specifier[length++] = *text;
+                    }
+                    ++text;
+                }
+                if (*text == '\0') {
+                    break;
+                }
+
+                specifier[length++] = *text;
+                specifier[length] = '\0';
+
+                if (argument < record.count) {
+                    print_argument(specifier.data(), *text, record.arguments[argument++]);
+                }
+                ++text;
+            }
+
+            std::fputs("\n\r", stdout);
+        }
+
+    }; // namespace
+
+    void log_record(LogLevel const level,
+                    char const* const format,
+                    LogArgument const* const arguments,
+                    std::size_t const count) noexcept
+    {
+        auto record = LogRecord{.format = format,
+                                .timestamp = HAL_GetTick(),
+                                .level = level,
+                                .count = static_cast<std::uint8_t>(std::min(count, LOG_MAX_ARGUMENTS))};
+        std::copy_n(arguments, record.count, record.arguments.begin());
+
+        if (!log_buffer.push(record)) {
+            log_dropped_records.fetch_add(1UL, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t log_drain(std::size_t const max_records) noexcept
+    {
+        auto drained = std::size_t{0UL};
+
+        while (drained < max_records) {
+            auto const record = log_buffer.pop();
+            if (!record.has_value()) {
+                break;
+            }
+
+            print_record(*record);
+            ++drained;
+        }
+
+        return drained;
+    }
+
+    std::uint32_t log_dropped() noexcept
+    {
+        return log_dropped_records.load(std::memory_order_relaxed);
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
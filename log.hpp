@@ -0,0 +1,108 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include "common.hpp"
+#include <type_traits>
+
+// 0 - trace, 1 - info, 2 - warning, 3 - fault, 4 - none
+#ifndef STM32_UTILITY_LOG_LEVEL
+#define STM32_UTILITY_LOG_LEVEL 1
+#endif
+
+namespace STM32_Utility {
+
+    enum struct LogLevel : std::uint8_t {
+        TRACE,
+        INFO,
+        WARNING,
+        FAULT,
+        NONE,
+    };
+
+    inline constexpr auto LOG_LEVEL = static_cast<LogLevel>(STM32_UTILITY_LOG_LEVEL);
+
+    inline constexpr std::size_t LOG_MAX_ARGUMENTS = 4UL;
+    inline constexpr std::size_t LOG_BUFFER_SIZE = 64UL;
+
+    static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1UL)) == 0UL);
+
+    union LogArgument {
+        std::int32_t integer;
+        std::uint32_t unsigned_integer;
+        std::float32_t floating;
+        void const* pointer;
+    };
+
+    struct LogRecord {
+        char const* format = nullptr;
+        std::uint32_t timestamp = 0UL;
+        LogLevel level = LogLevel::NONE;
+        std::uint8_t count = 0U;
+        std::array<LogArgument, LOG_MAX_ARGUMENTS> arguments = {};
+    };
+
+    void log_record(LogLevel const level,
+                    char const* const format,
+                    LogArgument const* const arguments,
+                    std::size_t const count) noexcept;
+
+    // formats and prints pending records, call from the lowest priority context only
+    std::size_t log_drain(std::size_t const max_records = LOG_BUFFER_SIZE) noexcept;
+
+    std::uint32_t log_dropped() noexcept;
+
+    template <typename T>
+    constexpr LogArgument make_log_argument(T const value) noexcept
+    {
+        if constexpr (std::is_floating_point_v<T>) {
+            return LogArgument{.floating = static_cast<std::float32_t>(value)};
+        } else if constexpr (std::is_pointer_v<T>) {
+            return LogArgument{.pointer = static_cast<void const*>(value)};
+        } else if constexpr (std::is_enum_v<T>) {
+            return make_log_argument(std::to_underlying(value));
+        } else if constexpr (std::is_signed_v<T>) {
+            return LogArgument{.integer = static_cast<std::int32_t>(value)};
+        } else {
+            return LogArgument{.unsigned_integer = static_cast<std::uint32_t>(value)};
+        }
+    }
+
+    // format must be a string literal, only its address is recorded
+    template <LogLevel LEVEL, typename... Args>
+    inline void log_message(char const* const format, Args const... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGUMENTS);
+
+        if constexpr (LEVEL >= LOG_LEVEL && LEVEL != LogLevel::NONE) {
+            auto const arguments = std::array<LogArgument, sizeof...(Args)>{make_log_argument(args)...};
+            log_record(LEVEL, format, arguments.data(), arguments.size());
+        }
+    }
+
+    template <typename... Args>
+    inline void log_trace(char const* const format, Args const... args) noexcept
+    {
+        log_message<LogLevel::TRACE>(format, args...);
+    }
+
+    template <typename... Args>
+    inline void log_info(char const* const format, Args const... args) noexcept
+    {
+        log_message<LogLevel::INFO>(format, args...);
+    }
+
+    template <typename... Args>
+    inline void log_warning(char const* const format, Args const... args) noexcept
+    {
+        log_message<LogLevel::WARNING>(format, args...);
+    }
+
+    template <typename... Args>
+    inline void log_fault(char const* const format, Args const... args) noexcept
+    {
+        log_message<LogLevel::FAULT>(format, args...);
+    }
+
+}; // namespace STM32_Utility
+
+#endif // LOG_HPP
\ No newline at end of file
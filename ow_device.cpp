@@ -1,77 +1,411 @@
 #include "ow_device.hpp"
+#include "clock.hpp"
+#include "log.hpp"
 #include <cassert>
 
 namespace STM32_Utility {
 
-    void OWDevice::transmit_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
+    Expected<>
+    OWDevice::transmit_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
     {
         assert(data);
+
+        auto slots = std::array<std::uint8_t, 8UL * FRAME_BYTES>{};
+
+        for (std::size_t offset = 0UL; offset < size; offset += FRAME_BYTES) {
+            auto const frame_size = std::min(FRAME_BYTES, size - offset);
+
+            encode_slots(data + offset, frame_size, slots.data());
+            if (auto const result = self.transfer_slots(slots.data(), 8UL * frame_size); result != HAL_OK) {
+                return std::unexpected{result};
+            }
+        }
+
+        return {};
     }
 
-    void OWDevice::transmit_byte(this OWDevice const& self, std::uint8_t const data) noexcept
+    Expected<> OWDevice::transmit_byte(this OWDevice const& self, std::uint8_t const data) noexcept
     {
-        self.transmit_bytes(std::array<std::uint8_t, 1UL>{data});
+        return self.transmit_bytes(std::array<std::uint8_t, 1UL>{data});
     }
 
-    void OWDevice::receive_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
+    Expected<>
+    OWDevice::receive_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept
     {
         assert(data);
+
+        auto slots = std::array<std::uint8_t, 8UL * FRAME_BYTES>{};
+
+        for (std::size_t offset = 0UL; offset < size; offset += FRAME_BYTES) {
+            auto const frame_size = std::min(FRAME_BYTES, size - offset);
+
+            std::fill_n(slots.data(), 8UL * frame_size, SLOT_HIGH);
+            // the slot buffer is stale after a failed frame
+            if (auto const result = self.transfer_slots(slots.data(), 8UL * frame_size); result != HAL_OK) {
+                return std::unexpected{result};
+            }
+            decode_slots(slots.data(), frame_size, data + offset);
+        }
+
+        return {};
     }
 
-    std::uint8_t OWDevice::receive_byte(this OWDevice const& self) noexcept
+    Expected<std::uint8_t> OWDevice::receive_byte(this OWDevice const& self) noexcept
     {
-        return self.receive_bytes<1UL>()[0];
+        return self.receive_bytes<1UL>().transform([](auto const& data) { return data[0]; });
     }
 
-    void OWDevice::read_bytes(this OWDevice const& self,
-                              std::uint8_t const address,
-                              std::uint8_t* const data,
-                              std::size_t const size) noexcept
+    Expected<> OWDevice::read_bytes(this OWDevice const& self,
+                                    std::uint8_t const address,
+                                    std::uint8_t* const data,
+                                    std::size_t const size) noexcept
     {
         assert(data);
+
+        if (!self.reset()) {
+            return std::unexpected{HAL_ERROR};
+        }
+
+        return self.select()
+            .and_then([&] { return self.transmit_byte(address); })
+            .and_then([&] { return self.receive_bytes(data, size); });
     }
 
-    std::uint8_t OWDevice::read_byte(this OWDevice const& self, std::uint8_t const address) noexcept
+    Expected<std::uint8_t> OWDevice::read_byte(this OWDevice const& self, std::uint8_t const address) noexcept
     {
-        return self.read_bytes<1UL>(address)[0];
+        return self.read_bytes<1UL>(address).transform([](auto const& data) { return data[0]; });
     }
 
-    void OWDevice::write_bytes(this OWDevice const& self,
-                               std::uint8_t const address,
-                               std::uint8_t* const data,
-                               std::size_t const size) noexcept
+    Expected<> OWDevice::write_bytes(this OWDevice const& self,
+                                     std::uint8_t const address,
+                                     std::uint8_t* const data,
+                                     std::size_t const size) noexcept
     {
         assert(data);
+
+        if (!self.reset()) {
+            return std::unexpected{HAL_ERROR};
+        }
+
+        return self.select()
+            .and_then([&] { return self.transmit_byte(address); })
+            .and_then([&] { return self.transmit_bytes(data, size); });
     }
 
-    void OWDevice::write_byte(this OWDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept
+    Expected<>
+    OWDevice::write_byte(this OWDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept
     {
-        self.write_bytes(address, std::array<std::uint8_t, 1UL>{data});
+        return self.write_bytes(address, std::array<std::uint8_t, 1UL>{data});
     }
 
-    std::uint64_t OWDevice::get_counter_microseconds(TIMHandle const timer) noexcept
+    bool OWDevice::reset(this OWDevice const& self) noexcept
     {
-        return 1000ULL * get_counter_miliseconds(timer);
+        auto pulse = RESET_PULSE;
+
+        set_baud_rate(self.uart_bus, RESET_BAUD_RATE);
+        auto const result = self.transfer_slots(&pulse, 1UL);
+        set_baud_rate(self.uart_bus, SLOT_BAUD_RATE);
+
+        return result == HAL_OK && pulse != RESET_PULSE;
+    }
+
+    std::size_t
+    OWDevice::search_rom(this OWDevice const& self, std::uint64_t* const roms, std::size_t const size) noexcept
+    {
+        return self.search(SEARCH_ROM, roms, size);
     }
 
-    std::uint64_t OWDevice::get_counter_miliseconds(TIMHandle const timer) noexcept
+    std::size_t
+    OWDevice::alarm_search(this OWDevice const& self, std::uint64_t* const roms, std::size_t const size) noexcept
     {
-        return 1000ULL * __HAL_TIM_GetCounter(timer) / HAL_GetTickFreq() / __HAL_TIM_GetClockDivision(timer);
+        return self.search(ALARM_SEARCH, roms, size);
     }
 
-    void OWDevice::delay_microseconds(TIMHandle const timer, std::uint64_t const delay) noexcept
+    bool OWDevice::convert_all(this OWDevice const& self) noexcept
     {
-        if (timer) {
-            HAL_TIM_Base_Start(timer);
-            while (get_counter_miliseconds(timer) < delay) {
+        if (!self.start_conversion()) {
+            return false;
+        }
+
+        auto const start = HAL_GetTick();
+        while (!self.is_conversion_done()) {
+            if (HAL_GetTick() - start > CONVERSION_TIMEOUT) {
+                return false;
             }
         }
+
+        return true;
+    }
+
+    bool OWDevice::start_conversion(this OWDevice const& self) noexcept
+    {
+        return self.reset() && self.transmit_bytes(std::array<std::uint8_t, 2UL>{SKIP_ROM, CONVERT_T}).has_value();
+    }
+
+    bool OWDevice::is_conversion_done(this OWDevice const& self) noexcept
+    {
+        return self.receive_bit();
+    }
+
+    std::optional<OWScratchpad> OWDevice::read_scratchpad(this OWDevice const& self, std::uint64_t const rom) noexcept
+    {
+        if (!self.reset()) {
+            return std::nullopt;
+        }
+
+        auto const scratchpad = self.select(rom)
+                                    .and_then([&] { return self.transmit_byte(READ_SCRATCHPAD); })
+                                    .and_then([&] { return self.receive_bytes<std::tuple_size_v<OWScratchpad>>(); });
+        if (!scratchpad || ow_crc8(scratchpad->data(), scratchpad->size()) != 0U) {
+            return std::nullopt;
+        }
+
+        return *scratchpad;
+    }
+
+    void OWDevice::read_scratchpads(this OWDevice const& self,
+                                    std::uint64_t const* const roms,
+                                    std::optional<OWScratchpad>* const scratchpads,
+                                    std::size_t const size) noexcept
+    {
+        assert(roms && scratchpads);
+
+        auto const converted = self.convert_all();
+
+        for (std::size_t index = 0UL; index < size; ++index) {
+            scratchpads[index] = converted ? self.read_scratchpad(roms[index]) : std::nullopt;
+        }
     }
 
     void OWDevice::initialize(this OWDevice const& self) noexcept
-    {}
+    {
+        if (!self.reset()) {
+            log_fault("1-WIRE ERROR");
+        }
+    }
 
     void OWDevice::deinitialize(this OWDevice const& self) noexcept
-    {}
+    {
+        HAL_UART_Abort(self.uart_bus);
+    }
+
+    bool OWDevice::start_slots(this OWDevice& self,
+                               std::uint8_t* const slots,
+                               std::size_t const size,
+                               TransferCallback const callback,
+                               void* const context) noexcept
+    {
+        assert(slots && size <= 8UL * FRAME_BYTES);
+
+        auto const slots_size = static_cast<std::uint16_t>(size);
+
+        self.callback = callback;
+        self.context = context;
+
+        if (HAL_UART_Receive_DMA(self.uart_bus, slots, slots_size) != HAL_OK) {
+            self.callback = nullptr;
+            return false;
+        }
+        if (HAL_UART_Transmit_DMA(self.uart_bus, slots, slots_size) != HAL_OK) {
+            HAL_UART_Abort(self.uart_bus);
+            self.callback = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void OWDevice::transfer_complete_callback(this OWDevice& self, UARTHandle const uart_bus) noexcept
+    {
+        // the blocking transfers complete here as well, without a callback
+        if (uart_bus == self.uart_bus && self.callback) {
+            std::exchange(self.callback, nullptr)(self.context, HAL_OK);
+        }
+    }
+
+    void OWDevice::transfer_error_callback(this OWDevice& self, UARTHandle const uart_bus) noexcept
+    {
+        if (uart_bus == self.uart_bus && self.callback) {
+            HAL_UART_Abort(self.uart_bus);
+            std::exchange(self.callback, nullptr)(self.context, HAL_ERROR);
+        }
+    }
+
+    void
+    OWDevice::encode_slots(std::uint8_t const* const data, std::size_t const size, std::uint8_t* const slots) noexcept
+    {
+        for (std::size_t byte = 0UL; byte < size; ++byte) {
+            for (std::size_t bit = 0UL; bit < 8UL; ++bit) {
+                slots[8UL * byte + bit] = (data[byte] >> bit) & 1U ? SLOT_HIGH : SLOT_LOW;
+            }
+        }
+    }
+
+    void
+    OWDevice::decode_slots(std::uint8_t const* const slots, std::size_t const size, std::uint8_t* const data) noexcept
+    {
+        for (std::size_t byte = 0UL; byte < size; ++byte) {
+            auto value = std::uint8_t{0U};
+            for (std::size_t bit = 0UL; bit < 8UL; ++bit) {
+                if (slots[8UL * byte + bit] == SLOT_HIGH) {
+                    value |= static_cast<std::uint8_t>(1U << bit);
+                }
+            }
+            data[byte] = value;
+        }
+    }
+
+    bool OWDevice::search_branch(std::size_t const bit,
+                                 bool const id_bit,
+                                 bool const complement_bit,
+                                 std::uint64_t const rom,
+                                 std::size_t const last_discrepancy,
+                                 bool& direction,
+                                 std::size_t& last_zero) noexcept
+    {
+        if (id_bit && complement_bit) {
+            return false;
+        } else if (id_bit != complement_bit) {
+            direction = id_bit;
+        } else {
+            direction = bit + 1UL < last_discrepancy ? ((rom >> bit) & 1ULL) != 0ULL : bit + 1UL == last_discrepancy;
+            if (!direction) {
+                last_zero = bit + 1UL;
+            }
+        }
+
+        return true;
+    }
+
+    Expected<> OWDevice::select(this OWDevice const& self) noexcept
+    {
+        return self.select(self.dev_address);
+    }
+
+    Expected<> OWDevice::select(this OWDevice const& self, std::uint64_t const rom) noexcept
+    {
+        if (rom != 0ULL) {
+            auto command = std::array<std::uint8_t, 9UL>{MATCH_ROM};
+            for (std::size_t byte = 0UL; byte < 8UL; ++byte) {
+                command[1UL + byte] = static_cast<std::uint8_t>(rom >> (8UL * byte));
+            }
+            return self.transmit_bytes(command);
+        }
+
+        return self.transmit_byte(SKIP_ROM);
+    }
+
+    bool OWDevice::receive_bit(this OWDevice const& self) noexcept
+    {
+        auto slot = SLOT_HIGH;
+
+        return self.transfer_slots(&slot, 1UL) == HAL_OK && slot == SLOT_HIGH;
+    }
+
+    std::size_t OWDevice::search(this OWDevice const& self,
+                                 std::uint8_t const command,
+                                 std::uint64_t* const roms,
+                                 std::size_t const size) noexcept
+    {
+        assert(roms);
+
+        auto rom = 0ULL;
+        auto last_discrepancy = std::size_t{0UL};
+        auto count = std::size_t{0UL};
+
+        while (count < size && self.search_next(command, rom, last_discrepancy)) {
+            // a ROM failing its CRC still steers the search, the devices past it are found all the same
+            if (ow_rom_is_valid(rom)) {
+                roms[count++] = rom;
+            }
+            if (last_discrepancy == 0UL) {
+                break;
+            }
+        }
+
+        return count;
+    }
+
+    bool OWDevice::search_next(this OWDevice const& self,
+                               std::uint8_t const command,
+                               std::uint64_t& rom,
+                               std::size_t& last_discrepancy) noexcept
+    {
+        if (!self.reset() || !self.transmit_byte(command)) {
+            return false;
+        }
+
+        auto next_rom = 0ULL;
+        auto last_zero = std::size_t{0UL};
+        auto direction = false;
+
+        // the direction slot of the previous bit and both read slots of the current bit share one transfer
+        for (std::size_t bit = 0UL; bit < 64UL; ++bit) {
+            auto slots = std::array<std::uint8_t, 3UL>{direction ? SLOT_HIGH : SLOT_LOW, SLOT_HIGH, SLOT_HIGH};
+            auto const first = bit == 0UL ? 1UL : 0UL;
+
+            if (self.transfer_slots(slots.data() + first, slots.size() - first) != HAL_OK) {
+                return false;
+            }
+
+            if (!search_branch(
+                    bit, slots[1] == SLOT_HIGH, slots[2] == SLOT_HIGH, rom, last_discrepancy, direction, last_zero)) {
+                return false;
+            }
+
+            if (direction) {
+                next_rom |= 1ULL << bit;
+            }
+        }
+
+        auto slot = direction ? SLOT_HIGH : SLOT_LOW;
+        if (self.transfer_slots(&slot, 1UL) != HAL_OK) {
+            return false;
+        }
+
+        rom = next_rom;
+        last_discrepancy = last_zero;
+
+        return true;
+    }
+
+    HAL_StatusTypeDef OWDevice::transfer_slots(this OWDevice const& self,
+                                               std::uint8_t* const slots,
+                                               std::size_t const size) noexcept
+    {
+        assert(slots);
+
+        // every slot is echoed back on the shared line one character after it was loaded for
+        // transmission, so the received slots can safely overwrite the transmitted ones in place
+        auto const slots_size = static_cast<std::uint16_t>(size);
+
+        if (auto const result = HAL_UART_Receive_DMA(self.uart_bus, slots, slots_size); result != HAL_OK) {
+            return result;
+        }
+        if (auto const result = HAL_UART_Transmit_DMA(self.uart_bus, slots, slots_size); result != HAL_OK) {
+            HAL_UART_Abort(self.uart_bus);
+            return result;
+        }
+
+        auto const start = HAL_GetTick();
+        while (HAL_UART_GetState(self.uart_bus) != HAL_UART_STATE_READY) {
+            if (HAL_GetTick() - start > TIMEOUT) {
+                HAL_UART_Abort(self.uart_bus);
+                return HAL_TIMEOUT;
+            }
+        }
+
+        return HAL_OK;
+    }
+
+    void OWDevice::set_baud_rate(UARTHandle const uart_bus, std::uint32_t const baud_rate) noexcept
+    {
+        auto const clock = get_uart_clock_frequency(uart_bus);
+
+        uart_bus->Init.BaudRate = baud_rate;
+        uart_bus->Instance->BRR = uart_bus->Init.OverSampling == UART_OVERSAMPLING_8
+                                      ? UART_BRR_SAMPLING8(clock, baud_rate)
+                                      : UART_BRR_SAMPLING16(clock, baud_rate);
+    }
 
 }; // namespace STM32_Utility
\ No newline at end of file
@@ -3,91 +3,222 @@
 
 #include "common.hpp"
 #include "gpio.hpp"
+#include <optional>
 
 namespace STM32_Utility {
 
+    inline constexpr auto OW_CRC8_TABLE = [] {
+        auto table = std::array<std::uint8_t, 256UL>{};
+
+        for (std::size_t index = 0UL; index < table.size(); ++index) {
+            auto crc = static_cast<std::uint8_t>(index);
+            for (std::size_t bit = 0UL; bit < 8UL; ++bit) {
+                crc = static_cast<std::uint8_t>((crc & 1U) ? (crc >> 1U) ^ 0x8CU : crc >> 1U);
+            }
+            table[index] = crc;
+        }
+
+        return table;
+    }();
+
+    inline constexpr std::uint8_t ow_crc8(std::uint8_t const* const data, std::size_t const size) noexcept
+    {
+        auto crc = std::uint8_t{0U};
+
+        for (std::size_t index = 0UL; index < size; ++index) {
+            crc = OW_CRC8_TABLE[crc ^ data[index]];
+        }
+
+        return crc;
+    }
+
+    inline constexpr bool ow_rom_is_valid(std::uint64_t const rom) noexcept
+    {
+        auto bytes = std::array<std::uint8_t, 8UL>{};
+        for (std::size_t byte = 0UL; byte < bytes.size(); ++byte) {
+            bytes[byte] = static_cast<std::uint8_t>(rom >> (8UL * byte));
+        }
+
+        return rom != 0ULL && ow_crc8(bytes.data(), bytes.size()) == 0U;
+    }
+
+    using OWScratchpad = std::array<std::uint8_t, 9UL>;
+
     struct OWDevice {
     public:
+        // transfers stop at the first failed frame, a missing presence pulse fails with HAL_ERROR
         template <std::size_t SIZE>
-        void transmit_bytes(this OWDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> transmit_bytes(this OWDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
 
-        void transmit_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<> transmit_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        void transmit_byte(this OWDevice const& self, std::uint8_t const data) noexcept;
+        Expected<> transmit_byte(this OWDevice const& self, std::uint8_t const data) noexcept;
 
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> receive_bytes(this OWDevice const& self) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> receive_bytes(this OWDevice const& self) noexcept;
 
-        void receive_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<> receive_bytes(this OWDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        std::uint8_t receive_byte(this OWDevice const& self) noexcept;
+        Expected<std::uint8_t> receive_byte(this OWDevice const& self) noexcept;
 
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> read_bytes(this OWDevice const& self, std::uint8_t const address) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> read_bytes(this OWDevice const& self,
+                                                            std::uint8_t const address) noexcept;
 
-        void read_bytes(this OWDevice const& self,
-                        std::uint8_t const address,
-                        std::uint8_t* const data,
-                        std::size_t const size) noexcept;
+        Expected<> read_bytes(this OWDevice const& self,
+                              std::uint8_t const address,
+                              std::uint8_t* const data,
+                              std::size_t const size) noexcept;
 
-        std::uint8_t read_byte(this OWDevice const& self, std::uint8_t const address) noexcept;
+        Expected<std::uint8_t> read_byte(this OWDevice const& self, std::uint8_t const address) noexcept;
 
         template <std::size_t SIZE>
-        void write_bytes(this OWDevice const& self,
-                         std::uint8_t const address,
-                         std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> write_bytes(this OWDevice const& self,
+                               std::uint8_t const address,
+                               std::array<std::uint8_t, SIZE> const& data) noexcept;
+
+        Expected<> write_bytes(this OWDevice const& self,
+                               std::uint8_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size) noexcept;
+
+        Expected<> write_byte(this OWDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept;
+
+        bool reset(this OWDevice const& self) noexcept;
+
+        // up to size ROMs with a valid CRC, ROMs failing it are skipped, async_search_rom from a scheduler
+        std::size_t search_rom(this OWDevice const& self, std::uint64_t* const roms, std::size_t const size) noexcept;
+        std::size_t alarm_search(this OWDevice const& self, std::uint64_t* const roms, std::size_t const size) noexcept;
+
+        // busy-polls the bus for up to CONVERSION_TIMEOUT ms without yielding, from a scheduler use
+        // async_convert_all or start_conversion and is_conversion_done instead
+        bool convert_all(this OWDevice const& self) noexcept;
+
+        // split convert_all, so the conversion can be polled without blocking
+        bool start_conversion(this OWDevice const& self) noexcept;
+        bool is_conversion_done(this OWDevice const& self) noexcept;
 
-        void write_bytes(this OWDevice const& self,
-                         std::uint8_t const address,
-                         std::uint8_t* const data,
-                         std::size_t const size) noexcept;
+        std::optional<OWScratchpad> read_scratchpad(this OWDevice const& self, std::uint64_t const rom) noexcept;
 
-        void write_byte(this OWDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept;
+        void read_scratchpads(this OWDevice const& self,
+                              std::uint64_t const* const roms,
+                              std::optional<OWScratchpad>* const scratchpads,
+                              std::size_t const size) noexcept;
 
         void initialize(this OWDevice const& self) noexcept;
         void deinitialize(this OWDevice const& self) noexcept;
 
-        TIMHandle timer = nullptr;
+        // The awaitable transfers of async_device.hpp build on these. start_slots runs one frame of slots
+        // on the UART DMA and calls back from transfer_complete_callback, false when it did not start.
+        // The blocking transfers must not run on the device meanwhile.
+        bool start_slots(this OWDevice& self,
+                         std::uint8_t* const slots,
+                         std::size_t const size,
+                         TransferCallback const callback,
+                         void* const context) noexcept;
+
+        // call from HAL_UART_RxCpltCallback
+        void transfer_complete_callback(this OWDevice& self, UARTHandle const uart_bus) noexcept;
+
+        // call from HAL_UART_ErrorCallback
+        void transfer_error_callback(this OWDevice& self, UARTHandle const uart_bus) noexcept;
+
+        // 8 slots per byte, LSB first
+        static void
+        encode_slots(std::uint8_t const* const data, std::size_t const size, std::uint8_t* const slots) noexcept;
+        static void
+        decode_slots(std::uint8_t const* const slots, std::size_t const size, std::uint8_t* const data) noexcept;
+
+        // direction of the ROM search at bit from its two read slots, false when no device answered
+        static bool search_branch(std::size_t const bit,
+                                  bool const id_bit,
+                                  bool const complement_bit,
+                                  std::uint64_t const rom,
+                                  std::size_t const last_discrepancy,
+                                  bool& direction,
+                                  std::size_t& last_zero) noexcept;
+
+        static void set_baud_rate(UARTHandle const uart_bus, std::uint32_t const baud_rate) noexcept;
+
+        static constexpr std::uint32_t CONVERSION_TIMEOUT = 800UL;
+
+        static constexpr std::uint32_t RESET_BAUD_RATE = 9600UL;
+        static constexpr std::uint32_t SLOT_BAUD_RATE = 115200UL;
+
+        static constexpr std::uint8_t RESET_PULSE = 0xF0U;
+        static constexpr std::uint8_t SLOT_HIGH = 0xFFU;
+        static constexpr std::uint8_t SLOT_LOW = 0x00U;
+
+        static constexpr std::uint8_t MATCH_ROM = 0x55U;
+        static constexpr std::uint8_t SKIP_ROM = 0xCCU;
+        static constexpr std::uint8_t SEARCH_ROM = 0xF0U;
+        static constexpr std::uint8_t ALARM_SEARCH = 0xECU;
+        static constexpr std::uint8_t CONVERT_T = 0x44U;
+        static constexpr std::uint8_t READ_SCRATCHPAD = 0xBEU;
+
+        static constexpr std::size_t FRAME_BYTES = 8UL;
+
+        UARTHandle uart_bus = nullptr;
 
         GPIO dev_pin = GPIO::NC;
         std::uint64_t dev_address = 0ULL;
 
+        TransferCallback callback = nullptr;
+        void* context = nullptr;
+
     private:
-        static std::uint64_t get_counter_microseconds(TIMHandle const timer) noexcept;
-        static std::uint64_t get_counter_miliseconds(TIMHandle const timer) noexcept;
+        Expected<> select(this OWDevice const& self) noexcept;
+        Expected<> select(this OWDevice const& self, std::uint64_t const rom) noexcept;
+
+        bool receive_bit(this OWDevice const& self) noexcept;
+
+        std::size_t search(this OWDevice const& self,
+                           std::uint8_t const command,
+                           std::uint64_t* const roms,
+                           std::size_t const size) noexcept;
+
+        bool search_next(this OWDevice const& self,
+                         std::uint8_t const command,
+                         std::uint64_t& rom,
+                         std::size_t& last_discrepancy) noexcept;
 
-        static void delay_microseconds(TIMHandle const timer, std::uint64_t const delay) noexcept;
+        HAL_StatusTypeDef transfer_slots(this OWDevice const& self,
+                                         std::uint8_t* const slots,
+                                         std::size_t const size) noexcept;
 
         static constexpr std::uint32_t TIMEOUT = 100UL;
-        static constexpr std::uint32_t DELAY_80_US = 80UL;
-        static constexpr std::uint32_t DELAY_320_US = 320UL;
     };
 
     template <std::size_t SIZE>
-    void OWDevice::transmit_bytes(this OWDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept
-    {}
+    Expected<> OWDevice::transmit_bytes(this OWDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept
+    {
+        return self.transmit_bytes(const_cast<std::uint8_t*>(data.data()), data.size());
+    }
 
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> OWDevice::receive_bytes(this OWDevice const& self) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> OWDevice::receive_bytes(this OWDevice const& self) noexcept
     {
         auto data = std::array<std::uint8_t, SIZE>{};
 
-        return data;
+        return self.receive_bytes(data.data(), data.size()).transform([&] { return data; });
     }
 
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> OWDevice::read_bytes(this OWDevice const& self, std::uint8_t const address) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> OWDevice::read_bytes(this OWDevice const& self,
+                                                                   std::uint8_t const address) noexcept
     {
         auto data = std::array<std::uint8_t, SIZE>{};
 
-        return data;
+        return self.read_bytes(address, data.data(), data.size()).transform([&] { return data; });
     }
 
     template <std::size_t SIZE>
-    void OWDevice::write_bytes(this OWDevice const& self,
-                               std::uint8_t const address,
-                               std::array<std::uint8_t, SIZE> const& data) noexcept
-    {}
+    Expected<> OWDevice::write_bytes(this OWDevice const& self,
+                                     std::uint8_t const address,
+                                     std::array<std::uint8_t, SIZE> const& data) noexcept
+    {
+        return self.write_bytes(address, const_cast<std::uint8_t*>(data.data()), data.size());
+    }
 
 }; // namespace STM32_Utility
 
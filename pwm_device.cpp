@@ -1,25 +1,9 @@
 #include "pwm_device.hpp"
-#include <cstdio>
+#include "clock.hpp"
+#include "log.hpp"
 
 namespace STM32_Utility {
 
-    void frequency_to_prescaler_counter_period(std::uint32_t const clock_hz,
-                                               std::uint32_t const clock_div,
-                                               std::uint32_t const frequency,
-                                               std::uint32_t& prescaler,
-                                               std::uint32_t& period) noexcept
-    {
-        if (frequency > 0UL) {
-            period = clock_hz / frequency;
-            prescaler = 0UL;
-
-            while (period > 0xFFFF && prescaler < 0xFFFF) {
-                prescaler = prescaler + 1UL;
-                period = clock_hz / ((prescaler + 1UL) * (clock_div + 1UL) * frequency) - 1UL;
-            }
-        }
-    }
-
     std::uint32_t PWMDevice::get_period(this PWMDevice const& self) noexcept
     {
         return __HAL_TIM_GET_AUTORELOAD(self.timer);
@@ -31,8 +15,7 @@ namespace STM32_Utility {
         auto const max_raw = self.get_period();
         auto const clamped_raw = std::clamp(raw, min_raw, max_raw);
 
-        std::printf("DUTY: %.2f\n\r",
-                    100 * static_cast<std::float32_t>(clamped_raw) / static_cast<std::float32_t>(max_raw));
+        log_trace("DUTY: %.2f", 100 * static_cast<std::float32_t>(clamped_raw) / static_cast<std::float32_t>(max_raw));
 
         __HAL_TIM_SET_COMPARE(self.timer, self.channel_mask, clamped_raw);
     }
@@ -42,16 +25,27 @@ namespace STM32_Utility {
         self.set_compare_raw(self.voltage_to_raw(voltage));
     }
 
-    void PWMDevice::set_frequency(this PWMDevice const& self, std::uint32_t const frequency) noexcept
+    PWMTiming PWMDevice::set_frequency(this PWMDevice const& self, std::uint32_t const frequency) noexcept
     {
-        auto period = 0UL;
-        auto prescaler = 0UL;
+        auto const max_period =
+            IS_TIM_32B_COUNTER_INSTANCE(self.timer->Instance) ? PWM_MAX_PERIOD_32BIT : PWM_MAX_PERIOD_16BIT;
+        auto const timing = frequency_to_pwm_timing(get_timer_clock_frequency(self.timer), frequency, max_period);
 
-        frequency_to_prescaler_counter_period(84000000UL, 0UL, frequency, prescaler, period);
-        std::printf("FREQ: %u, PSC: %u, CP: %u\n\r", frequency, prescaler, period);
+        log_trace("FREQ: %u, PSC: %u, CP: %u, ERR: %d ppm",
+                  frequency,
+                  timing.prescaler,
+                  timing.period,
+                  timing.error_ppm);
 
-        self.set_prescaler(prescaler);
-        self.set_period(period);
+        self.set_timing(timing);
+
+        return timing;
+    }
+
+    void PWMDevice::set_timing(this PWMDevice const& self, PWMTiming const& timing) noexcept
+    {
+        self.set_prescaler(timing.prescaler);
+        self.set_period(timing.period);
     }
 
     void PWMDevice::set_prescaler(this PWMDevice const& self, std::uint32_t const prescaler) noexcept
@@ -83,14 +77,14 @@ namespace STM32_Utility {
     void PWMDevice::initialize(this PWMDevice const& self) noexcept
     {
         if (HAL_TIM_PWM_Start(self.timer, self.channel_mask) != HAL_OK) {
-            std::puts("PWM ERROR\n\r");
+            log_fault("PWM ERROR");
         }
     }
 
     void PWMDevice::deinitialize(this PWMDevice const& self) noexcept
     {
         if (HAL_TIM_PWM_Stop(self.timer, self.channel_mask) != HAL_OK) {
-            std::puts("PWM ERROR\n\r");
+            log_fault("PWM ERROR");
         }
     }
 
@@ -2,6 +2,7 @@
 #define PWM_DEVICE_HPP
 
 #include "common.hpp"
+#include "pwm_timing.hpp"
 
 namespace STM32_Utility {
 
@@ -9,7 +10,8 @@ namespace STM32_Utility {
     public:
         std::uint32_t get_period(this PWMDevice const& self) noexcept;
 
-        void set_frequency(this PWMDevice const& self, std::uint32_t const frequency) noexcept;
+        PWMTiming set_frequency(this PWMDevice const& self, std::uint32_t const frequency) noexcept;
+        void set_timing(this PWMDevice const& self, PWMTiming const& timing) noexcept;
         void set_prescaler(this PWMDevice const& self, std::uint32_t const prescaler) noexcept;
         void set_period(this PWMDevice const& self, std::uint32_t const period) noexcept;
 
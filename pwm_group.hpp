@@ -0,0 +1,168 @@
+#ifndef PWM_GROUP_HPP
+#define PWM_GROUP_HPP
+
+#include "common.hpp"
+#include "pwm_device.hpp"
+#include "pwm_timing.hpp"
+
+namespace STM32_Utility {
+
+    // Channels may span several timers, slave timers are expected to be synchronized to the first
+    // channel's timer through its TRGO. Values staged between begin_update and commit reach all
+    // channels of a timer at the same update event, at most one PWM period after commit.
+    template <std::size_t SIZE>
+    struct PWMGroup {
+    public:
+        void begin_update(this PWMGroup const& self) noexcept;
+
+        void set_compare_raw(this PWMGroup const& self, std::size_t const index, std::uint32_t const raw) noexcept;
+        void set_compare_raw(this PWMGroup const& self, std::array<std::uint32_t, SIZE> const& raws) noexcept;
+
+        void set_timing(this PWMGroup const& self, PWMTiming const& timing) noexcept;
+
+        void commit(this PWMGroup const& self) noexcept;
+        void commit_immediately(this PWMGroup const& self) noexcept;
+
+        void start(this PWMGroup const& self) noexcept;
+        void stop(this PWMGroup const& self) noexcept;
+
+        void initialize(this PWMGroup const& self) noexcept;
+        void deinitialize(this PWMGroup const& self) noexcept;
+
+        std::array<PWMDevice, SIZE> channels = {};
+
+    private:
+        template <typename Function>
+        void for_each_timer(this PWMGroup const& self, Function&& function) noexcept;
+    };
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::begin_update(this PWMGroup const& self) noexcept
+    {
+        self.for_each_timer([](TIMHandle const timer) { SET_BIT(timer->Instance->CR1, TIM_CR1_UDIS); });
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::set_compare_raw(this PWMGroup const& self,
+                                         std::size_t const index,
+                                         std::uint32_t const raw) noexcept
+    {
+        self.channels[index].set_compare_raw(raw);
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::set_compare_raw(this PWMGroup const& self,
+                                         std::array<std::uint32_t, SIZE> const& raws) noexcept
+    {
+        for (std::size_t index = 0UL; index < SIZE; ++index) {
+            self.channels[index].set_compare_raw(raws[index]);
+        }
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::set_timing(this PWMGroup const& self, PWMTiming const& timing) noexcept
+    {
+        self.for_each_timer([&timing](TIMHandle const timer) {
+            __HAL_TIM_SET_PRESCALER(timer, timing.prescaler);
+            __HAL_TIM_SET_AUTORELOAD(timer, timing.period);
+        });
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::commit(this PWMGroup const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.for_each_timer([](TIMHandle const timer) { CLEAR_BIT(timer->Instance->CR1, TIM_CR1_UDIS); });
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::commit_immediately(this PWMGroup const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.for_each_timer([](TIMHandle const timer) {
+            CLEAR_BIT(timer->Instance->CR1, TIM_CR1_UDIS);
+            timer->Instance->EGR = TIM_EGR_UG;
+        });
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::start(this PWMGroup const& self) noexcept
+    {
+        self.for_each_timer([](TIMHandle const timer) {
+            __HAL_TIM_DISABLE(timer);
+            CLEAR_BIT(timer->Instance->CR1, TIM_CR1_UDIS);
+            __HAL_TIM_SET_COUNTER(timer, 0UL);
+            timer->Instance->EGR = TIM_EGR_UG;
+        });
+
+        for (auto const& channel : self.channels) {
+            TIM_CCxChannelCmd(channel.timer->Instance, channel.channel_mask, TIM_CCx_ENABLE);
+            TIM_CHANNEL_STATE_SET(channel.timer, channel.channel_mask, HAL_TIM_CHANNEL_STATE_BUSY);
+        }
+
+        auto const critical_section = CriticalSection{};
+
+        // slaves first, so the ones in trigger mode are armed before the master emits TRGO
+        for (auto index = SIZE; index > 0UL; --index) {
+            auto const timer = self.channels[index - 1UL].timer;
+            if (IS_TIM_BREAK_INSTANCE(timer->Instance)) {
+                __HAL_TIM_MOE_ENABLE(timer);
+            }
+            if ((timer->Instance->SMCR & TIM_SMCR_SMS) != TIM_SLAVEMODE_TRIGGER) {
+                __HAL_TIM_ENABLE(timer);
+            }
+        }
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::stop(this PWMGroup const& self) noexcept
+    {
+        for (auto const& channel : self.channels) {
+            TIM_CCxChannelCmd(channel.timer->Instance, channel.channel_mask, TIM_CCx_DISABLE);
+            TIM_CHANNEL_STATE_SET(channel.timer, channel.channel_mask, HAL_TIM_CHANNEL_STATE_READY);
+        }
+
+        self.for_each_timer([](TIMHandle const timer) {
+            if (IS_TIM_BREAK_INSTANCE(timer->Instance)) {
+                __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(timer);
+            }
+            __HAL_TIM_DISABLE(timer);
+        });
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::initialize(this PWMGroup const& self) noexcept
+    {
+        self.for_each_timer([](TIMHandle const timer) { SET_BIT(timer->Instance->CR1, TIM_CR1_ARPE); });
+
+        for (auto const& channel : self.channels) {
+            __HAL_TIM_ENABLE_OCxPRELOAD(channel.timer, channel.channel_mask);
+        }
+    }
+
+    template <std::size_t SIZE>
+    void PWMGroup<SIZE>::deinitialize(this PWMGroup const& self) noexcept
+    {
+        self.stop();
+    }
+
+    template <std::size_t SIZE>
+    template <typename Function>
+    void PWMGroup<SIZE>::for_each_timer(this PWMGroup const& self, Function&& function) noexcept
+    {
+        for (std::size_t index = 0UL; index < SIZE; ++index) {
+            auto const timer = self.channels[index].timer;
+            auto const is_first = std::none_of(self.channels.begin(),
+                                               self.channels.begin() + index,
+                                               [timer](PWMDevice const& channel) { return channel.timer == timer; });
+            if (is_first) {
+                function(timer);
+            }
+        }
+    }
+
+}; // namespace STM32_Utility
+
+#endif // PWM_GROUP_HPP
\ No newline at end of file
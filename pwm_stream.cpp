@@ -0,0 +1,64 @@
+#include "pwm_stream.hpp"
+#include "log.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    HAL_StatusTypeDef PWMStream::start(this PWMStream const& self) noexcept
+    {
+        assert(self.buffer && self.size > 1UL);
+
+        if (self.size > MAX_SIZE) {
+            log_fault("PWM STREAM ERROR");
+            return HAL_ERROR;
+        }
+
+        if (self.refill) {
+            self.refill(self.context, self.buffer, self.size);
+        }
+
+        auto const result = HAL_TIM_PWM_Start_DMA(self.timer,
+                                                  self.channel_mask,
+                                                  self.buffer,
+                                                  static_cast<std::uint16_t>(self.size));
+        if (result != HAL_OK) {
+            log_fault("PWM STREAM ERROR");
+        }
+
+        return result;
+    }
+
+    void PWMStream::stop(this PWMStream const& self) noexcept
+    {
+        if (HAL_TIM_PWM_Stop_DMA(self.timer, self.channel_mask) != HAL_OK) {
+            log_fault("PWM STREAM ERROR");
+        }
+    }
+
+    bool PWMStream::is_running(this PWMStream const& self) noexcept
+    {
+        return TIM_CHANNEL_STATE_GET(self.timer, self.channel_mask) == HAL_TIM_CHANNEL_STATE_BUSY;
+    }
+
+    void PWMStream::half_complete_callback(this PWMStream const& self, TIMHandle const timer) noexcept
+    {
+        if (self.refill && self.is_active_channel(timer)) {
+            self.refill(self.context, self.buffer, self.size / 2UL);
+        }
+    }
+
+    void PWMStream::complete_callback(this PWMStream const& self, TIMHandle const timer) noexcept
+    {
+        // with a normal mode DMA the HAL marks the channel ready ahead of this callback, the stream has ended
+        if (self.refill && self.is_active_channel(timer) && self.is_running()) {
+            self.refill(self.context, self.buffer + self.size / 2UL, self.size - self.size / 2UL);
+        }
+    }
+
+    bool PWMStream::is_active_channel(this PWMStream const& self, TIMHandle const timer) noexcept
+    {
+        return timer == self.timer &&
+               timer->Channel == static_cast<HAL_TIM_ActiveChannel>(1UL << (self.channel_mask / TIM_CHANNEL_2));
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef PWM_STREAM_HPP
+#define PWM_STREAM_HPP
+
+#include "common.hpp"
+
+namespace STM32_Utility {
+
+    using PWMRefillCallback = void (*)(void* const context, std::uint32_t* const data, std::size_t const size) noexcept;
+
+    struct PWMStream {
+    public:
+        // HAL_ERROR when size exceeds MAX_SIZE
+        HAL_StatusTypeDef start(this PWMStream const& self) noexcept;
+        void stop(this PWMStream const& self) noexcept;
+
+        bool is_running(this PWMStream const& self) noexcept;
+
+        // call from HAL_TIM_PWM_PulseFinishedHalfCpltCallback
+        void half_complete_callback(this PWMStream const& self, TIMHandle const timer) noexcept;
+
+        // call from HAL_TIM_PWM_PulseFinishedCallback
+        void complete_callback(this PWMStream const& self, TIMHandle const timer) noexcept;
+
+        // 16 bit NDTR of the DMA stream
+        static constexpr std::size_t MAX_SIZE = 0xFFFFUL;
+
+        TIMHandle timer = nullptr;
+        std::uint32_t channel_mask = 0UL;
+
+        std::uint32_t* buffer = nullptr;
+        std::size_t size = 0UL;
+
+        PWMRefillCallback refill = nullptr;
+        void* context = nullptr;
+
+    private:
+        bool is_active_channel(this PWMStream const& self, TIMHandle const timer) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // PWM_STREAM_HPP
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef PWM_TIMING_HPP
+#define PWM_TIMING_HPP
+
+#include "common.hpp"
+
+namespace STM32_Utility {
+
+    struct PWMTiming {
+        std::uint32_t prescaler = 0UL;
+        std::uint32_t period = 0UL;
+        std::int32_t error_ppm = 0L;
+    };
+
+    inline constexpr std::uint32_t PWM_MAX_PRESCALER = 0xFFFFUL;
+    inline constexpr std::uint32_t PWM_MAX_PERIOD_16BIT = 0xFFFFUL;
+    inline constexpr std::uint32_t PWM_MAX_PERIOD_32BIT = 0xFFFFFFFFUL;
+
+    // smallest prescaler that fits the period gives the finest duty cycle resolution
+    inline constexpr PWMTiming frequency_to_pwm_timing(std::uint32_t const clock_hz,
+                                                       std::uint32_t const frequency,
+                                                       std::uint32_t const max_period = PWM_MAX_PERIOD_16BIT) noexcept
+    {
+        if (frequency == 0UL || clock_hz == 0UL) {
+            return PWMTiming{};
+        }
+
+        auto const clock = static_cast<std::uint64_t>(clock_hz);
+        auto const target = static_cast<std::uint64_t>(frequency);
+        auto const max_ticks = static_cast<std::uint64_t>(max_period) + 1ULL;
+
+        auto const ticks = std::max<std::uint64_t>((clock + target / 2ULL) / target, 2ULL);
+        auto const divider = std::min<std::uint64_t>((ticks + max_ticks - 1ULL) / max_ticks, PWM_MAX_PRESCALER + 1ULL);
+        auto const period_ticks =
+            std::clamp<std::uint64_t>((clock + divider * target / 2ULL) / (divider * target), 2ULL, max_ticks);
+
+        auto const achieved_ppm = static_cast<std::int64_t>(1000000ULL * clock / (divider * period_ticks * target));
+
+        return PWMTiming{.prescaler = static_cast<std::uint32_t>(divider - 1ULL),
+                         .period = static_cast<std::uint32_t>(period_ticks - 1ULL),
+                         .error_ppm = static_cast<std::int32_t>(achieved_ppm - 1000000LL)};
+    }
+
+    template <std::size_t SIZE>
+    inline constexpr std::array<PWMTiming, SIZE> make_pwm_timing_table(std::uint32_t const clock_hz,
+                                                                        std::uint32_t const first_frequency,
+                                                                        std::uint32_t const frequency_step,
+                                                                        std::uint32_t const max_period =
+                                                                            PWM_MAX_PERIOD_16BIT) noexcept
+    {
+        auto table = std::array<PWMTiming, SIZE>{};
+
+        for (std::size_t index = 0UL; index < SIZE; ++index) {
+            table[index] = frequency_to_pwm_timing(clock_hz,
+                                                   first_frequency +
+                                                       static_cast<std::uint32_t>(index) * frequency_step,
+                                                   max_period);
+        }
+
+        return table;
+    }
+
+}; // namespace STM32_Utility
+
+#endif // PWM_TIMING_HPP
\ No newline at end of file
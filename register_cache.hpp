@@ -0,0 +1,202 @@
+#ifndef REGISTER_CACHE_HPP
+#define REGISTER_CACHE_HPP
+
+#include "common.hpp"
+#include <bitset>
+
+namespace STM32_Utility {
+
+    // Shadow of SIZE consecutive registers from base_address of an I2CDevice or SPIDevice. Writes stay
+    // in the shadow until flush, which sends each run of contiguous dirty registers as one
+    // auto-increment write_bytes burst. Volatile registers and addresses outside the range always go
+    // to the device.
+    template <typename Device, std::size_t SIZE>
+    struct RegisterCache {
+    public:
+        Expected<std::uint8_t> read_byte(this RegisterCache& self, std::uint8_t const address) noexcept;
+
+        Expected<> write_byte(this RegisterCache& self, std::uint8_t const address, std::uint8_t const data) noexcept;
+
+        // read-modify-write of the bits in mask, costs no bus transfer once the register is cached
+        Expected<> modify_byte(this RegisterCache& self,
+                               std::uint8_t const address,
+                               std::uint8_t const mask,
+                               std::uint8_t const bits) noexcept;
+
+        // reads the whole range in one burst, dirty registers keep their shadow values
+        Expected<> fetch(this RegisterCache& self) noexcept;
+
+        Expected<> flush(this RegisterCache& self) noexcept;
+
+        // drops every shadow value including unflushed writes, e.g. after a device reset
+        void invalidate(this RegisterCache& self) noexcept;
+
+        void set_volatile(this RegisterCache& self, std::uint8_t const address, bool const is_volatile = true) noexcept;
+
+        bool is_dirty(this RegisterCache const& self) noexcept;
+
+        Device device = {};
+        std::uint8_t base_address = 0U;
+
+        std::array<std::uint8_t, SIZE> values = {};
+        std::bitset<SIZE> valid = {};
+        std::bitset<SIZE> dirty = {};
+        std::bitset<SIZE> volatile_registers = {};
+
+    private:
+        bool is_cached(this RegisterCache const& self, std::uint8_t const address) noexcept;
+        bool contains(this RegisterCache const& self, std::uint8_t const address) noexcept;
+
+        std::size_t address_to_index(this RegisterCache const& self, std::uint8_t const address) noexcept;
+    };
+
+    template <typename Device, std::size_t SIZE>
+    Expected<std::uint8_t> RegisterCache<Device, SIZE>::read_byte(this RegisterCache& self,
+                                                                  std::uint8_t const address) noexcept
+    {
+        if (!self.is_cached(address)) {
+            return self.device.read_byte(address);
+        }
+
+        auto const index = self.address_to_index(address);
+        if (!self.valid[index]) {
+            auto const data = self.device.read_byte(address);
+            if (!data) {
+                return data;
+            }
+
+            self.values[index] = *data;
+            self.valid[index] = true;
+        }
+
+        return self.values[index];
+    }
+
+    template <typename Device, std::size_t SIZE>
+    Expected<> RegisterCache<Device, SIZE>::write_byte(this RegisterCache& self,
+                                                       std::uint8_t const address,
+                                                       std::uint8_t const data) noexcept
+    {
+        if (!self.is_cached(address)) {
+            return self.device.write_byte(address, data);
+        }
+
+        auto const index = self.address_to_index(address);
+        if (!self.valid[index] || self.values[index] != data) {
+            self.values[index] = data;
+            self.valid[index] = true;
+            self.dirty[index] = true;
+        }
+
+        return {};
+    }
+
+    template <typename Device, std::size_t SIZE>
+    Expected<> RegisterCache<Device, SIZE>::modify_byte(this RegisterCache& self,
+                                                        std::uint8_t const address,
+                                                        std::uint8_t const mask,
+                                                        std::uint8_t const bits) noexcept
+    {
+        return self.read_byte(address).and_then([&](std::uint8_t const data) {
+            return self.write_byte(address, static_cast<std::uint8_t>((data & ~mask) | (bits & mask)));
+        });
+    }
+
+    template <typename Device, std::size_t SIZE>
+    Expected<> RegisterCache<Device, SIZE>::fetch(this RegisterCache& self) noexcept
+    {
+        auto data = std::array<std::uint8_t, SIZE>{};
+
+        auto const result = self.device.read_bytes(self.base_address, data.data(), data.size());
+        if (!result) {
+            return result;
+        }
+
+        for (std::size_t index = 0UL; index < SIZE; ++index) {
+            if (!self.dirty[index] && !self.volatile_registers[index]) {
+                self.values[index] = data[index];
+                self.valid[index] = true;
+            }
+        }
+
+        return {};
+    }
+
+    template <typename Device, std::size_t SIZE>
+    Expected<> RegisterCache<Device, SIZE>::flush(this RegisterCache& self) noexcept
+    {
+        for (std::size_t first = 0UL; first < SIZE;) {
+            if (!self.dirty[first]) {
+                ++first;
+                continue;
+            }
+
+            auto last = first + 1UL;
+            while (last < SIZE && self.dirty[last]) {
+                ++last;
+            }
+
+            auto const result = self.device.write_bytes(static_cast<std::uint8_t>(self.base_address + first),
+                                                        self.values.data() + first,
+                                                        last - first);
+            if (!result) {
+                return result;
+            }
+
+            for (auto index = first; index < last; ++index) {
+                self.dirty[index] = false;
+            }
+            first = last;
+        }
+
+        return {};
+    }
+
+    template <typename Device, std::size_t SIZE>
+    void RegisterCache<Device, SIZE>::invalidate(this RegisterCache& self) noexcept
+    {
+        self.valid.reset();
+        self.dirty.reset();
+    }
+
+    template <typename Device, std::size_t SIZE>
+    void RegisterCache<Device, SIZE>::set_volatile(this RegisterCache& self,
+                                                   std::uint8_t const address,
+                                                   bool const is_volatile) noexcept
+    {
+        if (self.contains(address)) {
+            auto const index = self.address_to_index(address);
+            self.volatile_registers[index] = is_volatile;
+            self.valid[index] = false;
+            self.dirty[index] = false;
+        }
+    }
+
+    template <typename Device, std::size_t SIZE>
+    bool RegisterCache<Device, SIZE>::is_dirty(this RegisterCache const& self) noexcept
+    {
+        return self.dirty.any();
+    }
+
+    template <typename Device, std::size_t SIZE>
+    bool RegisterCache<Device, SIZE>::is_cached(this RegisterCache const& self, std::uint8_t const address) noexcept
+    {
+        return self.contains(address) && !self.volatile_registers[self.address_to_index(address)];
+    }
+
+    template <typename Device, std::size_t SIZE>
+    bool RegisterCache<Device, SIZE>::contains(this RegisterCache const& self, std::uint8_t const address) noexcept
+    {
+        return address >= self.base_address && self.address_to_index(address) < SIZE;
+    }
+
+    template <typename Device, std::size_t SIZE>
+    std::size_t RegisterCache<Device, SIZE>::address_to_index(this RegisterCache const& self,
+                                                              std::uint8_t const address) noexcept
+    {
+        return static_cast<std::size_t>(address) - static_cast<std::size_t>(self.base_address);
+    }
+
+}; // namespace STM32_Utility
+
+#endif // REGISTER_CACHE_HPP
\ No newline at end of file
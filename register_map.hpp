@@ -0,0 +1,161 @@
+#ifndef REGISTER_MAP_HPP
+#define REGISTER_MAP_HPP
+
+#include "common.hpp"
+#include <bit>
+#include <type_traits>
+
+namespace STM32_Utility {
+
+    enum struct RegisterAccess : std::uint8_t {
+        READ_ONLY,
+        WRITE_ONLY,
+        READ_WRITE,
+    };
+
+    // Registers wider than a byte are transferred with read_bytes/write_bytes in REGISTER_ENDIAN order,
+    // byte registers with read_byte/write_byte, so they also work through a RegisterCache.
+    template <std::uint8_t REGISTER_ADDRESS,
+              typename REGISTER_VALUE = std::uint8_t,
+              RegisterAccess REGISTER_ACCESS = RegisterAccess::READ_WRITE,
+              std::endian REGISTER_ENDIAN = std::endian::big>
+    struct Register {
+        static_assert(std::is_unsigned_v<REGISTER_VALUE> && sizeof(REGISTER_VALUE) <= sizeof(std::uint32_t),
+                      "register value must be an unsigned integer of at most 32 bits");
+
+        using Value = REGISTER_VALUE;
+
+        static constexpr std::uint8_t ADDRESS = REGISTER_ADDRESS;
+        static constexpr std::size_t SIZE = sizeof(Value);
+        static constexpr RegisterAccess ACCESS = REGISTER_ACCESS;
+        static constexpr std::endian ENDIAN = REGISTER_ENDIAN;
+        static constexpr Value MASK = static_cast<Value>(~Value{0U});
+    };
+
+    // Bits OFFSET to OFFSET + WIDTH - 1 of FIELD_REGISTER, an instance carries a value to write:
+    // write_fields(device, DataRate{ODR::HZ_100}, Scale{FS::G_2})
+    template <typename FIELD_REGISTER, std::uint8_t OFFSET, std::uint8_t WIDTH, typename FIELD_VALUE = std::uint8_t>
+    struct Field {
+        using RegisterType = FIELD_REGISTER;
+        using Raw = typename RegisterType::Value;
+        using Value = FIELD_VALUE;
+
+        static_assert(WIDTH > 0U && OFFSET + WIDTH <= 8UL * RegisterType::SIZE, "field exceeds its register");
+
+        static constexpr Raw MASK = static_cast<Raw>(((1ULL << WIDTH) - 1ULL) << OFFSET);
+
+        static constexpr Raw encode(Value const value) noexcept
+        {
+            return static_cast<Raw>((static_cast<std::uint64_t>(value) << OFFSET) & MASK);
+        }
+
+        static constexpr Value decode(Raw const raw) noexcept
+        {
+            return static_cast<Value>((raw & MASK) >> OFFSET);
+        }
+
+        Value value = {};
+    };
+
+    template <typename Register, typename Device>
+    Expected<typename Register::Value> read_register(Device& device) noexcept;
+
+    template <typename Register, typename Device>
+    Expected<> write_register(Device& device, typename Register::Value const value) noexcept;
+
+    template <typename Field, typename Device>
+    Expected<typename Field::Value> read_field(Device& device) noexcept;
+
+    // Fields of one register are merged into a single write, read-modify-write only when they leave
+    // bits of a readable register untouched. Untouched bits of write-only registers are written as 0.
+    template <typename Device, typename FirstField, typename... Fields>
+    Expected<> write_fields(Device& device, FirstField const first, Fields const... fields) noexcept;
+
+    template <typename Register, typename Device>
+    Expected<typename Register::Value> read_register(Device& device) noexcept
+    {
+        static_assert(Register::ACCESS != RegisterAccess::WRITE_ONLY, "register is write-only");
+
+        if constexpr (Register::SIZE == 1UL) {
+            return device.read_byte(Register::ADDRESS);
+        } else {
+            auto bytes = std::array<std::uint8_t, Register::SIZE>{};
+
+            auto const result = device.read_bytes(Register::ADDRESS, bytes.data(), bytes.size());
+            if (!result) {
+                return std::unexpected{result.error()};
+            }
+
+            auto value = typename Register::Value{0U};
+            for (std::size_t index = 0UL; index < Register::SIZE; ++index) {
+                auto const shift =
+                    Register::ENDIAN == std::endian::big ? 8UL * (Register::SIZE - 1UL - index) : 8UL * index;
+                value = static_cast<typename Register::Value>(value | (bytes[index] << shift));
+            }
+
+            return value;
+        }
+    }
+
+    template <typename Register, typename Device>
+    Expected<> write_register(Device& device, typename Register::Value const value) noexcept
+    {
+        static_assert(Register::ACCESS != RegisterAccess::READ_ONLY, "register is read-only");
+
+        if constexpr (Register::SIZE == 1UL) {
+            return device.write_byte(Register::ADDRESS, value);
+        } else {
+            auto bytes = std::array<std::uint8_t, Register::SIZE>{};
+            for (std::size_t index = 0UL; index < Register::SIZE; ++index) {
+                auto const shift =
+                    Register::ENDIAN == std::endian::big ? 8UL * (Register::SIZE - 1UL - index) : 8UL * index;
+                bytes[index] = static_cast<std::uint8_t>(value >> shift);
+            }
+
+            return device.write_bytes(Register::ADDRESS, bytes.data(), bytes.size());
+        }
+    }
+
+    template <typename Field, typename Device>
+    Expected<typename Field::Value> read_field(Device& device) noexcept
+    {
+        auto const raw = read_register<typename Field::RegisterType>(device);
+        if (!raw) {
+            return std::unexpected{raw.error()};
+        }
+
+        return Field::decode(*raw);
+    }
+
+    template <typename Device, typename FirstField, typename... Fields>
+    Expected<> write_fields(Device& device, FirstField const first, Fields const... fields) noexcept
+    {
+        using Register = typename FirstField::RegisterType;
+        using Raw = typename Register::Value;
+
+        static_assert((std::is_same_v<typename Fields::RegisterType, Register> && ...),
+                      "fields written together must belong to one register");
+        static_assert(Register::ACCESS != RegisterAccess::READ_ONLY, "register is read-only");
+
+        constexpr auto mask = static_cast<Raw>(FirstField::MASK | (Fields::MASK | ... | Raw{0U}));
+        static_assert((std::uint64_t{FirstField::MASK} + ... + std::uint64_t{Fields::MASK}) == mask,
+                      "fields written together must not overlap");
+
+        auto const bits =
+            static_cast<Raw>(FirstField::encode(first.value) | (Fields::encode(fields.value) | ... | Raw{0U}));
+
+        if constexpr (mask == Register::MASK || Register::ACCESS == RegisterAccess::WRITE_ONLY) {
+            return write_register<Register>(device, bits);
+        } else {
+            auto const raw = read_register<Register>(device);
+            if (!raw) {
+                return std::unexpected{raw.error()};
+            }
+
+            return write_register<Register>(device, static_cast<Raw>((*raw & ~mask) | bits));
+        }
+    }
+
+}; // namespace STM32_Utility
+
+#endif // REGISTER_MAP_HPP
\ No newline at end of file
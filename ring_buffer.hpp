@@ -0,0 +1,308 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include "common.hpp"
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace STM32_Utility {
+
+    // Fixed capacity queue between one producer and one consumer context, e.g. a driver callback and
+    // the main loop. Positions are free running 32 bit counters, the acquire/release pairs order the
+    // element accesses against the counter updates, which also holds across interrupt preemption.
+    template <typename T, std::size_t SIZE>
+    struct SPSCRingBuffer {
+    public:
+        static_assert(std::has_single_bit(SIZE) && SIZE <= (1UL << 31UL), "size must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        static constexpr std::size_t CAPACITY = SIZE;
+
+        // producer side
+        bool push(this SPSCRingBuffer& self, T const& value) noexcept;
+        std::size_t push_bulk(this SPSCRingBuffer& self, std::span<T const> const values) noexcept;
+
+        // contiguous free space to fill in place, up to the wrap point, published by commit
+        std::span<T> prepare(this SPSCRingBuffer& self) noexcept;
+        void commit(this SPSCRingBuffer& self, std::size_t const count) noexcept;
+
+        // consumer side
+        std::optional<T> pop(this SPSCRingBuffer& self) noexcept;
+        std::size_t pop_bulk(this SPSCRingBuffer& self, std::span<T> const values) noexcept;
+
+        // contiguous stored elements to read in place, up to the wrap point, released by consume
+        std::span<T const> peek(this SPSCRingBuffer const& self) noexcept;
+        void consume(this SPSCRingBuffer& self, std::size_t const count) noexcept;
+
+        // exact from either side, a snapshot from any other context
+        std::size_t size(this SPSCRingBuffer const& self) noexcept;
+        bool is_empty(this SPSCRingBuffer const& self) noexcept;
+        bool is_full(this SPSCRingBuffer const& self) noexcept;
+
+        std::array<T, SIZE> buffer = {};
+
+        std::atomic<std::uint32_t> head = 0UL;
+        std::atomic<std::uint32_t> tail = 0UL;
+
+    private:
+        static constexpr auto MASK = static_cast<std::uint32_t>(SIZE - 1UL);
+    };
+
+    // Fixed capacity queue any number of contexts push to, interrupts of any priority included, and
+    // one context pops from. A slot is free for position p when its sequence equals p and holds an
+    // element for position p when it equals p + 1, so producers reserve positions with a CAS and a
+    // producer preempted between reserving and publishing only delays the consumer, never corrupts.
+    template <typename T, std::size_t SIZE>
+    struct MPSCRingBuffer {
+    public:
+        static_assert(std::has_single_bit(SIZE) && SIZE <= (1UL << 31UL), "size must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        static constexpr std::size_t CAPACITY = SIZE;
+
+        struct Slot {
+            std::atomic<std::uint32_t> sequence = 0UL;
+            T value = {};
+        };
+
+        // any context, false when full
+        bool push(this MPSCRingBuffer& self, T const& value) noexcept;
+
+        // consumer side
+        std::optional<T> pop(this MPSCRingBuffer& self) noexcept;
+        std::size_t pop_bulk(this MPSCRingBuffer& self, std::span<T> const values) noexcept;
+
+        // reserved positions included, so pop may still find the oldest one unpublished
+        std::size_t size(this MPSCRingBuffer const& self) noexcept;
+        bool is_empty(this MPSCRingBuffer const& self) noexcept;
+
+        // sequences are stored relative to the slot index, so the zero-initialized buffer is empty
+        std::array<Slot, SIZE> slots = {};
+
+        std::atomic<std::uint32_t> head = 0UL;
+        std::atomic<std::uint32_t> tail = 0UL;
+
+    private:
+        static std::uint32_t get_sequence(std::uint32_t const position, std::uint32_t const index) noexcept;
+
+        static constexpr auto MASK = static_cast<std::uint32_t>(SIZE - 1UL);
+    };
+
+    template <typename T, std::size_t SIZE>
+    bool SPSCRingBuffer<T, SIZE>::push(this SPSCRingBuffer& self, T const& value) noexcept
+    {
+        return self.push_bulk(std::span<T const>{&value, 1UL}) == 1UL;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::size_t SPSCRingBuffer<T, SIZE>::push_bulk(this SPSCRingBuffer& self, std::span<T const> const values) noexcept
+    {
+        auto pushed = std::size_t{0UL};
+
+        // at most two runs, before and after the wrap point
+        while (pushed < values.size()) {
+            auto const space = self.prepare();
+            if (space.empty()) {
+                break;
+            }
+
+            auto const count = std::min(space.size(), values.size() - pushed);
+            std::copy_n(values.data() + pushed, count, space.data());
+            self.commit(count);
+            pushed += count;
+        }
+
+        return pushed;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::span<T> SPSCRingBuffer<T, SIZE>::prepare(this SPSCRingBuffer& self) noexcept
+    {
+        auto const head = self.head.load(std::memory_order_relaxed);
+        auto const tail = self.tail.load(std::memory_order_acquire);
+
+        auto const index = head & MASK;
+        auto const free = SIZE - (head - tail);
+
+        return std::span<T>{self.buffer.data() + index, std::min(free, SIZE - index)};
+    }
+
+    template <typename T, std::size_t SIZE>
+    void SPSCRingBuffer<T, SIZE>::commit(this SPSCRingBuffer& self, std::size_t const count) noexcept
+    {
+        assert(count <= SIZE - self.size());
+
+        self.head.store(self.head.load(std::memory_order_relaxed) + static_cast<std::uint32_t>(count),
+                        std::memory_order_release);
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::optional<T> SPSCRingBuffer<T, SIZE>::pop(this SPSCRingBuffer& self) noexcept
+    {
+        auto value = T{};
+
+        if (self.pop_bulk(std::span<T>{&value, 1UL}) == 0UL) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::size_t SPSCRingBuffer<T, SIZE>::pop_bulk(this SPSCRingBuffer& self, std::span<T> const values) noexcept
+    {
+        auto popped = std::size_t{0UL};
+
+        while (popped < values.size()) {
+            auto const stored = self.peek();
+            if (stored.empty()) {
+                break;
+            }
+
+            auto const count = std::min(stored.size(), values.size() - popped);
+            std::copy_n(stored.data(), count, values.data() + popped);
+            self.consume(count);
+            popped += count;
+        }
+
+        return popped;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::span<T const> SPSCRingBuffer<T, SIZE>::peek(this SPSCRingBuffer const& self) noexcept
+    {
+        auto const tail = self.tail.load(std::memory_order_relaxed);
+        auto const head = self.head.load(std::memory_order_acquire);
+
+        auto const index = tail & MASK;
+        auto const stored = static_cast<std::size_t>(head - tail);
+
+        return std::span<T const>{self.buffer.data() + index, std::min(stored, SIZE - index)};
+    }
+
+    template <typename T, std::size_t SIZE>
+    void SPSCRingBuffer<T, SIZE>::consume(this SPSCRingBuffer& self, std::size_t const count) noexcept
+    {
+        assert(count <= self.size());
+
+        self.tail.store(self.tail.load(std::memory_order_relaxed) + static_cast<std::uint32_t>(count),
+                        std::memory_order_release);
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::size_t SPSCRingBuffer<T, SIZE>::size(this SPSCRingBuffer const& self) noexcept
+    {
+        auto const tail = self.tail.load(std::memory_order_acquire);
+        auto const head = self.head.load(std::memory_order_acquire);
+
+        return static_cast<std::size_t>(head - tail);
+    }
+
+    template <typename T, std::size_t SIZE>
+    bool SPSCRingBuffer<T, SIZE>::is_empty(this SPSCRingBuffer const& self) noexcept
+    {
+        return self.size() == 0UL;
+    }
+
+    template <typename T, std::size_t SIZE>
+    bool SPSCRingBuffer<T, SIZE>::is_full(this SPSCRingBuffer const& self) noexcept
+    {
+        return self.size() == SIZE;
+    }
+
+    template <typename T, std::size_t SIZE>
+    bool MPSCRingBuffer<T, SIZE>::push(this MPSCRingBuffer& self, T const& value) noexcept
+    {
+        auto position = self.head.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+
+        while (true) {
+            auto const index = position & MASK;
+            slot = &self.slots[index];
+
+            auto const sequence = slot->sequence.load(std::memory_order_acquire);
+            auto const difference = static_cast<std::int32_t>(sequence - get_sequence(position, index));
+
+            if (difference == 0L) {
+                if (self.head.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0L) {
+                return false;
+            } else {
+                position = self.head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = value;
+        slot->sequence.store(get_sequence(position + 1U, position & MASK), std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::optional<T> MPSCRingBuffer<T, SIZE>::pop(this MPSCRingBuffer& self) noexcept
+    {
+        auto value = T{};
+
+        if (self.pop_bulk(std::span<T>{&value, 1UL}) == 0UL) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::size_t MPSCRingBuffer<T, SIZE>::pop_bulk(this MPSCRingBuffer& self, std::span<T> const values) noexcept
+    {
+        auto tail = self.tail.load(std::memory_order_relaxed);
+        auto popped = std::size_t{0UL};
+
+        // stops at the first unpublished slot, keeping elements in reservation order
+        while (popped < values.size()) {
+            auto const index = tail & MASK;
+            auto& slot = self.slots[index];
+
+            if (slot.sequence.load(std::memory_order_acquire) != get_sequence(tail + 1U, index)) {
+                break;
+            }
+
+            values[popped++] = slot.value;
+            slot.sequence.store(get_sequence(tail + MASK + 1U, index), std::memory_order_release);
+            tail = tail + 1U;
+        }
+
+        self.tail.store(tail, std::memory_order_release);
+
+        return popped;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::size_t MPSCRingBuffer<T, SIZE>::size(this MPSCRingBuffer const& self) noexcept
+    {
+        auto const tail = self.tail.load(std::memory_order_acquire);
+        auto const head = self.head.load(std::memory_order_acquire);
+
+        return static_cast<std::size_t>(head - tail);
+    }
+
+    template <typename T, std::size_t SIZE>
+    bool MPSCRingBuffer<T, SIZE>::is_empty(this MPSCRingBuffer const& self) noexcept
+    {
+        return self.size() == 0UL;
+    }
+
+    template <typename T, std::size_t SIZE>
+    std::uint32_t MPSCRingBuffer<T, SIZE>::get_sequence(std::uint32_t const position,
+                                                        std::uint32_t const index) noexcept
+    {
+        return position - index;
+    }
+
+}; // namespace STM32_Utility
+
+#endif // RING_BUFFER_HPP
\ No newline at end of file
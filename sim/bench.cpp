@@ -0,0 +1,877 @@
+#include "async_device.hpp"
+#include "cnt_device.hpp"
+#include "cnt_sampler.hpp"
+#include "coroutine.hpp"
+#include "i2c_bus.hpp"
+#include "i2c_device.hpp"
+#include "i2c_eeprom.hpp"
+#include "i2c_scanner.hpp"
+#include "log.hpp"
+#include "pwm_device.hpp"
+#include "register_cache.hpp"
+#include "register_map.hpp"
+#include "ring_buffer.hpp"
+#include "sim.hpp"
+#include "spi_bus.hpp"
+#include "spi_device.hpp"
+#include "spi_dma_device.hpp"
+#include "spi_stream.hpp"
+#include "stats.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <optional>
+
+using namespace STM32_Utility;
+
+// allocations are counted through the linker, see sim/CMakeLists.txt
+extern "C" void* __real_malloc(std::size_t size);
+
+namespace {
+
+    constexpr std::size_t ITERATIONS = 1000UL;
+
+    constexpr std::uint16_t EEPROM_ADDRESS = 0x50U;
+
+    // 24C256 style: 16 bit addresses, 64 byte pages, write cycle up to 5 ms
+    constexpr std::uint16_t LARGE_EEPROM_ADDRESS = 0x52U;
+    constexpr std::size_t LARGE_EEPROM_PAGE = 64UL;
+    constexpr Sim::Nanoseconds LARGE_EEPROM_WRITE_TIME = 3000000ULL;
+
+    constexpr std::uint32_t IMU_RATE = 3200UL;
+    constexpr Sim::Nanoseconds IMU_PERIOD = 1000000000ULL / IMU_RATE;
+
+    std::size_t allocations = 0UL;
+
+    // serial NOR flash style: 16 bit command word with the read flag on top and a dummy byte on reads
+    struct FlashProtocol : SPIProtocol {
+        static constexpr std::uint8_t RW_BIT = 15U;
+        static constexpr std::uint8_t ADDRESS_BITS = 16U;
+        static constexpr std::uint8_t DUMMY_CYCLES = 8U;
+    };
+
+    using CTRL = Register<0x22U>;
+    using CTRL_MODE = Field<CTRL, 0U, 2U>;
+    using CTRL_RATE = Field<CTRL, 4U, 3U>;
+
+    I2C_HandleTypeDef i2c_handle = {};
+    SPI_HandleTypeDef spi_handle = {};
+    SPI_HandleTypeDef imu_handle = {};
+    SPI_HandleTypeDef shared_handle = {};
+    TIM_HandleTypeDef pwm_handle = {};
+    TIM_HandleTypeDef cnt_handle = {};
+    TIM_HandleTypeDef trigger_handle = {};
+    std::array<TIM_HandleTypeDef, 3UL> axis_handles = {};
+
+    std::array<std::uint8_t, 256UL> eeprom = {};
+    std::array<std::uint8_t, 32768UL> large_eeprom = {};
+
+    auto i2c_device = I2CDevice{};
+    auto large_eeprom_device = I2CDevice{};
+    auto i2c_eeprom = I2CEEPROM{};
+    auto spi_device = SPIDevice<>{};
+    auto flash_device = SPIDevice<FlashProtocol>{};
+    auto i2c_registers = RegisterCache<I2CDevice, 16UL>{};
+    auto spi_dma_device = SPIDMADevice{};
+    auto imu_stream = SPIStream<12UL, 64UL>{};
+    auto imu_fifo_stream = SPIStream<12UL, 64UL, 8UL>{};
+    auto i2c_bus = I2CBus{};
+    auto shared_bus = SPIBus{};
+    auto dac = SPIBusDevice{};
+    auto flash = SPIBusDevice{};
+    auto adc = SPIBusDevice{};
+    auto i2c_scanner = I2CScanner{};
+    auto pwm_device = PWMDevice{};
+    auto cnt_device = CNTDevice{};
+    auto axis_devices = std::array<CNTDevice, 3UL>{};
+    auto cnt_sampler = CNTSampler<4UL>{};
+
+    std::uint8_t spi_loopback(void* const, std::uint8_t const tx_byte) noexcept
+    {
+        return tx_byte;
+    }
+
+    std::uint8_t imu_responder(void* const, std::uint8_t const) noexcept
+    {
+        static auto value = std::uint8_t{0U};
+        return value++;
+    }
+
+    void transfer_done(void* const, HAL_StatusTypeDef const) noexcept
+    {}
+
+    std::uint64_t get_cpu_time() noexcept
+    {
+        auto time = timespec{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return static_cast<std::uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(time.tv_nsec);
+    }
+
+    void print_header(char const* const group) noexcept
+    {
+        std::printf("\n%-36s %12s %12s %12s %10s\n", group, "virtual ns", "bus ns", "cpu ns", "allocs");
+    }
+
+    template <typename Operation>
+    void measure(char const* const name, std::optional<Sim::Bus> const bus, Operation&& operation) noexcept
+    {
+        Sim::reset_statistics();
+        allocations = 0UL;
+
+        auto const virtual_start = Sim::now();
+        auto const cpu_start = get_cpu_time();
+
+        for (auto iteration = 0UL; iteration < ITERATIONS; ++iteration) {
+            operation();
+        }
+
+        auto const cpu_time = get_cpu_time() - cpu_start;
+        auto const virtual_time = Sim::now() - virtual_start;
+        auto const bus_time = bus.has_value() ? Sim::get_statistics(*bus).busy_time : 0ULL;
+
+        std::printf("%-36s %12.1f %12.1f %12.1f %10.2f\n",
+                    name,
+                    static_cast<double>(virtual_time) / ITERATIONS,
+                    static_cast<double>(bus_time) / ITERATIONS,
+                    static_cast<double>(cpu_time) / ITERATIONS,
+                    static_cast<double>(allocations) / ITERATIONS);
+    }
+
+    // start runs with the CPU busy, the rest of the transfer completes in the background; the idle share
+    // is the virtual time outside start, left to other work while the DMA moves the data
+    template <typename Start>
+    void measure_throughput(char const* const name, std::size_t const size, Start&& start) noexcept
+    {
+        auto busy_time = 0ULL;
+
+        auto const virtual_start = Sim::now();
+        auto const cpu_start = get_cpu_time();
+
+        for (auto iteration = 0UL; iteration < ITERATIONS; ++iteration) {
+            auto const call_start = Sim::now();
+            start();
+            busy_time += Sim::now() - call_start;
+
+            Sim::run_until_idle();
+        }
+
+        auto const cpu_time = get_cpu_time() - cpu_start;
+        auto const virtual_time = Sim::now() - virtual_start;
+
+        std::printf("%-30s %5zu %12.0f %12.1f %12.1f\n",
+                    name,
+                    size,
+                    static_cast<double>(size * ITERATIONS) * 1e9 / static_cast<double>(virtual_time),
+                    100.0 * static_cast<double>(virtual_time - busy_time) / static_cast<double>(virtual_time),
+                    static_cast<double>(cpu_time) / ITERATIONS);
+    }
+
+    void print_stats(char const* const name, TransferStatsSnapshot const& stats) noexcept
+    {
+        std::printf("%-36s %10lu transactions %8lu errors %8lu timeouts %8lu nacks\n",
+                    name,
+                    static_cast<unsigned long>(stats.transactions),
+                    static_cast<unsigned long>(stats.errors),
+                    static_cast<unsigned long>(stats.timeouts),
+                    static_cast<unsigned long>(stats.nacks));
+
+        for (auto const& latency : stats.latency) {
+            if (latency.count != 0UL) {
+                std::printf("%-36s %10lu min %8lu mean %8lu p99 %8lu max cycles\n",
+                            "",
+                            static_cast<unsigned long>(latency.min_cycles),
+                            static_cast<unsigned long>(latency.get_mean()),
+                            static_cast<unsigned long>(latency.get_p99()),
+                            static_cast<unsigned long>(latency.max_cycles));
+            }
+        }
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+        stats_initialize();
+
+        i2c_handle.Instance = I2C1;
+        i2c_handle.Init.ClockSpeed = 400000UL;
+        HAL_I2C_Init(&i2c_handle);
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS, eeprom.data(), eeprom.size());
+        Sim::attach_i2c_device(&i2c_handle,
+                               LARGE_EEPROM_ADDRESS,
+                               large_eeprom.data(),
+                               large_eeprom.size(),
+                               2UL,
+                               LARGE_EEPROM_PAGE,
+                               LARGE_EEPROM_WRITE_TIME);
+
+        spi_handle.Instance = SPI1;
+        spi_handle.Init.Mode = SPI_MODE_MASTER;
+        spi_handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;
+        HAL_SPI_Init(&spi_handle);
+        Sim::attach_spi_responder(&spi_handle, spi_loopback);
+
+        imu_handle.Instance = SPI2;
+        imu_handle.Init.Mode = SPI_MODE_MASTER;
+        imu_handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_4;
+        HAL_SPI_Init(&imu_handle);
+        Sim::attach_spi_responder(&imu_handle, imu_responder);
+
+        shared_handle.Instance = SPI3;
+        shared_handle.Init.Mode = SPI_MODE_MASTER;
+        HAL_SPI_Init(&shared_handle);
+        Sim::attach_spi_responder(&shared_handle, spi_loopback);
+
+        pwm_handle.Instance = TIM3;
+        pwm_handle.Init.Period = 999UL;
+        HAL_TIM_PWM_Init(&pwm_handle);
+
+        cnt_handle.Instance = TIM4;
+        cnt_handle.Init.Period = 0xFFFFUL;
+        auto encoder_config = TIM_Encoder_InitTypeDef{.EncoderMode = TIM_ENCODERMODE_TI12,
+                                                      .IC1Polarity = TIM_ICPOLARITY_RISING,
+                                                      .IC1Selection = TIM_ICSELECTION_DIRECTTI,
+                                                      .IC1Prescaler = TIM_ICPSC_DIV1,
+                                                      .IC1Filter = 0UL,
+                                                      .IC2Polarity = TIM_ICPOLARITY_RISING,
+                                                      .IC2Selection = TIM_ICSELECTION_DIRECTTI,
+                                                      .IC2Prescaler = TIM_ICPSC_DIV1,
+                                                      .IC2Filter = 0UL};
+        HAL_TIM_Encoder_Init(&cnt_handle, &encoder_config);
+
+        axis_handles[0].Instance = TIM1;
+        axis_handles[1].Instance = TIM5;
+        axis_handles[2].Instance = TIM8;
+        for (auto& handle : axis_handles) {
+            handle.Init.Period = 0xFFFFUL;
+            HAL_TIM_Encoder_Init(&handle, &encoder_config);
+        }
+
+        // 10 kHz sampling from the 84 MHz APB1 timer clock
+        trigger_handle.Instance = TIM2;
+        trigger_handle.Init.Period = 8399UL;
+        HAL_TIM_Base_Init(&trigger_handle);
+
+        i2c_device = I2CDevice{.i2c_bus = &i2c_handle, .dev_address = EEPROM_ADDRESS};
+        large_eeprom_device = I2CDevice{.i2c_bus = &i2c_handle,
+                                        .dev_address = LARGE_EEPROM_ADDRESS,
+                                        .mem_address_size = I2C_MEMADD_SIZE_16BIT};
+        i2c_eeprom = I2CEEPROM{.device = large_eeprom_device,
+                               .page_size = LARGE_EEPROM_PAGE,
+                               .memory_size = large_eeprom.size()};
+        spi_device = SPIDevice<>{.chip_select = GPIO::PA4, .spi_bus = &spi_handle};
+        flash_device = SPIDevice<FlashProtocol>{.chip_select = GPIO::PA4, .spi_bus = &spi_handle};
+        i2c_registers = RegisterCache<I2CDevice, 16UL>{.device = i2c_device, .base_address = 0x20U};
+        i2c_registers.set_volatile(0x2FU);
+        spi_dma_device.chip_select = GPIO::PA4;
+        spi_dma_device.spi_bus = &spi_handle;
+        imu_stream.spi_bus = &imu_handle;
+        imu_stream.chip_select = GPIO::PB12;
+        imu_stream.data_ready = GPIO::PB0;
+        imu_stream.read_command = 0x80U | 0x1FU;
+        imu_fifo_stream.spi_bus = &imu_handle;
+        imu_fifo_stream.chip_select = GPIO::PB12;
+        imu_fifo_stream.data_ready = GPIO::PB1;
+        imu_fifo_stream.read_command = 0x80U | 0x30U;
+        imu_fifo_stream.frame_interval = SystemCoreClock / IMU_RATE;
+        i2c_bus.i2c_bus = &i2c_handle;
+        i2c_bus.use_dma = true;
+        i2c_scanner.bus = &i2c_bus;
+        shared_bus.spi_bus = &shared_handle;
+        // SPI3 runs from the 42 MHz APB1, so the flash gets the 21 MHz of the smallest prescaler
+        dac = SPIBusDevice{.chip_select = GPIO::PC0,
+                           .config = SPIConfig::from_mode(&shared_handle, 1U, 20000000UL),
+                           .priority = 1U};
+        flash = SPIBusDevice{.chip_select = GPIO::PC1, .config = SPIConfig::from_mode(&shared_handle, 0U, 42000000UL)};
+        adc = SPIBusDevice{.chip_select = GPIO::PC2, .config = SPIConfig::from_mode(&shared_handle, 3U, 5000000UL)};
+        pwm_device = PWMDevice{.timer = &pwm_handle, .channel_mask = TIM_CHANNEL_1};
+        cnt_device = CNTDevice{.timer = &cnt_handle};
+        for (auto axis = 0UL; axis < axis_devices.size(); ++axis) {
+            axis_devices[axis] = CNTDevice{.timer = &axis_handles[axis]};
+        }
+        cnt_sampler.trigger = &trigger_handle;
+        cnt_sampler.encoders = {&cnt_device, &axis_devices[0], &axis_devices[1], &axis_devices[2]};
+        // TIM2 TRGO reaches TIM4, TIM1 and TIM8 on ITR1 and TIM5 on ITR0
+        cnt_sampler.trigger_inputs = {TIM_TS_ITR1, TIM_TS_ITR1, TIM_TS_ITR0, TIM_TS_ITR1};
+
+        cnt_sampler.initialize();
+        pwm_device.initialize();
+        cnt_device.initialize();
+        for (auto& device : axis_devices) {
+            device.initialize();
+        }
+        spi_dma_device.initialize();
+    }
+
+    void bench_i2c_device() noexcept
+    {
+        auto data = std::array<std::uint8_t, 16UL>{};
+
+        print_header("I2CDevice");
+        measure("transmit_bytes<4>", Sim::Bus::I2C, [] {
+            i2c_device.transmit_bytes(std::array<std::uint8_t, 4UL>{0x10U, 1U, 2U, 3U});
+        });
+        measure("transmit_bytes(16)", Sim::Bus::I2C, [&] { i2c_device.transmit_bytes(data.data(), data.size()); });
+        measure("transmit_byte", Sim::Bus::I2C, [] { i2c_device.transmit_byte(0x10U); });
+        measure("receive_bytes<4>", Sim::Bus::I2C, [] { (void)i2c_device.receive_bytes<4UL>(); });
+        measure("receive_bytes(16)", Sim::Bus::I2C, [&] { i2c_device.receive_bytes(data.data(), data.size()); });
+        measure("receive_byte", Sim::Bus::I2C, [] { (void)i2c_device.receive_byte(); });
+        measure("read_bytes<4>", Sim::Bus::I2C, [] { (void)i2c_device.read_bytes<4UL>(0x20U); });
+        measure("read_bytes(16)", Sim::Bus::I2C, [&] { i2c_device.read_bytes(0x20U, data.data(), data.size()); });
+        measure("read_byte", Sim::Bus::I2C, [] { (void)i2c_device.read_byte(0x20U); });
+        measure("write_bytes<4>", Sim::Bus::I2C, [] {
+            i2c_device.write_bytes(0x20U, std::array<std::uint8_t, 4UL>{1U, 2U, 3U, 4U});
+        });
+        measure("write_bytes(16)", Sim::Bus::I2C, [&] { i2c_device.write_bytes(0x20U, data.data(), data.size()); });
+        measure("write_byte", Sim::Bus::I2C, [] { i2c_device.write_byte(0x20U, 0x55U); });
+        measure("bus_scan", Sim::Bus::I2C, [] { (void)i2c_device.bus_scan(); });
+    }
+
+    void bench_i2c_eeprom() noexcept
+    {
+        auto pointer = std::array<std::uint8_t, 2UL>{0x12U, 0x34U};
+        auto data = std::array<std::uint8_t, 16UL>{};
+        auto page = std::array<std::uint8_t, 100UL>{};
+
+        print_header("I2CEEPROM");
+        measure("read_bytes(16), 16 bit address", Sim::Bus::I2C, [&] {
+            large_eeprom_device.read_bytes(0x1234U, data.data(), data.size());
+        });
+        measure("transmit + receive(16)", Sim::Bus::I2C, [&] {
+            (void)large_eeprom_device.transmit_bytes(pointer.data(), pointer.size()).and_then([&] {
+                return large_eeprom_device.receive_bytes(data.data(), data.size());
+            });
+        });
+        measure("transfer_segments, write + read(16)", Sim::Bus::I2C, [&] {
+            (void)large_eeprom_device.transfer_segments({
+                I2CSegment{.direction = I2CDirection::WRITE, .data = pointer.data(), .size = pointer.size()},
+                I2CSegment{.direction = I2CDirection::READ, .data = data.data(), .size = data.size()},
+            });
+        });
+        measure("write_bytes per page + HAL_Delay(5)", Sim::Bus::I2C, [&] {
+            for (auto offset = 0UL; offset < page.size();) {
+                auto const address = 100UL + offset;
+                auto const chunk = std::min(page.size() - offset, LARGE_EEPROM_PAGE - address % LARGE_EEPROM_PAGE);
+                large_eeprom_device.write_bytes(static_cast<std::uint16_t>(address), page.data() + offset, chunk);
+                HAL_Delay(5UL);
+                offset += chunk;
+            }
+        });
+        measure("write(100), ACK polling", Sim::Bus::I2C, [&] {
+            (void)i2c_eeprom.write(100U, page.data(), page.size());
+        });
+
+        auto const past_end = static_cast<std::uint16_t>(large_eeprom.size() - 50UL);
+        auto const written = i2c_eeprom.write(past_end, page.data(), page.size());
+        std::printf("%-30s %s\n", "write(100) past the end", written ? "accepted" : "rejected");
+    }
+
+    void bench_register_cache() noexcept
+    {
+        print_header("RegisterCache<I2CDevice>");
+        measure("uncached read-modify-write", Sim::Bus::I2C, [] {
+            (void)i2c_device.read_byte(0x21U).and_then(
+                [](std::uint8_t const data) { return i2c_device.write_byte(0x21U, static_cast<std::uint8_t>(data ^ 0x01U)); });
+        });
+        measure("modify_byte", Sim::Bus::I2C, [] { (void)i2c_registers.modify_byte(0x21U, 0x01U, 0x01U); });
+        measure("4 x modify_byte + flush", Sim::Bus::I2C, [] {
+            for (std::uint8_t address = 0x21U; address < 0x25U; ++address) {
+                auto const bits = static_cast<std::uint8_t>(~i2c_registers.values[address - 0x20U]);
+                (void)i2c_registers.modify_byte(address, 0x01U, bits);
+            }
+            (void)i2c_registers.flush();
+        });
+        measure("volatile read_byte", Sim::Bus::I2C, [] { (void)i2c_registers.read_byte(0x2FU); });
+        measure("write_fields, device", Sim::Bus::I2C, [] {
+            (void)write_fields(i2c_device, CTRL_MODE{2U}, CTRL_RATE{5U});
+        });
+        measure("write_fields, cache", Sim::Bus::I2C, [] {
+            (void)write_fields(i2c_registers, CTRL_MODE{2U}, CTRL_RATE{5U});
+        });
+    }
+
+    void bench_i2c_faults() noexcept
+    {
+        static auto absent_device = I2CDevice{.i2c_bus = &i2c_handle, .dev_address = EEPROM_ADDRESS + 1U};
+        static auto recovering_device = I2CDevice{.i2c_bus = &i2c_handle,
+                                                  .dev_address = EEPROM_ADDRESS,
+                                                  .retry = I2CRetryPolicy{.attempts = 2U, .backoff_microseconds = 10UL},
+                                                  .scl = GPIO::PB6,
+                                                  .sda = GPIO::PB7};
+
+        print_header("I2CDevice faults");
+        measure("read_byte, absent device", Sim::Bus::I2C, [] { (void)absent_device.read_byte(0x20U); });
+        measure("read_byte, held bus", Sim::Bus::I2C, [] {
+            Sim::hold_i2c_bus(&i2c_handle);
+            (void)i2c_device.read_byte(0x20U);
+        });
+        measure("read_byte, held bus, recovery", Sim::Bus::I2C, [] {
+            Sim::hold_i2c_bus(&i2c_handle);
+            (void)recovering_device.read_byte(0x20U);
+        });
+
+        HAL_I2C_Init(&i2c_handle);
+    }
+
+    void bench_spi_device() noexcept
+    {
+        auto data = std::array<std::uint8_t, 16UL>{};
+
+        print_header("SPIDevice");
+        measure("transmit_bytes<4>", Sim::Bus::SPI, [] {
+            spi_device.transmit_bytes(std::array<std::uint8_t, 4UL>{1U, 2U, 3U, 4U});
+        });
+        measure("transmit_bytes(16)", Sim::Bus::SPI, [&] { spi_device.transmit_bytes(data.data(), data.size()); });
+        measure("transmit_byte", Sim::Bus::SPI, [] { spi_device.transmit_byte(0x10U); });
+        measure("receive_bytes<4>", Sim::Bus::SPI, [] { (void)spi_device.receive_bytes<4UL>(); });
+        measure("receive_bytes(16)", Sim::Bus::SPI, [&] { spi_device.receive_bytes(data.data(), data.size()); });
+        measure("receive_byte", Sim::Bus::SPI, [] { (void)spi_device.receive_byte(); });
+        measure("read_bytes<4>", Sim::Bus::SPI, [] { (void)spi_device.read_bytes<4UL>(0x20U); });
+        measure("read_bytes(16)", Sim::Bus::SPI, [&] { spi_device.read_bytes(0x20U, data.data(), data.size()); });
+        measure("read_byte", Sim::Bus::SPI, [] { (void)spi_device.read_byte(0x20U); });
+        measure("write_bytes<4>", Sim::Bus::SPI, [] {
+            spi_device.write_bytes(0x20U, std::array<std::uint8_t, 4UL>{1U, 2U, 3U, 4U});
+        });
+        measure("write_bytes(16)", Sim::Bus::SPI, [&] { spi_device.write_bytes(0x20U, data.data(), data.size()); });
+        measure("write_byte", Sim::Bus::SPI, [] { spi_device.write_byte(0x20U, 0x55U); });
+        measure("read_bytes<16> 16 bit address", Sim::Bus::SPI, [] {
+            (void)flash_device.read_bytes<16UL>(0x1234U);
+        });
+        measure("read_bytes(16) 16 bit address", Sim::Bus::SPI, [&] {
+            flash_device.read_bytes(0x1234U, data.data(), data.size());
+        });
+    }
+
+    void bench_async() noexcept
+    {
+        auto tx_data = std::array<std::uint8_t, 16UL>{};
+        auto rx_data = std::array<std::uint8_t, 16UL>{};
+
+        print_header("SPIDMADevice / I2CBus");
+        measure("SPIDMADevice::submit(16)", Sim::Bus::SPI, [&] {
+            spi_dma_device.submit(SPITransfer{.tx_data = tx_data.data(),
+                                              .rx_data = rx_data.data(),
+                                              .size = tx_data.size(),
+                                              .callback = transfer_done});
+            Sim::run_until_idle();
+        });
+        measure("I2CBus::enqueue_read(16)", Sim::Bus::I2C, [&] {
+            i2c_bus.enqueue_read(i2c_device, 0x20U, rx_data.data(), rx_data.size(), transfer_done);
+            Sim::run_until_idle();
+        });
+        measure("I2CBus::enqueue_write(16)", Sim::Bus::I2C, [&] {
+            i2c_bus.enqueue_write(i2c_device, 0x20U, tx_data.data(), tx_data.size(), transfer_done);
+            Sim::run_until_idle();
+        });
+        measure("I2CScanner::start", Sim::Bus::I2C, [] {
+            i2c_scanner.start();
+            Sim::run_until_idle();
+        });
+        measure("I2CScanner::rescan(0x50-0x57)", Sim::Bus::I2C, [] {
+            i2c_scanner.invalidate(0x50U, 0x57U);
+            i2c_scanner.rescan();
+            Sim::run_until_idle();
+        });
+    }
+
+    void bench_spi_throughput() noexcept
+    {
+        static auto data = std::array<std::uint8_t, 4096UL>{};
+
+        std::printf("\n%-30s %5s %12s %12s %12s\n", "SPI blocking vs DMA", "bytes", "bytes/s", "cpu idle %", "cpu ns");
+
+        for (auto const size : {16UL, 64UL, 256UL, 1024UL, 4096UL}) {
+            measure_throughput("SPIDevice::transmit_bytes", size, [=] {
+                spi_device.transmit_bytes(data.data(), size);
+            });
+            measure_throughput("SPIDMADevice::submit", size, [=] {
+                spi_dma_device.submit(SPITransfer{.tx_data = data.data(), .size = size, .callback = transfer_done});
+            });
+        }
+
+        auto const oversized = SPITransfer{.tx_data = data.data(), .size = SPIDMADevice::MAX_TRANSFER_SIZE + 1UL};
+        auto const accepted = spi_dma_device.submit(oversized);
+        std::printf("%-30s %s\n", "SPIDMADevice::submit(65536)", accepted ? "accepted" : "rejected");
+    }
+
+    void bench_spi_bus() noexcept
+    {
+        static auto tx_data = std::array<std::uint8_t, 4UL>{1U, 2U, 3U, 4U};
+        static auto rx_data = std::array<std::uint8_t, 4UL>{};
+
+        auto const devices = std::array<SPIBusDevice const*, 3UL>{&dac, &flash, &adc};
+
+        print_header("SPIBus (DAC / flash / ADC)");
+        measure("HAL_SPI_Init switch + transmit(4) x3", Sim::Bus::SPI, [&] {
+            for (auto const device : devices) {
+                shared_handle.Init.CLKPolarity = device->config.polarity;
+                shared_handle.Init.CLKPhase = device->config.phase;
+                shared_handle.Init.BaudRatePrescaler = device->config.prescaler;
+                HAL_SPI_Init(&shared_handle);
+                HAL_SPI_Transmit(&shared_handle, tx_data.data(), tx_data.size(), HAL_MAX_DELAY);
+            }
+        });
+        measure("acquire + transmit(4) x3", Sim::Bus::SPI, [&] {
+            for (auto const device : devices) {
+                if (shared_bus.acquire(*device)) {
+                    HAL_SPI_Transmit(&shared_handle, tx_data.data(), tx_data.size(), HAL_MAX_DELAY);
+                    shared_bus.release();
+                }
+            }
+        });
+
+        shared_bus.reset_stats();
+        measure("enqueue_transfer(4) x12 interleaved", Sim::Bus::SPI, [&] {
+            for (auto index = 0UL; index < 12UL; ++index) {
+                auto const device = index % 3UL == 0UL ? &flash : &adc;
+                shared_bus.enqueue_transfer(*device, tx_data.data(), rx_data.data(), rx_data.size(), transfer_done);
+            }
+            Sim::run_until_idle();
+        });
+
+        auto const stats = shared_bus.get_stats();
+        std::printf("%-36s %10.2f reconfigurations per 12 transfers\n",
+                    "",
+                    static_cast<double>(stats.reconfigurations) / ITERATIONS);
+
+        shared_bus.reset_stats();
+        measure("enqueue_transfer(4) x12 + DAC priority", Sim::Bus::SPI, [&] {
+            for (auto index = 0UL; index < 12UL; ++index) {
+                auto const device = devices[index % devices.size()];
+                shared_bus.enqueue_transfer(*device, tx_data.data(), rx_data.data(), rx_data.size(), transfer_done);
+            }
+            Sim::run_until_idle();
+        });
+    }
+
+    void bench_ring_buffer() noexcept
+    {
+        static auto spsc = SPSCRingBuffer<std::uint16_t, 64UL>{};
+        static auto mpsc = MPSCRingBuffer<std::uint16_t, 64UL>{};
+
+        auto samples = std::array<std::uint16_t, 16UL>{};
+
+        print_header("SPSCRingBuffer / MPSCRingBuffer");
+        measure("SPSC 16 x push + 16 x pop", std::nullopt, [] {
+            for (auto sample = std::uint16_t{0U}; sample < 16U; ++sample) {
+                spsc.push(sample);
+            }
+            while (spsc.pop().has_value()) {
+            }
+        });
+        measure("SPSC push_bulk(16) + pop_bulk(16)", std::nullopt, [&] {
+            spsc.push_bulk(samples);
+            spsc.pop_bulk(samples);
+        });
+        measure("SPSC prepare/commit + peek/consume", std::nullopt, [] {
+            auto const space = spsc.prepare();
+            std::fill(space.begin(), space.end(), std::uint16_t{0x55U});
+            spsc.commit(space.size());
+            spsc.consume(spsc.peek().size());
+        });
+        measure("MPSC 16 x push + pop_bulk(16)", std::nullopt, [&] {
+            for (auto sample = std::uint16_t{0U}; sample < 16U; ++sample) {
+                mpsc.push(sample);
+            }
+            mpsc.pop_bulk(samples);
+        });
+    }
+
+    Task<> spi_task(std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        for (auto transfer = 0UL; transfer < 4UL; ++transfer) {
+            (void)co_await async_transmit(spi_dma_device, data, size);
+        }
+    }
+
+    Task<> i2c_task(std::uint8_t* const data, std::size_t const size) noexcept
+    {
+        for (auto transfer = 0UL; transfer < 4UL; ++transfer) {
+            (void)co_await async_read(i2c_bus, i2c_device, 0x20U, data, size);
+        }
+    }
+
+    Task<> sequential_task(std::uint8_t* const tx_data, std::uint8_t* const rx_data, std::size_t const size) noexcept
+    {
+        co_await spi_task(tx_data, size);
+        co_await i2c_task(rx_data, size);
+    }
+
+    void bench_coroutine() noexcept
+    {
+        static auto scheduler = Scheduler{};
+
+        auto tx_data = std::array<std::uint8_t, 16UL>{};
+        auto rx_data = std::array<std::uint8_t, 16UL>{};
+
+        print_header("Scheduler");
+        measure("spawn + run, yield", std::nullopt, [] {
+            scheduler.spawn([]() noexcept -> Task<> { co_await async_yield(); }());
+            scheduler.run();
+        });
+        measure("4 x SPI(16), 4 x I2C(16), sequential", Sim::Bus::I2C, [&] {
+            scheduler.spawn(sequential_task(tx_data.data(), rx_data.data(), tx_data.size()));
+            scheduler.run();
+        });
+        measure("4 x SPI(16), 4 x I2C(16), overlapped", Sim::Bus::I2C, [&] {
+            scheduler.spawn(spi_task(tx_data.data(), tx_data.size()));
+            scheduler.spawn(i2c_task(rx_data.data(), rx_data.size()));
+            scheduler.run();
+        });
+    }
+
+    void print_stream_stats(char const* const name, SPIStreamStats const& stats) noexcept
+    {
+        std::printf("%-36s %10lu samples %8lu overruns %8lu dropped %8lu errors\n",
+                    name,
+                    static_cast<unsigned long>(stats.samples),
+                    static_cast<unsigned long>(stats.overruns),
+                    static_cast<unsigned long>(stats.dropped),
+                    static_cast<unsigned long>(stats.errors));
+        std::printf("%-36s %10lu min %8lu mean %8lu max %8lu jitter interval cycles\n",
+                    "",
+                    static_cast<unsigned long>(stats.interval.min_cycles),
+                    static_cast<unsigned long>(stats.interval.get_mean()),
+                    static_cast<unsigned long>(stats.interval.max_cycles),
+                    static_cast<unsigned long>(stats.get_jitter()));
+        std::printf("%-36s %10lu min %8lu mean %8lu p99 %8lu max latency cycles\n",
+                    "",
+                    static_cast<unsigned long>(stats.latency.min_cycles),
+                    static_cast<unsigned long>(stats.latency.get_mean()),
+                    static_cast<unsigned long>(stats.latency.get_p99()),
+                    static_cast<unsigned long>(stats.latency.max_cycles));
+    }
+
+    void bench_spi_stream() noexcept
+    {
+        print_header("SPIStream");
+
+        imu_stream.start();
+        Sim::start_exti(GPIO_PIN_0, IMU_PERIOD);
+        measure("3.2 kHz data-ready, pop", Sim::Bus::SPI, [] {
+            Sim::advance(IMU_PERIOD);
+            while (imu_stream.samples.pop().has_value()) {
+            }
+        });
+        auto const idle_stats = imu_stream.get_stats();
+
+        // edges held back by the critical section show up as jitter, not as lost samples
+        Sim::advance(IMU_PERIOD / 2ULL);
+        imu_stream.reset_stats();
+        measure("3.2 kHz data-ready, 200 us masked / 2", Sim::Bus::SPI, [] {
+            static auto masked = false;
+            if (masked = !masked; masked) {
+                auto const critical_section = CriticalSection{};
+                Sim::advance(200000ULL);
+            } else {
+                Sim::advance(200000ULL);
+            }
+            Sim::advance(IMU_PERIOD - 200000ULL);
+            while (imu_stream.samples.pop().has_value()) {
+            }
+        });
+        auto const masked_stats = imu_stream.get_stats();
+        Sim::stop_exti(GPIO_PIN_0);
+        imu_stream.stop();
+
+        imu_fifo_stream.start();
+        Sim::start_exti(GPIO_PIN_1, 8ULL * IMU_PERIOD);
+        measure("400 Hz FIFO watermark(8), pop_bulk", Sim::Bus::SPI, [] {
+            auto batch = std::array<SPIStreamSample<12UL>, 8UL>{};
+            Sim::advance(8ULL * IMU_PERIOD);
+            imu_fifo_stream.samples.pop_bulk(batch);
+        });
+        Sim::stop_exti(GPIO_PIN_1);
+        imu_fifo_stream.stop();
+
+        std::printf("\n");
+        print_stream_stats("SPIStream, idle", idle_stats);
+        print_stream_stats("SPIStream, 200 us masked / 2", masked_stats);
+        print_stream_stats("SPIStream, FIFO watermark", imu_fifo_stream.get_stats());
+    }
+
+    void bench_pwm_device() noexcept
+    {
+        print_header("PWMDevice");
+        measure("get_period", std::nullopt, [] { (void)pwm_device.get_period(); });
+        measure("set_frequency", std::nullopt, [] { (void)pwm_device.set_frequency(20000UL); });
+        measure("set_timing", std::nullopt, [] {
+            pwm_device.set_timing(PWMTiming{.prescaler = 3UL, .period = 999UL, .error_ppm = 0L});
+        });
+        measure("set_prescaler", std::nullopt, [] { pwm_device.set_prescaler(3UL); });
+        measure("set_period", std::nullopt, [] { pwm_device.set_period(999UL); });
+        measure("set_compare_min", std::nullopt, [] { pwm_device.set_compare_min(); });
+        measure("set_compare_max", std::nullopt, [] { pwm_device.set_compare_max(); });
+        measure("set_compare_half", std::nullopt, [] { pwm_device.set_compare_half(); });
+        measure("set_compare_raw", std::nullopt, [] { pwm_device.set_compare_raw(500UL); });
+        measure("set_compare_voltage", std::nullopt, [] { pwm_device.set_compare_voltage(1.65F32); });
+    }
+
+    void bench_cnt_device() noexcept
+    {
+        auto timestamp = std::uint32_t{0UL};
+
+        print_header("CNTDevice");
+        measure("get_count", std::nullopt, [] { (void)cnt_device.get_count(); });
+        measure("get_count_difference", std::nullopt, [] {
+            Sim::encoder_step(&cnt_handle, 7);
+            (void)cnt_device.get_count_difference();
+        });
+        measure("get_position", std::nullopt, [] { (void)cnt_device.get_position(); });
+        measure("get_position (wrapping)", std::nullopt, [] {
+            Sim::encoder_step(&cnt_handle, 40000);
+            (void)cnt_device.get_position();
+        });
+        measure("get_snapshot", std::nullopt, [] { (void)cnt_device.get_snapshot(); });
+        measure("sample", std::nullopt, [&] {
+            Sim::encoder_step(&cnt_handle, 3);
+            cnt_device.sample(timestamp += 1000UL);
+        });
+    }
+
+    void bench_cnt_sampler() noexcept
+    {
+        print_header("CNTSampler<4>");
+        cnt_sampler.start();
+        measure("4 x get_position", std::nullopt, [] {
+            (void)cnt_device.get_position();
+            for (auto const& device : axis_devices) {
+                (void)device.get_position();
+            }
+        });
+        measure("get_vector", std::nullopt, [] { (void)cnt_sampler.get_vector(); });
+        measure("update_callback", std::nullopt, [] { cnt_sampler.update_callback(&trigger_handle); });
+        cnt_sampler.stop();
+    }
+
+}; // namespace
+
+extern "C" void* __wrap_malloc(std::size_t size)
+{
+    ++allocations;
+    return __real_malloc(size);
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto const pointer = std::malloc(size == 0UL ? 1UL : size); pointer != nullptr) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_complete_callback(hspi);
+    shared_bus.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_complete_callback(hspi);
+    shared_bus.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_complete_callback(hspi);
+    shared_bus.transfer_complete_callback(hspi);
+    imu_stream.transfer_complete_callback(hspi);
+    imu_fifo_stream.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_error_callback(hspi);
+    shared_bus.transfer_error_callback(hspi);
+    imu_stream.transfer_error_callback(hspi);
+    imu_fifo_stream.transfer_error_callback(hspi);
+}
+
+void HAL_GPIO_EXTI_Callback(std::uint16_t GPIO_Pin)
+{
+    imu_stream.data_ready_callback(GPIO_Pin);
+    imu_fifo_stream.data_ready_callback(GPIO_Pin);
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_error_callback(hi2c);
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim)
+{
+    cnt_device.update_callback(htim);
+    for (auto& device : axis_devices) {
+        device.update_callback(htim);
+    }
+    cnt_sampler.update_callback(htim);
+}
+
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef* htim)
+{
+    cnt_device.capture_callback(htim);
+    for (auto& device : axis_devices) {
+        device.capture_callback(htim);
+    }
+}
+
+int main()
+{
+    setup();
+
+    bench_i2c_device();
+    bench_i2c_eeprom();
+    bench_register_cache();
+    bench_i2c_faults();
+    bench_spi_device();
+    bench_spi_stream();
+    bench_async();
+    bench_spi_throughput();
+    bench_spi_bus();
+    bench_ring_buffer();
+    bench_coroutine();
+    bench_pwm_device();
+    bench_cnt_device();
+    bench_cnt_sampler();
+
+    if constexpr (STATS_ENABLED) {
+        std::printf("\n");
+        print_stats("I2CDevice stats", i2c_device.get_stats());
+        print_stats("SPIDevice stats", spi_device.get_stats());
+    }
+
+    std::printf("\nlog records dropped: %lu\n", static_cast<unsigned long>(log_dropped()));
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
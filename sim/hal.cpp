@@ -0,0 +1,2156 @@
+#include "sim.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <utility>
+
+namespace {
+
+    using Sim::Nanoseconds;
+
+    constexpr std::size_t PERIPH_SIZE = 0x00030000UL;
+
+    constexpr std::uintptr_t CORE_BASE = 0xE0000000UL;
+    constexpr std::size_t CORE_SIZE = 0x00010000UL;
+
+    constexpr Nanoseconds NANOSECONDS_PER_SECOND = 1000000000ULL;
+    constexpr Nanoseconds NANOSECONDS_PER_TICK = 1000000ULL;
+
+    // every polling call (HAL_GetTick, HAL_*_GetState) costs this much virtual time
+    constexpr Nanoseconds POLL_TIME = 1000ULL;
+
+    constexpr std::uint32_t DEFAULT_HCLK = 168000000UL;
+    constexpr std::uint32_t DEFAULT_PCLK1 = 42000000UL;
+    constexpr std::uint32_t DEFAULT_PCLK2 = 84000000UL;
+    constexpr std::uint32_t DEFAULT_I2C_CLOCK = 100000UL;
+
+    // I2C_TIMEOUT_BUSY_FLAG of the HAL
+    constexpr Nanoseconds I2C_BUSY_FLAG_TIMEOUT = 25ULL * NANOSECONDS_PER_TICK;
+
+    // HAL_SPI_Init with its MspInit reconfiguring the pins and DMA streams
+    constexpr Nanoseconds SPI_INIT_TIME = 25000ULL;
+
+    // one HCLK cycle, rounded up
+    constexpr Nanoseconds NOP_TIME = 1ULL;
+
+    // 1-Wire over a half-duplex UART: characters below this rate are reset pulses, the rest time slots
+    constexpr std::uint32_t OW_SLOT_BAUD_RATE = 115200UL;
+
+    // echo of the 0xF0 reset character with a presence pulse over its high bits
+    constexpr std::uint8_t OW_PRESENCE = 0xE0U;
+
+    // echo of a 0xFF read slot a slave held low past the sampling point
+    constexpr std::uint8_t OW_READ_ZERO = 0xF8U;
+
+    using EventHandler = void (*)(void* const object, std::uint32_t const argument) noexcept;
+
+    struct Event {
+        Nanoseconds time = 0ULL;
+        std::uint64_t order = 0ULL;
+        EventHandler handler = nullptr;
+        void* object = nullptr;
+        std::uint32_t argument = 0UL;
+        bool periodic = false;
+        bool pending = false;
+    };
+
+    constexpr std::size_t MAX_EVENTS = 32UL;
+
+    std::array<Event, MAX_EVENTS> events{};
+    std::uint64_t event_order = 0ULL;
+    Nanoseconds current_time = 0ULL;
+    std::uint32_t primask = 0UL;
+    bool dispatching = false;
+
+    std::uint32_t hclk = DEFAULT_HCLK;
+    std::uint32_t pclk1 = DEFAULT_PCLK1;
+    std::uint32_t pclk2 = DEFAULT_PCLK2;
+
+    std::array<Sim::BusStatistics, 3UL> statistics{};
+
+    void schedule(Nanoseconds const delay,
+                  EventHandler const handler,
+                  void* const object,
+                  std::uint32_t const argument,
+                  bool const periodic = false) noexcept
+    {
+        auto const event = std::ranges::find_if(events, [](Event const& candidate) { return !candidate.pending; });
+        if (event == events.end()) {
+            std::fputs("sim: event queue full\n", stderr);
+            std::abort();
+        }
+
+        *event = Event{.time = current_time + delay,
+                       .order = event_order++,
+                       .handler = handler,
+                       .object = object,
+                       .argument = argument,
+                       .periodic = periodic,
+                       .pending = true};
+    }
+
+    void cancel(void* const object) noexcept
+    {
+        for (auto& event : events) {
+            if (event.pending && event.object == object) {
+                event.pending = false;
+            }
+        }
+    }
+
+    Event* next_event() noexcept
+    {
+        auto next = static_cast<Event*>(nullptr);
+
+        for (auto& event : events) {
+            if (event.pending &&
+                (next == nullptr || event.time < next->time || (event.time == next->time && event.order < next->order))) {
+                next = &event;
+            }
+        }
+
+        return next;
+    }
+
+    std::uint64_t time_to_cycles(Nanoseconds const time) noexcept
+    {
+        return time / NANOSECONDS_PER_SECOND * hclk + time % NANOSECONDS_PER_SECOND * hclk / NANOSECONDS_PER_SECOND;
+    }
+
+    // DWT->CYCCNT runs at HCLK once enabled, in step with the virtual clock
+    void set_time(Nanoseconds const time) noexcept
+    {
+        if (time <= current_time) {
+            return;
+        }
+
+        if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0UL) {
+            DWT->CYCCNT = DWT->CYCCNT + static_cast<std::uint32_t>(time_to_cycles(time) - time_to_cycles(current_time));
+        }
+
+        current_time = time;
+    }
+
+    bool can_dispatch() noexcept
+    {
+        return primask == 0UL && !dispatching;
+    }
+
+    void dispatch(Event* const event) noexcept
+    {
+        auto const copy = *event;
+        event->pending = false;
+
+        set_time(copy.time);
+
+        dispatching = true;
+        copy.handler(copy.object, copy.argument);
+        dispatching = false;
+    }
+
+    void dispatch_until(Nanoseconds const time) noexcept
+    {
+        while (can_dispatch()) {
+            auto const event = next_event();
+            if (event == nullptr || event->time > time) {
+                break;
+            }
+
+            dispatch(event);
+        }
+
+        set_time(time);
+    }
+
+    bool has_pending_transfer() noexcept
+    {
+        return std::ranges::any_of(events, [](Event const& candidate) { return candidate.pending && !candidate.periodic; });
+    }
+
+    Nanoseconds bits_to_time(std::uint64_t const bits, std::uint32_t const frequency) noexcept
+    {
+        return frequency == 0UL ? 0ULL : (bits * NANOSECONDS_PER_SECOND + frequency - 1ULL) / frequency;
+    }
+
+    void record(Sim::Bus const bus, std::size_t const bytes, Nanoseconds const duration, bool const ok) noexcept
+    {
+        auto& entry = statistics[std::to_underlying(bus)];
+
+        entry.transfers += 1ULL;
+        entry.bytes += bytes;
+        entry.busy_time += duration;
+        entry.errors += ok ? 0ULL : 1ULL;
+    }
+
+    bool is_apb2(void const* const instance) noexcept
+    {
+        auto const address = reinterpret_cast<std::uintptr_t>(instance);
+        return address >= APB2PERIPH_BASE && address < AHB1PERIPH_BASE;
+    }
+
+    std::uint32_t get_pclk(void const* const instance) noexcept
+    {
+        return is_apb2(instance) ? pclk2 : pclk1;
+    }
+
+    std::uint32_t ppre_bits(std::uint32_t const divider) noexcept
+    {
+        switch (divider) {
+            case 2UL:
+                return 4UL;
+            case 4UL:
+                return 5UL;
+            case 8UL:
+                return 6UL;
+            case 16UL:
+                return 7UL;
+            default:
+                return 0UL;
+        }
+    }
+
+    void write_clock_configuration() noexcept
+    {
+        SystemCoreClock = hclk;
+
+        auto const apb1 = ppre_bits(pclk1 == 0UL ? 1UL : hclk / pclk1);
+        auto const apb2 = ppre_bits(pclk2 == 0UL ? 1UL : hclk / pclk2);
+
+        MODIFY_REG(RCC->CFGR, RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2, (apb1 << 10U) | (apb2 << 13U));
+    }
+
+    void map_region(std::uintptr_t const address, std::size_t const size) noexcept
+    {
+        auto const base = reinterpret_cast<void*>(address);
+        auto const mapping =
+            mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (mapping != base) {
+            std::perror("sim: cannot map peripheral region");
+            std::abort();
+        }
+    }
+
+    __attribute__((constructor(101))) void map_peripherals() noexcept
+    {
+        map_region(PERIPH_BASE, PERIPH_SIZE);
+        map_region(CORE_BASE, CORE_SIZE);
+
+        write_clock_configuration();
+    }
+
+    /* I2C */
+
+    enum struct I2COperation : std::uint8_t {
+        TRANSMIT,
+        RECEIVE,
+        MEMORY_WRITE,
+        MEMORY_READ,
+    };
+
+    struct I2CRequest {
+        I2COperation operation = I2COperation::TRANSMIT;
+        std::uint16_t dev_address = 0U;
+        std::uint16_t mem_address = 0U;
+        std::uint16_t mem_address_size = 0U;
+        std::uint8_t* data = nullptr;
+        std::uint16_t size = 0U;
+
+        // sequential frames continuing an open transfer skip the start and address, open ones the stop
+        bool start = true;
+        bool stop = true;
+    };
+
+    struct I2CSlave {
+        I2C_HandleTypeDef* i2c_bus = nullptr;
+        std::uint16_t dev_address = 0U;
+        std::uint8_t* memory = nullptr;
+        std::size_t size = 0UL;
+        std::size_t pointer = 0UL;
+
+        std::size_t address_bytes = 1UL;
+        std::size_t page_size = 0UL;
+        Nanoseconds write_time = 0ULL;
+
+        // bytes written since the last start, the first address_bytes of them set the pointer
+        std::size_t received = 0UL;
+        bool written = false;
+        Nanoseconds busy_until = 0ULL;
+    };
+
+    struct I2CPending {
+        I2C_HandleTypeDef* i2c_bus = nullptr;
+        I2CRequest request = {};
+    };
+
+    std::array<I2CSlave, 8UL> i2c_slaves{};
+    std::array<I2CPending, 3UL> i2c_pending{};
+
+    I2CSlave* find_i2c_slave(I2C_HandleTypeDef* const i2c_bus, std::uint16_t const dev_address) noexcept
+    {
+        auto const slave = std::ranges::find_if(i2c_slaves, [=](I2CSlave const& candidate) {
+            return candidate.i2c_bus == i2c_bus && candidate.memory != nullptr && candidate.dev_address == (dev_address >> 1U);
+        });
+
+        return slave == i2c_slaves.end() ? nullptr : &*slave;
+    }
+
+    std::uint32_t i2c_address_bytes(std::uint16_t const mem_address_size) noexcept
+    {
+        return mem_address_size == I2C_MEMADD_SIZE_16BIT ? 2UL : 1UL;
+    }
+
+    Nanoseconds i2c_duration(I2C_HandleTypeDef* const i2c_bus, I2CRequest const& request, bool const acknowledged) noexcept
+    {
+        auto const clock = i2c_bus->Init.ClockSpeed == 0UL ? DEFAULT_I2C_CLOCK : i2c_bus->Init.ClockSpeed;
+
+        // start with the address frame and stop, 9 clocks per frame including ACK
+        auto bits = (request.start ? 1ULL + 9ULL : 0ULL) + (request.stop ? 1ULL : 0ULL);
+
+        if (acknowledged) {
+            switch (request.operation) {
+                case I2COperation::TRANSMIT:
+                case I2COperation::RECEIVE:
+                    bits += 9ULL * request.size;
+                    break;
+                case I2COperation::MEMORY_WRITE:
+                    bits += 9ULL * (i2c_address_bytes(request.mem_address_size) + request.size);
+                    break;
+                case I2COperation::MEMORY_READ:
+                    // repeated start and second address frame
+                    bits += 1ULL + 9ULL * (i2c_address_bytes(request.mem_address_size) + 1ULL + request.size);
+                    break;
+            }
+        }
+
+        return bits_to_time(bits, clock);
+    }
+
+    bool i2c_is_acknowledged(I2C_HandleTypeDef* const i2c_bus, I2CRequest const& request) noexcept
+    {
+        auto const slave = find_i2c_slave(i2c_bus, request.dev_address);
+
+        return slave != nullptr && (!request.start || current_time >= slave->busy_until);
+    }
+
+    void i2c_write_byte(I2CSlave& slave, std::uint8_t const byte) noexcept
+    {
+        if (slave.received < slave.address_bytes) {
+            slave.pointer = ((slave.received == 0UL ? 0UL : slave.pointer << 8U) | byte);
+            slave.received += 1UL;
+            if (slave.received == slave.address_bytes) {
+                slave.pointer %= slave.size;
+            }
+            return;
+        }
+
+        slave.memory[slave.pointer] = byte;
+        slave.written = true;
+
+        if (slave.page_size != 0UL) {
+            auto const page = slave.pointer - slave.pointer % slave.page_size;
+            slave.pointer = page + (slave.pointer + 1UL - page) % slave.page_size;
+        } else {
+            slave.pointer = (slave.pointer + 1UL) % slave.size;
+        }
+    }
+
+    // stop_time - when the stop condition ends the transfer, starting a pending write cycle
+    HAL_StatusTypeDef
+    i2c_execute(I2C_HandleTypeDef* const i2c_bus, I2CRequest const& request, Nanoseconds const stop_time) noexcept
+    {
+        auto const slave = find_i2c_slave(i2c_bus, request.dev_address);
+        auto const acknowledged = i2c_is_acknowledged(i2c_bus, request);
+        auto const duration = i2c_duration(i2c_bus, request, acknowledged);
+
+        record(Sim::Bus::I2C, acknowledged ? request.size : 0UL, duration, acknowledged);
+
+        if (!acknowledged) {
+            i2c_bus->ErrorCode = HAL_I2C_ERROR_AF;
+            return HAL_ERROR;
+        }
+
+        auto data = request.data;
+        auto size = static_cast<std::size_t>(request.size);
+
+        if (request.start) {
+            slave->received = 0UL;
+        }
+
+        switch (request.operation) {
+            case I2COperation::TRANSMIT:
+                for (; size > 0UL; --size) {
+                    i2c_write_byte(*slave, *data++);
+                }
+                break;
+            case I2COperation::RECEIVE:
+                for (; size > 0UL; --size) {
+                    *data++ = slave->memory[slave->pointer];
+                    slave->pointer = (slave->pointer + 1UL) % slave->size;
+                }
+                break;
+            case I2COperation::MEMORY_WRITE:
+                slave->pointer = request.mem_address % slave->size;
+                slave->received = slave->address_bytes;
+                for (; size > 0UL; --size) {
+                    i2c_write_byte(*slave, *data++);
+                }
+                break;
+            case I2COperation::MEMORY_READ:
+                slave->pointer = request.mem_address % slave->size;
+                for (; size > 0UL; --size) {
+                    *data++ = slave->memory[slave->pointer];
+                    slave->pointer = (slave->pointer + 1UL) % slave->size;
+                }
+                break;
+        }
+
+        if (request.stop && std::exchange(slave->written, false)) {
+            slave->busy_until = stop_time + slave->write_time;
+        }
+
+        i2c_bus->ErrorCode = HAL_I2C_ERROR_NONE;
+        return HAL_OK;
+    }
+
+    bool i2c_wait_bus(I2C_HandleTypeDef* const i2c_bus) noexcept
+    {
+        if ((i2c_bus->Instance->SR2 & I2C_SR2_BUSY) != 0UL) {
+            dispatch_until(current_time + I2C_BUSY_FLAG_TIMEOUT);
+            record(Sim::Bus::I2C, 0UL, 0ULL, false);
+            return false;
+        }
+        return true;
+    }
+
+    HAL_StatusTypeDef i2c_blocking(I2C_HandleTypeDef* const i2c_bus, I2CRequest const& request) noexcept
+    {
+        if (i2c_bus->State != HAL_I2C_STATE_READY || !i2c_wait_bus(i2c_bus)) {
+            return HAL_BUSY;
+        }
+
+        auto const end = current_time + i2c_duration(i2c_bus, request, i2c_is_acknowledged(i2c_bus, request));
+
+        auto const result = i2c_execute(i2c_bus, request, end);
+        i2c_bus->PreviousState = HAL_I2C_STATE_RESET;
+
+        dispatch_until(end);
+
+        return result;
+    }
+
+    void i2c_complete(void* const object, std::uint32_t const) noexcept
+    {
+        auto& pending = *static_cast<I2CPending*>(object);
+        auto const i2c_bus = std::exchange(pending.i2c_bus, nullptr);
+        auto const result = i2c_execute(i2c_bus, pending.request, current_time);
+
+        // an open sequential transfer remembers its direction, a NACK ends it with a stop
+        auto const receiving = pending.request.operation == I2COperation::RECEIVE;
+        i2c_bus->PreviousState = result == HAL_OK && !pending.request.stop
+                                     ? (receiving ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX)
+                                     : HAL_I2C_STATE_RESET;
+        i2c_bus->State = HAL_I2C_STATE_READY;
+
+        if (result != HAL_OK) {
+            HAL_I2C_ErrorCallback(i2c_bus);
+            return;
+        }
+
+        switch (pending.request.operation) {
+            case I2COperation::TRANSMIT:
+                HAL_I2C_MasterTxCpltCallback(i2c_bus);
+                break;
+            case I2COperation::RECEIVE:
+                HAL_I2C_MasterRxCpltCallback(i2c_bus);
+                break;
+            case I2COperation::MEMORY_WRITE:
+                HAL_I2C_MemTxCpltCallback(i2c_bus);
+                break;
+            case I2COperation::MEMORY_READ:
+                HAL_I2C_MemRxCpltCallback(i2c_bus);
+                break;
+        }
+    }
+
+    HAL_StatusTypeDef i2c_start(I2C_HandleTypeDef* const i2c_bus, I2CRequest const& request) noexcept
+    {
+        if (i2c_bus->State != HAL_I2C_STATE_READY || !i2c_wait_bus(i2c_bus)) {
+            return HAL_BUSY;
+        }
+
+        auto const pending =
+            std::ranges::find_if(i2c_pending, [](I2CPending const& candidate) { return candidate.i2c_bus == nullptr; });
+        if (pending == i2c_pending.end()) {
+            return HAL_BUSY;
+        }
+
+        *pending = I2CPending{.i2c_bus = i2c_bus, .request = request};
+
+        // like the HAL's _IT and _DMA starts, so a queued transfer hides the error of the one before
+        i2c_bus->ErrorCode = HAL_I2C_ERROR_NONE;
+
+        auto const reading =
+            request.operation == I2COperation::RECEIVE || request.operation == I2COperation::MEMORY_READ;
+        i2c_bus->State = reading ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+
+        schedule(i2c_duration(i2c_bus, request, i2c_is_acknowledged(i2c_bus, request)), i2c_complete, &*pending, 0UL);
+
+        return HAL_OK;
+    }
+
+    // like the F4 HAL: a first frame or a change of direction restarts, a last frame stops
+    HAL_StatusTypeDef i2c_sequence(I2C_HandleTypeDef* const i2c_bus,
+                                   I2COperation const operation,
+                                   std::uint16_t const dev_address,
+                                   std::uint8_t* const data,
+                                   std::uint16_t const size,
+                                   std::uint32_t const options) noexcept
+    {
+        auto const direction = operation == I2COperation::RECEIVE ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+        auto const first = options == I2C_FIRST_FRAME || options == I2C_FIRST_AND_NEXT_FRAME ||
+                           options == I2C_FIRST_AND_LAST_FRAME;
+
+        i2c_bus->XferOptions = options;
+
+        return i2c_start(i2c_bus,
+                         I2CRequest{.operation = operation,
+                                    .dev_address = dev_address,
+                                    .data = data,
+                                    .size = size,
+                                    .start = first || i2c_bus->PreviousState != direction,
+                                    .stop = options == I2C_LAST_FRAME || options == I2C_FIRST_AND_LAST_FRAME});
+    }
+
+    /* SPI */
+
+    enum struct SPIOperation : std::uint8_t {
+        TRANSMIT,
+        RECEIVE,
+        TRANSMIT_RECEIVE,
+    };
+
+    struct SPIPeer {
+        SPI_HandleTypeDef* spi_bus = nullptr;
+        Sim::SPIResponder responder = nullptr;
+        void* context = nullptr;
+    };
+
+    struct SPIPending {
+        SPI_HandleTypeDef* spi_bus = nullptr;
+        SPIOperation operation = SPIOperation::TRANSMIT;
+        std::uint8_t const* tx_data = nullptr;
+        std::uint8_t* rx_data = nullptr;
+        std::uint16_t size = 0U;
+    };
+
+    std::array<SPIPeer, 3UL> spi_peers{};
+    std::array<SPIPending, 3UL> spi_pending{};
+
+    // HAL sizes count frames, DFF selects 16 bit ones
+    std::size_t spi_frame_size(SPI_HandleTypeDef* const spi_bus) noexcept
+    {
+        return (spi_bus->Instance->CR1 & SPI_CR1_DFF) != 0UL ? 2UL : 1UL;
+    }
+
+    Nanoseconds spi_duration(SPI_HandleTypeDef* const spi_bus, std::size_t const size) noexcept
+    {
+        auto const prescaler = 2UL << ((spi_bus->Instance->CR1 & SPI_CR1_BR) >> 3U);
+
+        return bits_to_time(8ULL * size * spi_frame_size(spi_bus) * prescaler, get_pclk(spi_bus->Instance));
+    }
+
+    void spi_exchange(SPI_HandleTypeDef* const spi_bus,
+                      std::uint8_t const* const tx_data,
+                      std::uint8_t* const rx_data,
+                      std::size_t const size) noexcept
+    {
+        auto const peer =
+            std::ranges::find_if(spi_peers, [=](SPIPeer const& candidate) { return candidate.spi_bus == spi_bus; });
+
+        for (auto index = 0UL; index < size * spi_frame_size(spi_bus); ++index) {
+            auto const tx_byte = tx_data != nullptr ? tx_data[index] : std::uint8_t{0xFFU};
+            auto const rx_byte = peer != spi_peers.end() && peer->responder != nullptr
+                                     ? peer->responder(peer->context, tx_byte)
+                                     : std::uint8_t{0xFFU};
+
+            if (rx_data != nullptr) {
+                rx_data[index] = rx_byte;
+            }
+        }
+
+        record(Sim::Bus::SPI, size * spi_frame_size(spi_bus), spi_duration(spi_bus, size), true);
+    }
+
+    HAL_StatusTypeDef spi_blocking(SPI_HandleTypeDef* const spi_bus,
+                                   std::uint8_t const* const tx_data,
+                                   std::uint8_t* const rx_data,
+                                   std::uint16_t const size) noexcept
+    {
+        if (spi_bus->State != HAL_SPI_STATE_READY) {
+            return HAL_BUSY;
+        }
+        if (size == 0U) {
+            return HAL_ERROR;
+        }
+
+        auto const start = current_time;
+        spi_exchange(spi_bus, tx_data, rx_data, size);
+        dispatch_until(start + spi_duration(spi_bus, size));
+
+        return HAL_OK;
+    }
+
+    void spi_complete(void* const object, std::uint32_t const) noexcept
+    {
+        auto& pending = *static_cast<SPIPending*>(object);
+        auto const spi_bus = std::exchange(pending.spi_bus, nullptr);
+
+        spi_exchange(spi_bus, pending.tx_data, pending.rx_data, pending.size);
+        spi_bus->State = HAL_SPI_STATE_READY;
+
+        switch (pending.operation) {
+            case SPIOperation::TRANSMIT:
+                HAL_SPI_TxCpltCallback(spi_bus);
+                break;
+            case SPIOperation::RECEIVE:
+                HAL_SPI_RxCpltCallback(spi_bus);
+                break;
+            case SPIOperation::TRANSMIT_RECEIVE:
+                HAL_SPI_TxRxCpltCallback(spi_bus);
+                break;
+        }
+    }
+
+    HAL_StatusTypeDef spi_start(SPI_HandleTypeDef* const spi_bus,
+                                SPIOperation const operation,
+                                std::uint8_t const* const tx_data,
+                                std::uint8_t* const rx_data,
+                                std::uint16_t const size) noexcept
+    {
+        if (spi_bus->State != HAL_SPI_STATE_READY) {
+            return HAL_BUSY;
+        }
+        if (size == 0U) {
+            return HAL_ERROR;
+        }
+
+        auto const pending =
+            std::ranges::find_if(spi_pending, [](SPIPending const& candidate) { return candidate.spi_bus == nullptr; });
+        if (pending == spi_pending.end()) {
+            return HAL_BUSY;
+        }
+
+        *pending = SPIPending{.spi_bus = spi_bus,
+                              .operation = operation,
+                              .tx_data = tx_data,
+                              .rx_data = rx_data,
+                              .size = size};
+
+        switch (operation) {
+            case SPIOperation::TRANSMIT:
+                spi_bus->State = HAL_SPI_STATE_BUSY_TX;
+                break;
+            case SPIOperation::RECEIVE:
+                spi_bus->State = HAL_SPI_STATE_BUSY_RX;
+                break;
+            case SPIOperation::TRANSMIT_RECEIVE:
+                spi_bus->State = HAL_SPI_STATE_BUSY_TX_RX;
+                break;
+        }
+
+        schedule(spi_duration(spi_bus, size), spi_complete, &*pending, 0UL);
+
+        return HAL_OK;
+    }
+
+    HAL_StatusTypeDef spi_stop(SPI_HandleTypeDef* const spi_bus) noexcept
+    {
+        for (auto& pending : spi_pending) {
+            if (pending.spi_bus == spi_bus) {
+                cancel(&pending);
+                pending.spi_bus = nullptr;
+            }
+        }
+
+        spi_bus->State = HAL_SPI_STATE_READY;
+
+        return HAL_OK;
+    }
+
+    /* UART */
+
+    struct UARTPending {
+        UART_HandleTypeDef* uart_bus = nullptr;
+        std::uint8_t const* tx_data = nullptr;
+        std::uint16_t tx_size = 0U;
+        std::uint8_t* rx_data = nullptr;
+        std::uint16_t rx_size = 0U;
+    };
+
+    std::array<UARTPending, 4UL> uart_pending{};
+
+    UARTPending& get_uart_pending(UART_HandleTypeDef* const uart_bus) noexcept
+    {
+        auto pending =
+            std::ranges::find_if(uart_pending, [=](UARTPending const& candidate) { return candidate.uart_bus == uart_bus; });
+
+        if (pending == uart_pending.end()) {
+            pending = std::ranges::find_if(uart_pending,
+                                           [](UARTPending const& candidate) { return candidate.uart_bus == nullptr; });
+        }
+        if (pending == uart_pending.end()) {
+            std::fputs("sim: too many UARTs\n", stderr);
+            std::abort();
+        }
+
+        pending->uart_bus = uart_bus;
+
+        return *pending;
+    }
+
+    std::uint32_t uart_baud_rate(UART_HandleTypeDef* const uart_bus) noexcept
+    {
+        auto const brr = uart_bus->Instance->BRR;
+        if (brr == 0UL) {
+            return uart_bus->Init.BaudRate;
+        }
+
+        // with OVER8 the fraction is 3 bits wide and the divider counts in eighths
+        auto const divider = (uart_bus->Instance->CR1 & USART_CR1_OVER8) != 0UL
+                                 ? ((brr >> 4U) << 3U) + (brr & 0x7U)
+                                 : brr;
+
+        return get_pclk(uart_bus->Instance) / divider;
+    }
+
+    Nanoseconds uart_duration(UART_HandleTypeDef* const uart_bus, std::size_t const size) noexcept
+    {
+        // start + 8 data + stop
+        return bits_to_time(10ULL * size, uart_baud_rate(uart_bus));
+    }
+
+    /* 1-Wire */
+
+    enum struct OWState : std::uint8_t {
+        IDLE,
+        ROM_COMMAND,
+        MATCH_ROM,
+        SEARCH_ROM,
+        FUNCTION_COMMAND,
+        CONVERT_T,
+        READ_SCRATCHPAD,
+    };
+
+    struct OWSlave {
+        UART_HandleTypeDef* uart_bus = nullptr;
+        std::uint64_t rom = 0ULL;
+        std::array<std::uint8_t, 9UL> scratchpad = {};
+        Nanoseconds conversion_time = 0ULL;
+        bool alarm = false;
+
+        // slots since the state was entered, the command byte received so far
+        OWState state = OWState::IDLE;
+        std::size_t slot = 0UL;
+        std::uint8_t command = 0U;
+        Nanoseconds converted_at = 0ULL;
+    };
+
+    std::array<OWSlave, 8UL> ow_slaves{};
+
+    bool ow_has_slaves(UART_HandleTypeDef* const uart_bus) noexcept
+    {
+        return std::ranges::any_of(ow_slaves, [=](OWSlave const& slave) { return slave.uart_bus == uart_bus; });
+    }
+
+    bool ow_rom_bit(OWSlave const& slave, std::size_t const bit) noexcept
+    {
+        return ((slave.rom >> bit) & 1ULL) != 0ULL;
+    }
+
+    void ow_enter(OWSlave& slave, OWState const state) noexcept
+    {
+        slave.state = state;
+        slave.slot = 0UL;
+        slave.command = 0U;
+    }
+
+    // level the slave leaves on the line in a read slot, false when it holds the line low
+    bool ow_drive(OWSlave const& slave, Nanoseconds const time) noexcept
+    {
+        switch (slave.state) {
+            case OWState::SEARCH_ROM:
+                // every ROM bit takes three slots: the bit, its complement and the master's direction
+                switch (slave.slot % 3UL) {
+                    case 0UL:
+                        return ow_rom_bit(slave, slave.slot / 3UL);
+                    case 1UL:
+                        return !ow_rom_bit(slave, slave.slot / 3UL);
+                    default:
+                        return true;
+                }
+            case OWState::CONVERT_T:
+                return time >= slave.converted_at;
+            case OWState::READ_SCRATCHPAD:
+                return slave.slot >= 8UL * slave.scratchpad.size() ||
+                       ((slave.scratchpad[slave.slot / 8UL] >> (slave.slot % 8UL)) & 1U) != 0U;
+            default:
+                return true;
+        }
+    }
+
+    void ow_execute(OWSlave& slave, Nanoseconds const time) noexcept
+    {
+        if (slave.state == OWState::ROM_COMMAND) {
+            switch (slave.command) {
+                case 0x55U:
+                    ow_enter(slave, OWState::MATCH_ROM);
+                    break;
+                case 0xCCU:
+                    ow_enter(slave, OWState::FUNCTION_COMMAND);
+                    break;
+                case 0xF0U:
+                    ow_enter(slave, OWState::SEARCH_ROM);
+                    break;
+                case 0xECU:
+                    ow_enter(slave, slave.alarm ? OWState::SEARCH_ROM : OWState::IDLE);
+                    break;
+                default:
+                    ow_enter(slave, OWState::IDLE);
+                    break;
+            }
+        } else {
+            switch (slave.command) {
+                case 0x44U:
+                    ow_enter(slave, OWState::CONVERT_T);
+                    slave.converted_at = time + slave.conversion_time;
+                    break;
+                case 0xBEU:
+                    ow_enter(slave, OWState::READ_SCRATCHPAD);
+                    break;
+                default:
+                    ow_enter(slave, OWState::IDLE);
+                    break;
+            }
+        }
+    }
+
+    // the slave samples the line at the end of every slot
+    void ow_sample(OWSlave& slave, bool const level, Nanoseconds const time) noexcept
+    {
+        switch (slave.state) {
+            case OWState::ROM_COMMAND:
+            case OWState::FUNCTION_COMMAND:
+                slave.command |= static_cast<std::uint8_t>((level ? 1U : 0U) << slave.slot);
+                if (++slave.slot == 8UL) {
+                    ow_execute(slave, time);
+                }
+                break;
+            case OWState::MATCH_ROM:
+                if (level != ow_rom_bit(slave, slave.slot)) {
+                    ow_enter(slave, OWState::IDLE);
+                } else if (++slave.slot == 64UL) {
+                    ow_enter(slave, OWState::FUNCTION_COMMAND);
+                }
+                break;
+            case OWState::SEARCH_ROM:
+                // a slave leaves the search once the master goes the other way
+                if (slave.slot % 3UL == 2UL && level != ow_rom_bit(slave, slave.slot / 3UL)) {
+                    ow_enter(slave, OWState::IDLE);
+                } else if (++slave.slot == 3UL * 64UL) {
+                    ow_enter(slave, OWState::FUNCTION_COMMAND);
+                }
+                break;
+            case OWState::READ_SCRATCHPAD:
+                slave.slot += 1UL;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // the line is the wired AND of the master and every slave on it, each character is echoed as the
+    // slaves left it into the first rx_size bytes of rx_data, which may alias tx_data
+    void ow_transfer(UART_HandleTypeDef* const uart_bus,
+                     std::uint8_t const* const tx_data,
+                     std::size_t const size,
+                     std::uint8_t* const rx_data,
+                     std::size_t const rx_size) noexcept
+    {
+        auto const reset = uart_baud_rate(uart_bus) < OW_SLOT_BAUD_RATE / 2UL;
+        auto const character_time = uart_duration(uart_bus, 1UL);
+
+        for (std::size_t index = 0UL; index < size; ++index) {
+            auto const time = current_time - character_time * (size - 1UL - index);
+            auto echo = tx_data[index];
+
+            if (reset) {
+                for (auto& slave : ow_slaves) {
+                    if (slave.uart_bus == uart_bus) {
+                        ow_enter(slave, OWState::ROM_COMMAND);
+                        echo = OW_PRESENCE;
+                    }
+                }
+            } else {
+                auto level = echo == 0xFFU;
+                for (auto const& slave : ow_slaves) {
+                    if (slave.uart_bus == uart_bus) {
+                        level = level && ow_drive(slave, time);
+                    }
+                }
+                for (auto& slave : ow_slaves) {
+                    if (slave.uart_bus == uart_bus) {
+                        ow_sample(slave, level, time);
+                    }
+                }
+                if (echo == 0xFFU && !level) {
+                    echo = OW_READ_ZERO;
+                }
+            }
+
+            if (index < rx_size) {
+                rx_data[index] = echo;
+            }
+        }
+    }
+
+    void uart_complete(void* const object, std::uint32_t const) noexcept
+    {
+        auto& pending = *static_cast<UARTPending*>(object);
+        auto const uart_bus = pending.uart_bus;
+
+        record(Sim::Bus::UART, pending.tx_size, uart_duration(uart_bus, pending.tx_size), true);
+
+        // half-duplex line reads back what was driven onto it, less what 1-Wire slaves held low
+        auto const receiving = uart_bus->RxState == HAL_UART_STATE_BUSY_RX && pending.rx_data != nullptr;
+        auto const size = receiving ? std::min(pending.tx_size, pending.rx_size) : std::uint16_t{0U};
+
+        if (ow_has_slaves(uart_bus)) {
+            // slaves see every slot, whether or not it is read back
+            ow_transfer(uart_bus, pending.tx_data, pending.tx_size, pending.rx_data, size);
+        } else if (receiving) {
+            std::memmove(pending.rx_data, pending.tx_data, size);
+        }
+
+        uart_bus->gState = HAL_UART_STATE_READY;
+        HAL_UART_TxCpltCallback(uart_bus);
+
+        if (receiving && size == pending.rx_size) {
+            pending.rx_data = nullptr;
+            uart_bus->RxState = HAL_UART_STATE_READY;
+            HAL_UART_RxCpltCallback(uart_bus);
+        }
+    }
+
+    /* TIM */
+
+    struct PWMStreamState {
+        TIM_HandleTypeDef* timer = nullptr;
+        std::uint32_t channel = 0UL;
+        std::uint16_t length = 0U;
+    };
+
+    std::array<PWMStreamState, 8UL> pwm_streams{};
+
+    struct TimerTick {
+        TIM_HandleTypeDef* timer = nullptr;
+        Nanoseconds time = 0ULL;
+    };
+
+    // base timers started with TRGO on update or the update interrupt, the others never overflow here
+    std::array<TimerTick, 4UL> timer_ticks{};
+
+    struct TriggerInputs {
+        TIM_TypeDef* slave = nullptr;
+        std::array<TIM_TypeDef*, 4UL> masters = {};
+    };
+
+    // internal trigger connections, TIMx_SMCR.TS ITR0 - ITR3
+    std::array<TriggerInputs, 6UL> const trigger_inputs{{
+        {TIM1, {TIM5, TIM2, TIM3, TIM4}},
+        {TIM8, {TIM1, TIM2, TIM4, TIM5}},
+        {TIM2, {TIM1, TIM8, TIM3, TIM4}},
+        {TIM3, {TIM1, TIM2, TIM5, TIM4}},
+        {TIM4, {TIM1, TIM2, TIM3, TIM8}},
+        {TIM5, {TIM2, TIM3, TIM4, TIM8}},
+    }};
+
+    std::uint32_t get_timer_clock(TIM_TypeDef const* const instance) noexcept
+    {
+        auto const pclk = get_pclk(instance);
+        return pclk == hclk ? pclk : 2UL * pclk;
+    }
+
+    Nanoseconds timer_update_period(TIM_HandleTypeDef* const timer) noexcept
+    {
+        auto const ticks = (static_cast<std::uint64_t>(timer->Instance->PSC) + 1ULL) *
+                           (static_cast<std::uint64_t>(timer->Instance->ARR) + 1ULL);
+
+        return std::max(bits_to_time(ticks, get_timer_clock(timer->Instance)), Nanoseconds{1ULL});
+    }
+
+    HAL_TIM_ActiveChannel channel_to_active_channel(std::uint32_t const channel) noexcept
+    {
+        return static_cast<HAL_TIM_ActiveChannel>(1UL << (channel >> 2U));
+    }
+
+    bool is_any_channel_enabled(TIM_TypeDef const* const instance) noexcept
+    {
+        return (instance->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) != 0UL;
+    }
+
+    void pwm_stream_event(void* const object, std::uint32_t const half) noexcept
+    {
+        auto& stream = *static_cast<PWMStreamState*>(object);
+        auto const timer = stream.timer;
+        auto const half_length = stream.length / 2U;
+        auto const period = timer_update_period(timer);
+
+        timer->Channel = channel_to_active_channel(stream.channel);
+
+        // circular DMA wraps around, so a complete transfer is followed by the next half
+        if (half != 0UL) {
+            schedule(period * (stream.length - half_length), pwm_stream_event, &stream, 0UL, true);
+            HAL_TIM_PWM_PulseFinishedHalfCpltCallback(timer);
+        } else {
+            schedule(period * half_length, pwm_stream_event, &stream, 1UL, true);
+            HAL_TIM_PWM_PulseFinishedCallback(timer);
+        }
+
+        timer->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+    }
+
+    void timer_update_event(void* const object, std::uint32_t const) noexcept
+    {
+        auto const timer = static_cast<TIM_HandleTypeDef*>(object);
+
+        if ((timer->Instance->SR & TIM_SR_UIF) != 0UL && (timer->Instance->DIER & TIM_DIER_UIE) != 0UL) {
+            timer->Instance->SR = timer->Instance->SR & ~TIM_SR_UIF;
+            HAL_TIM_PeriodElapsedCallback(timer);
+        }
+    }
+
+    void timer_capture_event(void* const object, std::uint32_t const) noexcept
+    {
+        auto const timer = static_cast<TIM_HandleTypeDef*>(object);
+
+        if ((timer->Instance->SR & TIM_SR_CC1IF) != 0UL && (timer->Instance->DIER & TIM_DIER_CC1IE) != 0UL) {
+            timer->Instance->SR = timer->Instance->SR & ~TIM_SR_CC1IF;
+            timer->Channel = HAL_TIM_ACTIVE_CHANNEL_1;
+            HAL_TIM_IC_CaptureCallback(timer);
+            timer->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+        }
+    }
+
+    std::uint32_t volatile* timer_ccmr(TIM_TypeDef* const instance, std::uint32_t const index) noexcept
+    {
+        return index < 2UL ? &instance->CCMR1 : &instance->CCMR2;
+    }
+
+    std::uint32_t volatile* timer_ccr(TIM_TypeDef* const instance, std::uint32_t const index) noexcept
+    {
+        return &instance->CCR1 + index;
+    }
+
+    // channels of a slave to master configured as inputs from TRC latch its counter
+    void timer_trigger_captures(TIM_TypeDef* const master) noexcept
+    {
+        for (auto const& inputs : trigger_inputs) {
+            auto const slave = inputs.slave;
+            auto const selected = (slave->SMCR & TIM_SMCR_TS) >> 4U;
+
+            if (selected >= inputs.masters.size() || inputs.masters[selected] != master) {
+                continue;
+            }
+
+            for (auto index = std::uint32_t{0U}; index < 4U; ++index) {
+                auto const selection = (*timer_ccmr(slave, index) >> (8U * (index % 2U))) & TIM_CCMR1_CC1S;
+                auto const enabled = (slave->CCER & (TIM_CCER_CC1E << (4U * index))) != 0UL;
+
+                if (selection != TIM_ICSELECTION_TRC || !enabled) {
+                    continue;
+                }
+
+                if ((slave->SR & (TIM_SR_CC1IF << index)) != 0UL) {
+                    slave->SR = slave->SR | TIM_SR_CC1OF << index;
+                }
+                *timer_ccr(slave, index) = slave->CNT;
+                slave->SR = slave->SR | TIM_SR_CC1IF << index;
+            }
+        }
+    }
+
+    void timer_tick_event(void* const object, std::uint32_t const) noexcept
+    {
+        auto& tick = *static_cast<TimerTick*>(object);
+        auto const timer = tick.timer;
+
+        tick.time += timer_update_period(timer);
+        schedule(tick.time - current_time, timer_tick_event, &tick, 0UL, true);
+
+        timer->Instance->SR = timer->Instance->SR | TIM_SR_UIF;
+        if ((timer->Instance->CR2 & TIM_CR2_MMS) == TIM_TRGO_UPDATE) {
+            timer_trigger_captures(timer->Instance);
+        }
+
+        timer_update_event(timer, 0UL);
+    }
+
+    void timer_start_ticks(TIM_HandleTypeDef* const timer) noexcept
+    {
+        auto const ticking = (timer->Instance->CR2 & TIM_CR2_MMS) == TIM_TRGO_UPDATE ||
+                             (timer->Instance->DIER & TIM_DIER_UIE) != 0UL;
+        if (!ticking || (timer->Instance->SMCR & TIM_SMCR_SMS) != TIM_SLAVEMODE_DISABLE) {
+            return;
+        }
+
+        auto const tick = std::ranges::find_if(timer_ticks, [timer](TimerTick const& candidate) {
+            return candidate.timer == timer || candidate.timer == nullptr;
+        });
+        if (tick == timer_ticks.end()) {
+            std::fputs("sim: too many running timers\n", stderr);
+            std::abort();
+        }
+
+        cancel(&*tick);
+        *tick = TimerTick{.timer = timer, .time = current_time + timer_update_period(timer)};
+        schedule(tick->time - current_time, timer_tick_event, &*tick, 0UL, true);
+    }
+
+    void timer_stop_ticks(TIM_HandleTypeDef* const timer) noexcept
+    {
+        for (auto& tick : timer_ticks) {
+            if (tick.timer == timer) {
+                cancel(&tick);
+                tick = TimerTick{};
+            }
+        }
+    }
+
+    void timer_start_counter(TIM_HandleTypeDef* const timer) noexcept
+    {
+        if ((timer->Instance->SMCR & TIM_SMCR_SMS) != TIM_SLAVEMODE_TRIGGER) {
+            __HAL_TIM_ENABLE(timer);
+        }
+    }
+
+    void timer_stop_outputs(TIM_HandleTypeDef* const timer) noexcept
+    {
+        if (!is_any_channel_enabled(timer->Instance)) {
+            if (IS_TIM_BREAK_INSTANCE(timer->Instance)) {
+                __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(timer);
+            }
+            __HAL_TIM_DISABLE(timer);
+        }
+    }
+
+    /* EXTI */
+
+    struct EXTILine {
+        std::uint16_t gpio_pin = 0U;
+        Nanoseconds period = 0ULL;
+        Nanoseconds time = 0ULL;
+    };
+
+    // one line per pin number, shared by all ports as on target
+    std::array<EXTILine, 16UL> exti_lines{};
+
+    void exti_event(void* const object, std::uint32_t const) noexcept
+    {
+        auto& line = *static_cast<EXTILine*>(object);
+
+        // edges keep their own pace when held back by PRIMASK, like a sensor's clock would
+        line.time += line.period;
+        schedule(line.time - current_time, exti_event, &line, 0UL, true);
+        HAL_GPIO_EXTI_Callback(line.gpio_pin);
+    }
+
+}; // namespace
+
+/* CMSIS core */
+
+std::uint32_t __get_PRIMASK(void) noexcept
+{
+    return primask;
+}
+
+void __set_PRIMASK(std::uint32_t priMask) noexcept
+{
+    primask = priMask & 1UL;
+
+    // interrupts that became pending while masked fire on unmask
+    if (primask == 0UL) {
+        dispatch_until(current_time);
+    }
+}
+
+void __disable_irq(void) noexcept
+{
+    primask = 1UL;
+}
+
+void __enable_irq(void) noexcept
+{
+    __set_PRIMASK(0UL);
+}
+
+void __DMB(void) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void __DSB(void) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void __ISB(void) noexcept
+{
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+void __NOP(void) noexcept
+{
+    dispatch_until(current_time + NOP_TIME);
+}
+
+// sleeps until the next event or SysTick, events held back by PRIMASK fire once it is cleared
+void __WFI(void) noexcept
+{
+    auto const tick = (current_time / NANOSECONDS_PER_TICK + 1ULL) * NANOSECONDS_PER_TICK;
+    auto const event = next_event();
+
+    dispatch_until(event != nullptr && event->time < tick ? event->time : tick);
+}
+
+std::uint32_t SystemCoreClock = DEFAULT_HCLK;
+
+/* HAL core and RCC */
+
+std::uint32_t HAL_GetTick(void) noexcept
+{
+    dispatch_until(current_time + POLL_TIME);
+    return static_cast<std::uint32_t>(current_time / NANOSECONDS_PER_TICK);
+}
+
+void HAL_Delay(std::uint32_t Delay) noexcept
+{
+    dispatch_until(current_time + Delay * NANOSECONDS_PER_TICK);
+}
+
+std::uint32_t HAL_GetTickFreq(void) noexcept
+{
+    return 1UL;
+}
+
+std::uint32_t HAL_RCC_GetHCLKFreq(void) noexcept
+{
+    return hclk;
+}
+
+std::uint32_t HAL_RCC_GetPCLK1Freq(void) noexcept
+{
+    return pclk1;
+}
+
+std::uint32_t HAL_RCC_GetPCLK2Freq(void) noexcept
+{
+    return pclk2;
+}
+
+/* GPIO */
+
+GPIO_BSRR_Register& GPIO_BSRR_Register::operator=(std::uint32_t const bits) noexcept
+{
+    auto const port =
+        reinterpret_cast<GPIO_TypeDef*>(reinterpret_cast<std::uintptr_t>(this) - offsetof(GPIO_TypeDef, BSRR));
+
+    // set bits win over reset bits, as on hardware
+    port->ODR = ((port->ODR & ~(bits >> 16U)) | bits) & 0xFFFFU;
+    port->IDR = port->ODR;
+
+    return *this;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, std::uint16_t GPIO_Pin) noexcept
+{
+    return (GPIOx->IDR & GPIO_Pin) != 0UL ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, std::uint16_t GPIO_Pin, GPIO_PinState PinState) noexcept
+{
+    GPIOx->BSRR = PinState != GPIO_PIN_RESET ? std::uint32_t{GPIO_Pin} : std::uint32_t{GPIO_Pin} << 16U;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, std::uint16_t GPIO_Pin) noexcept
+{
+    auto const odr = GPIOx->ODR;
+    GPIOx->BSRR = ((odr & GPIO_Pin) << 16U) | (~odr & GPIO_Pin);
+}
+
+/* I2C */
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c) noexcept
+{
+    hi2c->Instance->SR2 = hi2c->Instance->SR2 & ~I2C_SR2_BUSY;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c) noexcept
+{
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef* hi2c,
+                                          std::uint16_t DevAddress,
+                                          std::uint8_t* pData,
+                                          std::uint16_t Size,
+                                          std::uint32_t) noexcept
+{
+    return i2c_blocking(
+        hi2c,
+        I2CRequest{.operation = I2COperation::TRANSMIT, .dev_address = DevAddress, .data = pData, .size = Size});
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef* hi2c,
+                                         std::uint16_t DevAddress,
+                                         std::uint8_t* pData,
+                                         std::uint16_t Size,
+                                         std::uint32_t) noexcept
+{
+    return i2c_blocking(
+        hi2c,
+        I2CRequest{.operation = I2COperation::RECEIVE, .dev_address = DevAddress, .data = pData, .size = Size});
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c,
+                                    std::uint16_t DevAddress,
+                                    std::uint16_t MemAddress,
+                                    std::uint16_t MemAddSize,
+                                    std::uint8_t* pData,
+                                    std::uint16_t Size,
+                                    std::uint32_t) noexcept
+{
+    return i2c_blocking(hi2c,
+                        I2CRequest{.operation = I2COperation::MEMORY_WRITE,
+                                   .dev_address = DevAddress,
+                                   .mem_address = MemAddress,
+                                   .mem_address_size = MemAddSize,
+                                   .data = pData,
+                                   .size = Size});
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c,
+                                   std::uint16_t DevAddress,
+                                   std::uint16_t MemAddress,
+                                   std::uint16_t MemAddSize,
+                                   std::uint8_t* pData,
+                                   std::uint16_t Size,
+                                   std::uint32_t) noexcept
+{
+    return i2c_blocking(hi2c,
+                        I2CRequest{.operation = I2COperation::MEMORY_READ,
+                                   .dev_address = DevAddress,
+                                   .mem_address = MemAddress,
+                                   .mem_address_size = MemAddSize,
+                                   .data = pData,
+                                   .size = Size});
+}
+
+HAL_StatusTypeDef
+HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, std::uint16_t DevAddress, std::uint32_t Trials, std::uint32_t) noexcept
+{
+    if (hi2c->State != HAL_I2C_STATE_READY || !i2c_wait_bus(hi2c)) {
+        return HAL_BUSY;
+    }
+
+    auto const probe = I2CRequest{.operation = I2COperation::TRANSMIT, .dev_address = DevAddress};
+
+    for (auto trial = 0UL; trial < std::max(Trials, 1U); ++trial) {
+        if (i2c_blocking(hi2c, probe) == HAL_OK) {
+            return HAL_OK;
+        }
+    }
+
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, std::uint16_t DevAddress, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return i2c_start(
+        hi2c,
+        I2CRequest{.operation = I2COperation::TRANSMIT, .dev_address = DevAddress, .data = pData, .size = Size});
+}
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* hi2c, std::uint16_t DevAddress, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return i2c_start(
+        hi2c,
+        I2CRequest{.operation = I2COperation::RECEIVE, .dev_address = DevAddress, .data = pData, .size = Size});
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* hi2c,
+                                       std::uint16_t DevAddress,
+                                       std::uint16_t MemAddress,
+                                       std::uint16_t MemAddSize,
+                                       std::uint8_t* pData,
+                                       std::uint16_t Size) noexcept
+{
+    return i2c_start(hi2c,
+                     I2CRequest{.operation = I2COperation::MEMORY_WRITE,
+                                .dev_address = DevAddress,
+                                .mem_address = MemAddress,
+                                .mem_address_size = MemAddSize,
+                                .data = pData,
+                                .size = Size});
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* hi2c,
+                                      std::uint16_t DevAddress,
+                                      std::uint16_t MemAddress,
+                                      std::uint16_t MemAddSize,
+                                      std::uint8_t* pData,
+                                      std::uint16_t Size) noexcept
+{
+    return i2c_start(hi2c,
+                     I2CRequest{.operation = I2COperation::MEMORY_READ,
+                                .dev_address = DevAddress,
+                                .mem_address = MemAddress,
+                                .mem_address_size = MemAddSize,
+                                .data = pData,
+                                .size = Size});
+}
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef* hi2c, std::uint16_t DevAddress, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return HAL_I2C_Master_Transmit_IT(hi2c, DevAddress, pData, Size);
+}
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef* hi2c, std::uint16_t DevAddress, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return HAL_I2C_Master_Receive_IT(hi2c, DevAddress, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef* hi2c,
+                                        std::uint16_t DevAddress,
+                                        std::uint16_t MemAddress,
+                                        std::uint16_t MemAddSize,
+                                        std::uint8_t* pData,
+                                        std::uint16_t Size) noexcept
+{
+    return HAL_I2C_Mem_Write_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef* hi2c,
+                                       std::uint16_t DevAddress,
+                                       std::uint16_t MemAddress,
+                                       std::uint16_t MemAddSize,
+                                       std::uint8_t* pData,
+                                       std::uint16_t Size) noexcept
+{
+    return HAL_I2C_Mem_Read_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c,
+                                                 std::uint16_t DevAddress,
+                                                 std::uint8_t* pData,
+                                                 std::uint16_t Size,
+                                                 std::uint32_t XferOptions) noexcept
+{
+    return i2c_sequence(hi2c, I2COperation::TRANSMIT, DevAddress, pData, Size, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c,
+                                                std::uint16_t DevAddress,
+                                                std::uint8_t* pData,
+                                                std::uint16_t Size,
+                                                std::uint32_t XferOptions) noexcept
+{
+    return i2c_sequence(hi2c, I2COperation::RECEIVE, DevAddress, pData, Size, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_DMA(I2C_HandleTypeDef* hi2c,
+                                                  std::uint16_t DevAddress,
+                                                  std::uint8_t* pData,
+                                                  std::uint16_t Size,
+                                                  std::uint32_t XferOptions) noexcept
+{
+    return HAL_I2C_Master_Seq_Transmit_IT(hi2c, DevAddress, pData, Size, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_DMA(I2C_HandleTypeDef* hi2c,
+                                                 std::uint16_t DevAddress,
+                                                 std::uint8_t* pData,
+                                                 std::uint16_t Size,
+                                                 std::uint32_t XferOptions) noexcept
+{
+    return HAL_I2C_Master_Seq_Receive_IT(hi2c, DevAddress, pData, Size, XferOptions);
+}
+
+// completes right away instead of through HAL_I2C_AbortCpltCallback
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* hi2c, std::uint16_t) noexcept
+{
+    for (auto& pending : i2c_pending) {
+        if (pending.i2c_bus == hi2c) {
+            cancel(&pending);
+            pending.i2c_bus = nullptr;
+        }
+    }
+
+    hi2c->PreviousState = HAL_I2C_STATE_RESET;
+    hi2c->State = HAL_I2C_STATE_READY;
+
+    return HAL_OK;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c) noexcept
+{
+    dispatch_until(current_time + POLL_TIME);
+    return hi2c->State;
+}
+
+std::uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c) noexcept
+{
+    return hi2c->ErrorCode;
+}
+
+/* SPI */
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi) noexcept
+{
+    hspi->Instance->CR1 = hspi->Init.Mode | hspi->Init.Direction | hspi->Init.DataSize | hspi->Init.CLKPolarity |
+                          hspi->Init.CLKPhase | hspi->Init.BaudRatePrescaler | hspi->Init.FirstBit;
+    dispatch_until(current_time + SPI_INIT_TIME);
+    hspi->State = HAL_SPI_STATE_READY;
+    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, const std::uint8_t* pData, std::uint16_t Size, std::uint32_t) noexcept
+{
+    return spi_blocking(hspi, pData, nullptr, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* hspi, std::uint8_t* pData, std::uint16_t Size, std::uint32_t) noexcept
+{
+    return spi_blocking(hspi, nullptr, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi,
+                                          const std::uint8_t* pTxData,
+                                          std::uint8_t* pRxData,
+                                          std::uint16_t Size,
+                                          std::uint32_t) noexcept
+{
+    return spi_blocking(hspi, pTxData, pRxData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, const std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return spi_start(hspi, SPIOperation::TRANSMIT, pData, nullptr, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef* hspi, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    return spi_start(hspi, SPIOperation::RECEIVE, nullptr, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi,
+                                              const std::uint8_t* pTxData,
+                                              std::uint8_t* pRxData,
+                                              std::uint16_t Size) noexcept
+{
+    return spi_start(hspi, SPIOperation::TRANSMIT_RECEIVE, pTxData, pRxData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef* hspi) noexcept
+{
+    return spi_stop(hspi);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi) noexcept
+{
+    return spi_stop(hspi);
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef* hspi) noexcept
+{
+    dispatch_until(current_time + POLL_TIME);
+    return hspi->State;
+}
+
+/* UART */
+
+HAL_StatusTypeDef HAL_HalfDuplex_Init(UART_HandleTypeDef* huart) noexcept
+{
+    auto const pclk = get_pclk(huart->Instance);
+
+    if (huart->Init.OverSampling == UART_OVERSAMPLING_8) {
+        huart->Instance->CR1 = huart->Instance->CR1 | USART_CR1_OVER8;
+        huart->Instance->BRR = UART_BRR_SAMPLING8(pclk, huart->Init.BaudRate);
+    } else {
+        huart->Instance->CR1 = huart->Instance->CR1 & ~USART_CR1_OVER8;
+        huart->Instance->BRR = UART_BRR_SAMPLING16(pclk, huart->Init.BaudRate);
+    }
+
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = 0UL;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (pData == nullptr || Size == 0U) {
+        return HAL_ERROR;
+    }
+
+    auto& pending = get_uart_pending(huart);
+    pending.tx_data = pData;
+    pending.tx_size = Size;
+
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    schedule(uart_duration(huart, Size), uart_complete, &pending, 0UL);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, std::uint8_t* pData, std::uint16_t Size) noexcept
+{
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (pData == nullptr || Size == 0U) {
+        return HAL_ERROR;
+    }
+
+    auto& pending = get_uart_pending(huart);
+    pending.rx_data = pData;
+    pending.rx_size = Size;
+
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef* huart) noexcept
+{
+    auto& pending = get_uart_pending(huart);
+    cancel(&pending);
+
+    pending.tx_data = nullptr;
+    pending.rx_data = nullptr;
+
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+
+    return HAL_OK;
+}
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef* huart) noexcept
+{
+    dispatch_until(current_time + POLL_TIME);
+    return static_cast<HAL_UART_StateTypeDef>(huart->gState | huart->RxState);
+}
+
+/* TIM */
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim) noexcept
+{
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->CR1 = htim->Init.CounterMode | htim->Init.ClockDivision | htim->Init.AutoReloadPreload;
+
+    htim->State = HAL_TIM_STATE_READY;
+    std::ranges::fill(htim->ChannelState, HAL_TIM_CHANNEL_STATE_READY);
+    std::ranges::fill(htim->ChannelNState, HAL_TIM_CHANNEL_STATE_READY);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef* htim) noexcept
+{
+    return HAL_TIM_Base_Init(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Init(TIM_HandleTypeDef* htim, TIM_Encoder_InitTypeDef* sConfig) noexcept
+{
+    htim->Instance->SMCR = (htim->Instance->SMCR & ~TIM_SMCR_SMS) | sConfig->EncoderMode;
+    htim->Instance->CCMR1 = (sConfig->IC1Selection | sConfig->IC1Prescaler) |
+                            (sConfig->IC2Selection | sConfig->IC2Prescaler) << 8U;
+    return HAL_TIM_Base_Init(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim) noexcept
+{
+    htim->State = HAL_TIM_STATE_BUSY;
+    timer_start_counter(htim);
+    timer_start_ticks(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim) noexcept
+{
+    timer_stop_ticks(htim);
+    __HAL_TIM_DISABLE(htim);
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) noexcept
+{
+    __HAL_TIM_ENABLE_IT(htim, TIM_IT_UPDATE);
+    return HAL_TIM_Base_Start(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim) noexcept
+{
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+    return HAL_TIM_Base_Stop(htim);
+}
+
+void TIM_CCxChannelCmd(TIM_TypeDef* TIMx, std::uint32_t Channel, std::uint32_t ChannelState) noexcept
+{
+    auto const mask = TIM_CCER_CC1E << (Channel & 0x1FUL);
+
+    TIMx->CCER = TIMx->CCER & ~mask;
+    TIMx->CCER = TIMx->CCER | ChannelState << (Channel & 0x1FUL);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY) {
+        return HAL_ERROR;
+    }
+
+    TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+    TIM_CCxChannelCmd(htim->Instance, Channel, TIM_CCx_ENABLE);
+
+    if (IS_TIM_BREAK_INSTANCE(htim->Instance)) {
+        __HAL_TIM_MOE_ENABLE(htim);
+    }
+
+    timer_start_counter(htim);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    TIM_CCxChannelCmd(htim->Instance, Channel, TIM_CCx_DISABLE);
+    timer_stop_outputs(htim);
+    TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_READY);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef* htim, std::uint32_t Channel, const std::uint32_t* pData, std::uint16_t Length) noexcept
+{
+    if (TIM_CHANNEL_STATE_GET(htim, Channel) == HAL_TIM_CHANNEL_STATE_BUSY) {
+        return HAL_BUSY;
+    }
+    if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY || pData == nullptr || Length == 0U) {
+        return HAL_ERROR;
+    }
+
+    auto const stream =
+        std::ranges::find_if(pwm_streams, [](PWMStreamState const& candidate) { return candidate.timer == nullptr; });
+    if (stream == pwm_streams.end()) {
+        return HAL_ERROR;
+    }
+
+    *stream = PWMStreamState{.timer = htim, .channel = Channel, .length = Length};
+
+    TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+    TIM_CCxChannelCmd(htim->Instance, Channel, TIM_CCx_ENABLE);
+
+    if (IS_TIM_BREAK_INSTANCE(htim->Instance)) {
+        __HAL_TIM_MOE_ENABLE(htim);
+    }
+
+    timer_start_counter(htim);
+
+    schedule(timer_update_period(htim) * (Length / 2U), pwm_stream_event, &*stream, 1UL, true);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    for (auto& stream : pwm_streams) {
+        if (stream.timer == htim && stream.channel == Channel) {
+            cancel(&stream);
+            stream.timer = nullptr;
+        }
+    }
+
+    return HAL_TIM_PWM_Stop(htim, Channel);
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    if (Channel == TIM_CHANNEL_ALL || Channel == TIM_CHANNEL_1) {
+        TIM_CCxChannelCmd(htim->Instance, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+        TIM_CHANNEL_STATE_SET(htim, TIM_CHANNEL_1, HAL_TIM_CHANNEL_STATE_BUSY);
+    }
+    if (Channel == TIM_CHANNEL_ALL || Channel == TIM_CHANNEL_2) {
+        TIM_CCxChannelCmd(htim->Instance, TIM_CHANNEL_2, TIM_CCx_ENABLE);
+        TIM_CHANNEL_STATE_SET(htim, TIM_CHANNEL_2, HAL_TIM_CHANNEL_STATE_BUSY);
+    }
+
+    __HAL_TIM_ENABLE(htim);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    if (Channel == TIM_CHANNEL_ALL || Channel == TIM_CHANNEL_1) {
+        TIM_CCxChannelCmd(htim->Instance, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+        TIM_CHANNEL_STATE_SET(htim, TIM_CHANNEL_1, HAL_TIM_CHANNEL_STATE_READY);
+    }
+    if (Channel == TIM_CHANNEL_ALL || Channel == TIM_CHANNEL_2) {
+        TIM_CCxChannelCmd(htim->Instance, TIM_CHANNEL_2, TIM_CCx_DISABLE);
+        TIM_CHANNEL_STATE_SET(htim, TIM_CHANNEL_2, HAL_TIM_CHANNEL_STATE_READY);
+    }
+
+    __HAL_TIM_DISABLE(htim);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef* htim, const TIM_IC_InitTypeDef* sConfig, std::uint32_t Channel) noexcept
+{
+    auto const index = Channel >> 2U;
+    auto const shift = 8U * (index % 2U);
+    auto const ccmr = timer_ccmr(htim->Instance, index);
+
+    *ccmr = (*ccmr & ~(0xFFU << shift)) | ((sConfig->ICSelection | sConfig->ICPrescaler) << shift);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY) {
+        return HAL_ERROR;
+    }
+
+    TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+    TIM_CCxChannelCmd(htim->Instance, Channel, TIM_CCx_ENABLE);
+    timer_start_counter(htim);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Stop(TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    TIM_CCxChannelCmd(htim->Instance, Channel, TIM_CCx_DISABLE);
+    TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_READY);
+    timer_stop_outputs(htim);
+
+    return HAL_OK;
+}
+
+std::uint32_t HAL_TIM_ReadCapturedValue(const TIM_HandleTypeDef* htim, std::uint32_t Channel) noexcept
+{
+    return *timer_ccr(htim->Instance, Channel >> 2U);
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef* htim,
+                                                        const TIM_MasterConfigTypeDef* sMasterConfig) noexcept
+{
+    MODIFY_REG(htim->Instance->CR2, TIM_CR2_MMS, sMasterConfig->MasterOutputTrigger);
+    MODIFY_REG(htim->Instance->SMCR, TIM_SMCR_MSM, sMasterConfig->MasterSlaveMode);
+
+    return HAL_OK;
+}
+
+/* weak callbacks, overridden by the application as on target */
+
+__attribute__((weak)) void HAL_GPIO_EXTI_Callback(std::uint16_t)
+{}
+
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_SPI_ErrorCallback(SPI_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef*)
+{}
+
+__attribute__((weak)) void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef*)
+{}
+
+/* simulator control */
+
+namespace Sim {
+
+    Nanoseconds now() noexcept
+    {
+        return current_time;
+    }
+
+    void advance(Nanoseconds const duration) noexcept
+    {
+        dispatch_until(current_time + duration);
+    }
+
+    bool run_next() noexcept
+    {
+        if (!can_dispatch()) {
+            return false;
+        }
+
+        auto const event = next_event();
+        if (event == nullptr) {
+            return false;
+        }
+
+        dispatch(event);
+
+        return true;
+    }
+
+    void run_until_idle() noexcept
+    {
+        // periodic events (PWM streams, EXTI lines) never go idle, so only outstanding transfers are waited for
+        while (has_pending_transfer() && run_next()) {
+        }
+    }
+
+    void reset() noexcept
+    {
+        events = {};
+        event_order = 0ULL;
+        current_time = 0ULL;
+        primask = 0UL;
+
+        i2c_slaves = {};
+        i2c_pending = {};
+        spi_peers = {};
+        spi_pending = {};
+        uart_pending = {};
+        ow_slaves = {};
+        pwm_streams = {};
+        timer_ticks = {};
+        exti_lines = {};
+
+        std::memset(reinterpret_cast<void*>(PERIPH_BASE), 0, PERIPH_SIZE);
+        std::memset(reinterpret_cast<void*>(CORE_BASE), 0, CORE_SIZE);
+        write_clock_configuration();
+
+        reset_statistics();
+    }
+
+    void set_clocks(std::uint32_t const hclk_frequency,
+                    std::uint32_t const pclk1_frequency,
+                    std::uint32_t const pclk2_frequency) noexcept
+    {
+        hclk = hclk_frequency;
+        pclk1 = pclk1_frequency;
+        pclk2 = pclk2_frequency;
+
+        write_clock_configuration();
+    }
+
+    void attach_i2c_device(I2C_HandleTypeDef* const i2c_bus,
+                           std::uint16_t const dev_address,
+                           std::uint8_t* const memory,
+                           std::size_t const size,
+                           std::size_t const address_bytes,
+                           std::size_t const page_size,
+                           Nanoseconds const write_time) noexcept
+    {
+        auto const slave =
+            std::ranges::find_if(i2c_slaves, [](I2CSlave const& candidate) { return candidate.memory == nullptr; });
+        if (slave == i2c_slaves.end() || memory == nullptr || size == 0UL) {
+            std::fputs("sim: cannot attach I2C device\n", stderr);
+            std::abort();
+        }
+
+        *slave = I2CSlave{.i2c_bus = i2c_bus,
+                          .dev_address = dev_address,
+                          .memory = memory,
+                          .size = size,
+                          .address_bytes = address_bytes,
+                          .page_size = page_size,
+                          .write_time = write_time};
+    }
+
+    void hold_i2c_bus(I2C_HandleTypeDef* const i2c_bus) noexcept
+    {
+        i2c_bus->Instance->SR2 = i2c_bus->Instance->SR2 | I2C_SR2_BUSY;
+    }
+
+    void detach_i2c_devices() noexcept
+    {
+        i2c_slaves = {};
+    }
+
+    void attach_ow_device(UART_HandleTypeDef* const uart_bus,
+                          std::uint64_t const rom,
+                          std::uint8_t const* const scratchpad,
+                          Nanoseconds const conversion_time,
+                          bool const alarm) noexcept
+    {
+        auto const slave =
+            std::ranges::find_if(ow_slaves, [](OWSlave const& candidate) { return candidate.uart_bus == nullptr; });
+        if (slave == ow_slaves.end() || scratchpad == nullptr) {
+            std::fputs("sim: cannot attach 1-Wire device\n", stderr);
+            std::abort();
+        }
+
+        *slave = OWSlave{.uart_bus = uart_bus, .rom = rom, .conversion_time = conversion_time, .alarm = alarm};
+        std::memcpy(slave->scratchpad.data(), scratchpad, slave->scratchpad.size());
+    }
+
+    void detach_ow_devices() noexcept
+    {
+        ow_slaves = {};
+    }
+
+    void attach_spi_responder(SPI_HandleTypeDef* const spi_bus,
+                              SPIResponder const responder,
+                              void* const context) noexcept
+    {
+        auto peer = std::ranges::find_if(spi_peers, [=](SPIPeer const& candidate) { return candidate.spi_bus == spi_bus; });
+        if (peer == spi_peers.end()) {
+            peer = std::ranges::find_if(spi_peers, [](SPIPeer const& candidate) { return candidate.spi_bus == nullptr; });
+        }
+        if (peer == spi_peers.end()) {
+            std::fputs("sim: cannot attach SPI responder\n", stderr);
+            std::abort();
+        }
+
+        *peer = SPIPeer{.spi_bus = spi_bus, .responder = responder, .context = context};
+    }
+
+    void encoder_step(TIM_HandleTypeDef* const timer, std::int32_t const steps) noexcept
+    {
+        auto const instance = timer->Instance;
+        auto const period = static_cast<std::int64_t>(instance->ARR) + 1LL;
+        auto count = static_cast<std::int64_t>(instance->CNT) + steps;
+
+        if (steps < 0) {
+            instance->CR1 = instance->CR1 | TIM_CR1_DIR;
+        } else {
+            instance->CR1 = instance->CR1 & ~TIM_CR1_DIR;
+        }
+
+        // each wrap raises UIF and gives the update interrupt a chance to run before counting on
+        while (count >= period || count < 0LL) {
+            auto const overflow = count >= period;
+
+            instance->CNT = overflow ? 0UL : instance->ARR;
+            instance->SR = instance->SR | TIM_SR_UIF;
+            count += overflow ? -period : period;
+
+            schedule(0ULL, timer_update_event, timer, 0UL);
+            dispatch_until(current_time);
+        }
+
+        instance->CNT = static_cast<std::uint32_t>(count);
+
+        // the last step ends on a TI1 edge, latched when channel 1 captures TI1
+        if (steps != 0 && (instance->CCER & TIM_CCER_CC1E) != 0UL &&
+            (instance->CCMR1 & TIM_CCMR1_CC1S) == TIM_ICSELECTION_DIRECTTI) {
+            if ((instance->SR & TIM_SR_CC1IF) != 0UL) {
+                instance->SR = instance->SR | TIM_SR_CC1OF;
+            }
+            instance->CCR1 = instance->CNT;
+            instance->SR = instance->SR | TIM_SR_CC1IF;
+
+            schedule(0ULL, timer_capture_event, timer, 0UL);
+            dispatch_until(current_time);
+        }
+    }
+
+    void start_exti(std::uint16_t const gpio_pin, Nanoseconds const period) noexcept
+    {
+        if (!std::has_single_bit(gpio_pin) || period == 0ULL) {
+            std::fputs("sim: cannot start EXTI line\n", stderr);
+            std::abort();
+        }
+
+        auto& line = exti_lines[static_cast<std::size_t>(std::countr_zero(gpio_pin))];
+
+        cancel(&line);
+        line = EXTILine{.gpio_pin = gpio_pin, .period = period, .time = current_time + period};
+        schedule(period, exti_event, &line, 0UL, true);
+    }
+
+    void stop_exti(std::uint16_t const gpio_pin) noexcept
+    {
+        if (std::has_single_bit(gpio_pin)) {
+            cancel(&exti_lines[static_cast<std::size_t>(std::countr_zero(gpio_pin))]);
+        }
+    }
+
+    BusStatistics get_statistics(Bus const bus) noexcept
+    {
+        return statistics[std::to_underlying(bus)];
+    }
+
+    void reset_statistics() noexcept
+    {
+        statistics = {};
+    }
+
+}; // namespace Sim
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef SIM_HPP
+#define SIM_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstddef>
+#include <cstdint>
+
+// Control interface of the simulated HAL. Blocking HAL transfers advance the virtual clock by
+// their bus time, _IT/_DMA transfers schedule their completion callback on it. Pending events
+// run when the clock advances (blocking transfers, HAL_GetTick, HAL_*_GetState polling,
+// advance, run_until_idle) and are held back while PRIMASK is set.
+
+namespace Sim {
+
+    using Nanoseconds = std::uint64_t;
+
+    using SPIResponder = std::uint8_t (*)(void* const context, std::uint8_t const tx_byte) noexcept;
+
+    enum struct Bus : std::uint8_t {
+        I2C,
+        SPI,
+        UART,
+    };
+
+    struct BusStatistics {
+        std::uint64_t transfers = 0ULL;
+        std::uint64_t bytes = 0ULL;
+        std::uint64_t errors = 0ULL;
+        Nanoseconds busy_time = 0ULL;
+    };
+
+    Nanoseconds now() noexcept;
+
+    void advance(Nanoseconds const duration) noexcept;
+
+    bool run_next() noexcept;
+
+    void run_until_idle() noexcept;
+
+    void reset() noexcept;
+
+    void set_clocks(std::uint32_t const hclk, std::uint32_t const pclk1, std::uint32_t const pclk2) noexcept;
+
+    // A register file or memory behind dev_address. The first address_bytes bytes written after a start
+    // set its pointer, MSB first. With a page_size, writes wrap within their page like an EEPROM's and
+    // a stop after written data starts a write cycle of write_time during which the device NACKs.
+    void attach_i2c_device(I2C_HandleTypeDef* const i2c_bus,
+                           std::uint16_t const dev_address,
+                           std::uint8_t* const memory,
+                           std::size_t const size,
+                           std::size_t const address_bytes = 1UL,
+                           std::size_t const page_size = 0UL,
+                           Nanoseconds const write_time = 0ULL) noexcept;
+
+    void detach_i2c_devices() noexcept;
+
+    // a slave holding SDA low: BUSY stays set and blocking transfers fail with HAL_BUSY after the
+    // HAL's 25 ms busy flag wait until HAL_I2C_Init resets the peripheral
+    void hold_i2c_bus(I2C_HandleTypeDef* const i2c_bus) noexcept;
+
+    void attach_spi_responder(SPI_HandleTypeDef* const spi_bus,
+                              SPIResponder const responder,
+                              void* const context = nullptr) noexcept;
+
+    // A 1-Wire slave on the half-duplex line of uart_bus, driven the usual UART way: a character below
+    // 115200 baud is a reset pulse, answered with a presence pulse, every character at 115200 baud one time
+    // slot. It takes MATCH ROM, SKIP ROM, SEARCH ROM and, with alarm set, ALARM SEARCH, then CONVERT T,
+    // holding read slots low for conversion_time, and READ SCRATCHPAD of the 9 bytes at scratchpad.
+    void attach_ow_device(UART_HandleTypeDef* const uart_bus,
+                          std::uint64_t const rom,
+                          std::uint8_t const* const scratchpad,
+                          Nanoseconds const conversion_time = 0ULL,
+                          bool const alarm = false) noexcept;
+
+    void detach_ow_devices() noexcept;
+
+    // raises the EXTI line of gpio_pin every period, like a sensor's data-ready output, until stopped
+    void start_exti(std::uint16_t const gpio_pin, Nanoseconds const period) noexcept;
+
+    void stop_exti(std::uint16_t const gpio_pin) noexcept;
+
+    // counts steps, raising an update on each wrap, the last step as a TI1 edge captured on channel 1
+    void encoder_step(TIM_HandleTypeDef* const timer, std::int32_t const steps) noexcept;
+
+    BusStatistics get_statistics(Bus const bus) noexcept;
+
+    void reset_statistics() noexcept;
+
+}; // namespace Sim
+
+#endif // SIM_HPP
\ No newline at end of file
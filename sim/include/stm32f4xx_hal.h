@@ -0,0 +1,313 @@
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+// Host-side stand-in for the subset of the STM32F4 HAL and CMSIS used by stm32_utility.
+// Peripheral register blocks live at their real addresses (see sim.hpp), HAL transfer
+// functions are served by virtual peripherals that advance a virtual clock.
+
+#include <cstddef>
+#include <cstdint>
+
+#define __IO volatile
+#define __I volatile const
+
+#define SET_BIT(REG, BIT) ((REG) = (REG) | (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) = (REG) & ~(BIT))
+#define READ_BIT(REG, BIT) ((REG) & (BIT))
+#define WRITE_REG(REG, VAL) ((REG) = (VAL))
+#define READ_REG(REG) ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U,
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED = 0x01U,
+} HAL_LockTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+/* memory map */
+
+#define PERIPH_BASE 0x40000000UL
+#define APB1PERIPH_BASE PERIPH_BASE
+#define APB2PERIPH_BASE (PERIPH_BASE + 0x00010000UL)
+#define AHB1PERIPH_BASE (PERIPH_BASE + 0x00020000UL)
+
+#define TIM2_BASE (APB1PERIPH_BASE + 0x0000UL)
+#define TIM3_BASE (APB1PERIPH_BASE + 0x0400UL)
+#define TIM4_BASE (APB1PERIPH_BASE + 0x0800UL)
+#define TIM5_BASE (APB1PERIPH_BASE + 0x0C00UL)
+#define SPI2_BASE (APB1PERIPH_BASE + 0x3800UL)
+#define SPI3_BASE (APB1PERIPH_BASE + 0x3C00UL)
+#define USART2_BASE (APB1PERIPH_BASE + 0x4400UL)
+#define USART3_BASE (APB1PERIPH_BASE + 0x4800UL)
+#define I2C1_BASE (APB1PERIPH_BASE + 0x5400UL)
+#define I2C2_BASE (APB1PERIPH_BASE + 0x5800UL)
+#define I2C3_BASE (APB1PERIPH_BASE + 0x5C00UL)
+
+#define TIM1_BASE (APB2PERIPH_BASE + 0x0000UL)
+#define TIM8_BASE (APB2PERIPH_BASE + 0x0400UL)
+#define USART1_BASE (APB2PERIPH_BASE + 0x1000UL)
+#define USART6_BASE (APB2PERIPH_BASE + 0x1400UL)
+#define SPI1_BASE (APB2PERIPH_BASE + 0x3000UL)
+#define TIM9_BASE (APB2PERIPH_BASE + 0x4000UL)
+#define TIM10_BASE (APB2PERIPH_BASE + 0x4400UL)
+#define TIM11_BASE (APB2PERIPH_BASE + 0x4800UL)
+
+#define GPIOA_BASE (AHB1PERIPH_BASE + 0x0000UL)
+#define GPIOB_BASE (AHB1PERIPH_BASE + 0x0400UL)
+#define GPIOC_BASE (AHB1PERIPH_BASE + 0x0800UL)
+#define GPIOD_BASE (AHB1PERIPH_BASE + 0x0C00UL)
+#define GPIOE_BASE (AHB1PERIPH_BASE + 0x1000UL)
+#define GPIOF_BASE (AHB1PERIPH_BASE + 0x1400UL)
+#define GPIOG_BASE (AHB1PERIPH_BASE + 0x1800UL)
+#define GPIOH_BASE (AHB1PERIPH_BASE + 0x1C00UL)
+#define RCC_BASE (AHB1PERIPH_BASE + 0x3800UL)
+
+/* registers */
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t CRCPR;
+    __IO uint32_t RXCRCR;
+    __IO uint32_t TXCRCR;
+    __IO uint32_t I2SCFGR;
+    __IO uint32_t I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t OAR1;
+    __IO uint32_t OAR2;
+    __IO uint32_t DR;
+    __IO uint32_t SR1;
+    __IO uint32_t SR2;
+    __IO uint32_t CCR;
+    __IO uint32_t TRISE;
+    __IO uint32_t FLTR;
+} I2C_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+// BSRR is write-only on hardware, writes are applied to ODR and mirrored to IDR
+struct GPIO_BSRR_Register {
+    GPIO_BSRR_Register& operator=(uint32_t const bits) noexcept;
+
+    uint32_t value;
+};
+
+typedef struct GPIO_TypeDef {
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    GPIO_BSRR_Register BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR;
+    __IO uint32_t PLLCFGR;
+    __IO uint32_t CFGR;
+    __IO uint32_t CIR;
+    __IO uint32_t AHB1RSTR;
+    __IO uint32_t AHB2RSTR;
+    __IO uint32_t AHB3RSTR;
+    uint32_t RESERVED0;
+    __IO uint32_t APB1RSTR;
+    __IO uint32_t APB2RSTR;
+} RCC_TypeDef;
+
+#define TIM1 ((TIM_TypeDef*)TIM1_BASE)
+#define TIM2 ((TIM_TypeDef*)TIM2_BASE)
+#define TIM3 ((TIM_TypeDef*)TIM3_BASE)
+#define TIM4 ((TIM_TypeDef*)TIM4_BASE)
+#define TIM5 ((TIM_TypeDef*)TIM5_BASE)
+#define TIM8 ((TIM_TypeDef*)TIM8_BASE)
+#define TIM9 ((TIM_TypeDef*)TIM9_BASE)
+#define TIM10 ((TIM_TypeDef*)TIM10_BASE)
+#define TIM11 ((TIM_TypeDef*)TIM11_BASE)
+#define SPI1 ((SPI_TypeDef*)SPI1_BASE)
+#define SPI2 ((SPI_TypeDef*)SPI2_BASE)
+#define SPI3 ((SPI_TypeDef*)SPI3_BASE)
+#define I2C1 ((I2C_TypeDef*)I2C1_BASE)
+#define I2C2 ((I2C_TypeDef*)I2C2_BASE)
+#define I2C3 ((I2C_TypeDef*)I2C3_BASE)
+#define USART1 ((USART_TypeDef*)USART1_BASE)
+#define USART2 ((USART_TypeDef*)USART2_BASE)
+#define USART3 ((USART_TypeDef*)USART3_BASE)
+#define USART6 ((USART_TypeDef*)USART6_BASE)
+#define GPIOA ((GPIO_TypeDef*)GPIOA_BASE)
+#define GPIOB ((GPIO_TypeDef*)GPIOB_BASE)
+#define GPIOC ((GPIO_TypeDef*)GPIOC_BASE)
+#define GPIOD ((GPIO_TypeDef*)GPIOD_BASE)
+#define GPIOE ((GPIO_TypeDef*)GPIOE_BASE)
+#define GPIOF ((GPIO_TypeDef*)GPIOF_BASE)
+#define GPIOG ((GPIO_TypeDef*)GPIOG_BASE)
+#define GPIOH ((GPIO_TypeDef*)GPIOH_BASE)
+#define RCC ((RCC_TypeDef*)RCC_BASE)
+
+#define RCC_CFGR_PPRE1 (0x7U << 10U)
+#define RCC_CFGR_PPRE1_DIV1 0x00000000U
+#define RCC_CFGR_PPRE1_DIV2 (0x4U << 10U)
+#define RCC_CFGR_PPRE1_DIV4 (0x5U << 10U)
+#define RCC_CFGR_PPRE2 (0x7U << 13U)
+#define RCC_CFGR_PPRE2_DIV1 0x00000000U
+#define RCC_CFGR_PPRE2_DIV2 (0x4U << 13U)
+
+#define TIM_CR1_CEN (0x1U << 0U)
+#define TIM_CR1_UDIS (0x1U << 1U)
+#define TIM_CR1_URS (0x1U << 2U)
+#define TIM_CR1_DIR (0x1U << 4U)
+#define TIM_CR1_ARPE (0x1U << 7U)
+#define TIM_CR2_MMS (0x7U << 4U)
+#define TIM_SMCR_SMS (0x7U << 0U)
+#define TIM_SMCR_TS (0x7U << 4U)
+#define TIM_SMCR_MSM (0x1U << 7U)
+#define TIM_DIER_UIE (0x1U << 0U)
+#define TIM_DIER_CC1IE (0x1U << 1U)
+#define TIM_SR_UIF (0x1U << 0U)
+#define TIM_SR_CC1IF (0x1U << 1U)
+#define TIM_SR_CC3IF (0x1U << 3U)
+#define TIM_SR_CC1OF (0x1U << 9U)
+#define TIM_SR_CC3OF (0x1U << 11U)
+#define TIM_EGR_UG (0x1U << 0U)
+#define TIM_CCMR1_CC1S (0x3U << 0U)
+#define TIM_CCMR1_OC1PE (0x1U << 3U)
+#define TIM_CCMR1_OC2PE (0x1U << 11U)
+#define TIM_CCMR2_OC3PE (0x1U << 3U)
+#define TIM_CCMR2_OC4PE (0x1U << 11U)
+#define TIM_CCER_CC1E (0x1U << 0U)
+#define TIM_CCER_CC2E (0x1U << 4U)
+#define TIM_CCER_CC3E (0x1U << 8U)
+#define TIM_CCER_CC4E (0x1U << 12U)
+#define TIM_BDTR_MOE (0x1U << 15U)
+
+#define SPI_CR1_CPHA (0x1U << 0U)
+#define SPI_CR1_CPOL (0x1U << 1U)
+#define SPI_CR1_BR (0x7U << 3U)
+#define SPI_CR1_SPE (0x1U << 6U)
+#define SPI_CR1_LSBFIRST (0x1U << 7U)
+#define SPI_CR1_DFF (0x1U << 11U)
+
+#define I2C_CR1_PE (0x1U << 0U)
+#define I2C_CR1_SWRST (0x1U << 15U)
+#define I2C_SR2_BUSY (0x1U << 1U)
+
+#define USART_CR1_OVER8 (0x1U << 15U)
+
+/* CMSIS core */
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+    __IO uint32_t CPICNT;
+    __IO uint32_t EXCCNT;
+    __IO uint32_t SLEEPCNT;
+    __IO uint32_t LSUCNT;
+    __IO uint32_t FOLDCNT;
+    __I uint32_t PCSR;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR;
+    __IO uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define SCS_BASE 0xE000E000UL
+#define DWT_BASE 0xE0001000UL
+#define CoreDebug_BASE 0xE000EDF0UL
+
+#define DWT ((DWT_Type*)DWT_BASE)
+#define CoreDebug ((CoreDebug_Type*)CoreDebug_BASE)
+
+#define DWT_CTRL_CYCCNTENA_Msk (0x1U << 0U)
+#define CoreDebug_DEMCR_TRCENA_Msk (0x1U << 24U)
+
+uint32_t __get_PRIMASK(void) noexcept;
+void __set_PRIMASK(uint32_t priMask) noexcept;
+void __disable_irq(void) noexcept;
+void __enable_irq(void) noexcept;
+void __DMB(void) noexcept;
+void __DSB(void) noexcept;
+void __ISB(void) noexcept;
+void __NOP(void) noexcept;
+void __WFI(void) noexcept;
+
+extern uint32_t SystemCoreClock;
+
+/* HAL core and RCC */
+
+uint32_t HAL_GetTick(void) noexcept;
+void HAL_Delay(uint32_t Delay) noexcept;
+uint32_t HAL_GetTickFreq(void) noexcept;
+
+uint32_t HAL_RCC_GetHCLKFreq(void) noexcept;
+uint32_t HAL_RCC_GetPCLK1Freq(void) noexcept;
+uint32_t HAL_RCC_GetPCLK2Freq(void) noexcept;
+
+/* DMA */
+
+typedef struct __DMA_HandleTypeDef {
+    void* Instance;
+    void* Parent;
+} DMA_HandleTypeDef;
+
+#include "stm32f4xx_hal_gpio.h"
+#include "stm32f4xx_hal_i2c.h"
+#include "stm32f4xx_hal_spi.h"
+#include "stm32f4xx_hal_tim.h"
+#include "stm32f4xx_hal_uart.h"
+#include "stm32f4xx_hal_usart.h"
+
+#endif // STM32F4XX_HAL_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef STM32F4XX_HAL_I2C_H
+#define STM32F4XX_HAL_I2C_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t ClockSpeed;
+    uint32_t DutyCycle;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+    uint32_t DualAddressMode;
+    uint32_t OwnAddress2;
+    uint32_t GeneralCallMode;
+    uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef enum {
+    HAL_I2C_STATE_RESET = 0x00U,
+    HAL_I2C_STATE_READY = 0x20U,
+    HAL_I2C_STATE_BUSY = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U,
+    HAL_I2C_STATE_BUSY_RX = 0x22U,
+    HAL_I2C_STATE_ABORT = 0x60U,
+    HAL_I2C_STATE_TIMEOUT = 0xA0U,
+    HAL_I2C_STATE_ERROR = 0xE0U,
+} HAL_I2C_StateTypeDef;
+
+typedef struct __I2C_HandleTypeDef {
+    I2C_TypeDef* Instance;
+    I2C_InitTypeDef Init;
+    uint8_t* pBuffPtr;
+    uint16_t XferSize;
+    __IO uint16_t XferCount;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    HAL_LockTypeDef Lock;
+    __IO uint32_t XferOptions;
+    __IO uint32_t PreviousState;
+    __IO HAL_I2C_StateTypeDef State;
+    __IO uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT (0x00000001U)
+#define I2C_MEMADD_SIZE_16BIT (0x00000010U)
+
+#define I2C_FIRST_FRAME (0x00000001U)
+#define I2C_FIRST_AND_NEXT_FRAME (0x00000002U)
+#define I2C_NEXT_FRAME (0x00000004U)
+#define I2C_FIRST_AND_LAST_FRAME (0x00000008U)
+#define I2C_LAST_FRAME_NO_STOP (0x00000010U)
+#define I2C_LAST_FRAME (0x00000020U)
+
+#define HAL_I2C_ERROR_NONE (0x00000000U)
+#define HAL_I2C_ERROR_BERR (0x00000001U)
+#define HAL_I2C_ERROR_ARLO (0x00000002U)
+#define HAL_I2C_ERROR_AF (0x00000004U)
+#define HAL_I2C_ERROR_OVR (0x00000008U)
+#define HAL_I2C_ERROR_DMA (0x00000010U)
+#define HAL_I2C_ERROR_TIMEOUT (0x00000020U)
+
+// bits 16-23 select SR1 (0x01) or SR2 (0x10)
+#define I2C_FLAG_MASK (0x0000FFFFU)
+#define I2C_FLAG_BUSY (0x00100002U)
+
+#define __HAL_I2C_GET_FLAG(__HANDLE__, __FLAG__)                                                        \
+    ((((uint8_t)((__FLAG__) >> 16U)) == 0x01U)                                                          \
+         ? (((__HANDLE__)->Instance->SR1 & ((__FLAG__) & I2C_FLAG_MASK)) == ((__FLAG__) & I2C_FLAG_MASK)) \
+         : (((__HANDLE__)->Instance->SR2 & ((__FLAG__) & I2C_FLAG_MASK)) == ((__FLAG__) & I2C_FLAG_MASK)))
+
+#define __HAL_I2C_ENABLE(__HANDLE__) ((__HANDLE__)->Instance->CR1 = (__HANDLE__)->Instance->CR1 | I2C_CR1_PE)
+#define __HAL_I2C_DISABLE(__HANDLE__) ((__HANDLE__)->Instance->CR1 = (__HANDLE__)->Instance->CR1 & ~I2C_CR1_PE)
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c) noexcept;
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c) noexcept;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef* hi2c,
+                                          uint16_t DevAddress,
+                                          uint8_t* pData,
+                                          uint16_t Size,
+                                          uint32_t Timeout) noexcept;
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef* hi2c,
+                                         uint16_t DevAddress,
+                                         uint8_t* pData,
+                                         uint16_t Size,
+                                         uint32_t Timeout) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* hi2c,
+                                    uint16_t DevAddress,
+                                    uint16_t MemAddress,
+                                    uint16_t MemAddSize,
+                                    uint8_t* pData,
+                                    uint16_t Size,
+                                    uint32_t Timeout) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* hi2c,
+                                   uint16_t DevAddress,
+                                   uint16_t MemAddress,
+                                   uint16_t MemAddSize,
+                                   uint8_t* pData,
+                                   uint16_t Size,
+                                   uint32_t Timeout) noexcept;
+HAL_StatusTypeDef
+HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout) noexcept;
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef
+HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* hi2c,
+                                       uint16_t DevAddress,
+                                       uint16_t MemAddress,
+                                       uint16_t MemAddSize,
+                                       uint8_t* pData,
+                                       uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* hi2c,
+                                      uint16_t DevAddress,
+                                      uint16_t MemAddress,
+                                      uint16_t MemAddSize,
+                                      uint8_t* pData,
+                                      uint16_t Size) noexcept;
+
+HAL_StatusTypeDef
+HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef
+HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef* hi2c,
+                                        uint16_t DevAddress,
+                                        uint16_t MemAddress,
+                                        uint16_t MemAddSize,
+                                        uint8_t* pData,
+                                        uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef* hi2c,
+                                       uint16_t DevAddress,
+                                       uint16_t MemAddress,
+                                       uint16_t MemAddSize,
+                                       uint8_t* pData,
+                                       uint16_t Size) noexcept;
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c,
+                                                 uint16_t DevAddress,
+                                                 uint8_t* pData,
+                                                 uint16_t Size,
+                                                 uint32_t XferOptions) noexcept;
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c,
+                                                uint16_t DevAddress,
+                                                uint8_t* pData,
+                                                uint16_t Size,
+                                                uint32_t XferOptions) noexcept;
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_DMA(I2C_HandleTypeDef* hi2c,
+                                                  uint16_t DevAddress,
+                                                  uint8_t* pData,
+                                                  uint16_t Size,
+                                                  uint32_t XferOptions) noexcept;
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_DMA(I2C_HandleTypeDef* hi2c,
+                                                 uint16_t DevAddress,
+                                                 uint8_t* pData,
+                                                 uint16_t Size,
+                                                 uint32_t XferOptions) noexcept;
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress) noexcept;
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c) noexcept;
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c) noexcept;
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+#endif // STM32F4XX_HAL_I2C_H
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef STM32F4XX_HAL_SPI_H
+#define STM32F4XX_HAL_SPI_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+    uint32_t TIMode;
+    uint32_t CRCCalculation;
+    uint32_t CRCPolynomial;
+} SPI_InitTypeDef;
+
+typedef enum {
+    HAL_SPI_STATE_RESET = 0x00U,
+    HAL_SPI_STATE_READY = 0x01U,
+    HAL_SPI_STATE_BUSY = 0x02U,
+    HAL_SPI_STATE_BUSY_TX = 0x03U,
+    HAL_SPI_STATE_BUSY_RX = 0x04U,
+    HAL_SPI_STATE_BUSY_TX_RX = 0x05U,
+    HAL_SPI_STATE_ERROR = 0x06U,
+    HAL_SPI_STATE_ABORT = 0x07U,
+} HAL_SPI_StateTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+    SPI_TypeDef* Instance;
+    SPI_InitTypeDef Init;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    HAL_LockTypeDef Lock;
+    __IO HAL_SPI_StateTypeDef State;
+    __IO uint32_t ErrorCode;
+} SPI_HandleTypeDef;
+
+#define SPI_MODE_SLAVE (0x00000000U)
+#define SPI_MODE_MASTER (0x00000104U)
+#define SPI_DATASIZE_8BIT (0x00000000U)
+#define SPI_DATASIZE_16BIT (0x00000800U)
+#define SPI_POLARITY_LOW (0x00000000U)
+#define SPI_POLARITY_HIGH (0x00000002U)
+#define SPI_PHASE_1EDGE (0x00000000U)
+#define SPI_PHASE_2EDGE (0x00000001U)
+#define SPI_BAUDRATEPRESCALER_2 (0x00000000U)
+#define SPI_BAUDRATEPRESCALER_4 (0x00000008U)
+#define SPI_BAUDRATEPRESCALER_8 (0x00000010U)
+#define SPI_BAUDRATEPRESCALER_16 (0x00000018U)
+#define SPI_BAUDRATEPRESCALER_32 (0x00000020U)
+#define SPI_BAUDRATEPRESCALER_64 (0x00000028U)
+#define SPI_BAUDRATEPRESCALER_128 (0x00000030U)
+#define SPI_BAUDRATEPRESCALER_256 (0x00000038U)
+#define SPI_FIRSTBIT_MSB (0x00000000U)
+#define SPI_FIRSTBIT_LSB (0x00000080U)
+
+#define HAL_SPI_ERROR_NONE (0x00000000U)
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi) noexcept;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, const uint8_t* pData, uint16_t Size, uint32_t Timeout) noexcept;
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size, uint32_t Timeout) noexcept;
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi,
+                                          const uint8_t* pTxData,
+                                          uint8_t* pRxData,
+                                          uint16_t Size,
+                                          uint32_t Timeout) noexcept;
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, const uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi,
+                                              const uint8_t* pTxData,
+                                              uint8_t* pRxData,
+                                              uint16_t Size) noexcept;
+
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef* hspi) noexcept;
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi) noexcept;
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef* hspi) noexcept;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi);
+
+#endif // STM32F4XX_HAL_SPI_H
\ No newline at end of file
@@ -0,0 +1,192 @@
+#ifndef STM32F4XX_HAL_TIM_H
+#define STM32F4XX_HAL_TIM_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef enum {
+    HAL_TIM_STATE_RESET = 0x00U,
+    HAL_TIM_STATE_READY = 0x01U,
+    HAL_TIM_STATE_BUSY = 0x02U,
+    HAL_TIM_STATE_TIMEOUT = 0x03U,
+    HAL_TIM_STATE_ERROR = 0x04U,
+} HAL_TIM_StateTypeDef;
+
+typedef enum {
+    HAL_TIM_CHANNEL_STATE_RESET = 0x00U,
+    HAL_TIM_CHANNEL_STATE_READY = 0x01U,
+    HAL_TIM_CHANNEL_STATE_BUSY = 0x02U,
+} HAL_TIM_ChannelStateTypeDef;
+
+typedef enum {
+    HAL_DMA_BURST_STATE_RESET = 0x00U,
+    HAL_DMA_BURST_STATE_READY = 0x01U,
+    HAL_DMA_BURST_STATE_BUSY = 0x02U,
+} HAL_TIM_DMABurstStateTypeDef;
+
+typedef enum {
+    HAL_TIM_ACTIVE_CHANNEL_1 = 0x01U,
+    HAL_TIM_ACTIVE_CHANNEL_2 = 0x02U,
+    HAL_TIM_ACTIVE_CHANNEL_3 = 0x04U,
+    HAL_TIM_ACTIVE_CHANNEL_4 = 0x08U,
+    HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U,
+} HAL_TIM_ActiveChannel;
+
+typedef struct {
+    uint32_t EncoderMode;
+    uint32_t IC1Polarity;
+    uint32_t IC1Selection;
+    uint32_t IC1Prescaler;
+    uint32_t IC1Filter;
+    uint32_t IC2Polarity;
+    uint32_t IC2Selection;
+    uint32_t IC2Prescaler;
+    uint32_t IC2Filter;
+} TIM_Encoder_InitTypeDef;
+
+typedef struct {
+    uint32_t ICPolarity;
+    uint32_t ICSelection;
+    uint32_t ICPrescaler;
+    uint32_t ICFilter;
+} TIM_IC_InitTypeDef;
+
+typedef struct __TIM_HandleTypeDef {
+    TIM_TypeDef* Instance;
+    TIM_Base_InitTypeDef Init;
+    HAL_TIM_ActiveChannel Channel;
+    DMA_HandleTypeDef* hdma[7];
+    HAL_LockTypeDef Lock;
+    __IO HAL_TIM_StateTypeDef State;
+    __IO HAL_TIM_ChannelStateTypeDef ChannelState[4];
+    __IO HAL_TIM_ChannelStateTypeDef ChannelNState[4];
+    __IO HAL_TIM_DMABurstStateTypeDef DMABurstState;
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+#define TIM_CHANNEL_ALL 0x0000003CU
+
+#define TIM_CCx_ENABLE 0x00000001U
+#define TIM_CCx_DISABLE 0x00000000U
+
+#define TIM_FLAG_UPDATE TIM_SR_UIF
+#define TIM_FLAG_CC1 TIM_SR_CC1IF
+#define TIM_FLAG_CC3 TIM_SR_CC3IF
+#define TIM_FLAG_CC1OF TIM_SR_CC1OF
+#define TIM_FLAG_CC3OF TIM_SR_CC3OF
+#define TIM_IT_UPDATE TIM_DIER_UIE
+#define TIM_IT_CC1 TIM_DIER_CC1IE
+
+#define TIM_ENCODERMODE_TI12 0x00000003U
+
+#define TIM_ICPOLARITY_RISING 0x00000000U
+#define TIM_ICSELECTION_DIRECTTI 0x00000001U
+#define TIM_ICSELECTION_INDIRECTTI 0x00000002U
+#define TIM_ICSELECTION_TRC 0x00000003U
+#define TIM_ICPSC_DIV1 0x00000000U
+
+#define TIM_TS_ITR0 0x00000000U
+#define TIM_TS_ITR1 0x00000010U
+#define TIM_TS_ITR2 0x00000020U
+#define TIM_TS_ITR3 0x00000030U
+
+#define TIM_SLAVEMODE_DISABLE 0x00000000U
+#define TIM_SLAVEMODE_RESET 0x00000004U
+#define TIM_SLAVEMODE_GATED 0x00000005U
+#define TIM_SLAVEMODE_TRIGGER 0x00000006U
+
+#define TIM_TRGO_RESET 0x00000000U
+#define TIM_TRGO_ENABLE 0x00000010U
+#define TIM_TRGO_UPDATE 0x00000020U
+
+#define IS_TIM_32B_COUNTER_INSTANCE(INSTANCE) (((INSTANCE) == TIM2) || ((INSTANCE) == TIM5))
+#define IS_TIM_BREAK_INSTANCE(INSTANCE) (((INSTANCE) == TIM1) || ((INSTANCE) == TIM8))
+
+#define __HAL_TIM_ENABLE(__HANDLE__) ((__HANDLE__)->Instance->CR1 = (__HANDLE__)->Instance->CR1 | (TIM_CR1_CEN))
+#define __HAL_TIM_DISABLE(__HANDLE__) ((__HANDLE__)->Instance->CR1 = (__HANDLE__)->Instance->CR1 & ~(TIM_CR1_CEN))
+#define __HAL_TIM_MOE_ENABLE(__HANDLE__) ((__HANDLE__)->Instance->BDTR = (__HANDLE__)->Instance->BDTR | (TIM_BDTR_MOE))
+#define __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(__HANDLE__) \
+    ((__HANDLE__)->Instance->BDTR = (__HANDLE__)->Instance->BDTR & ~(TIM_BDTR_MOE))
+
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__) \
+    ((__HANDLE__)->Instance->DIER = (__HANDLE__)->Instance->DIER | (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__) \
+    ((__HANDLE__)->Instance->DIER = (__HANDLE__)->Instance->DIER & ~(__INTERRUPT__))
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__) (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+// SR bits are rc_w0 on hardware, plain memory here
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__) \
+    ((__HANDLE__)->Instance->SR = (__HANDLE__)->Instance->SR & ~(__FLAG__))
+
+#define __HAL_TIM_IS_TIM_COUNTING_DOWN(__HANDLE__) (((__HANDLE__)->Instance->CR1 & (TIM_CR1_DIR)) == (TIM_CR1_DIR))
+#define __HAL_TIM_GET_COUNTER(__HANDLE__) ((__HANDLE__)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) ((__HANDLE__)->Instance->CNT = (__COUNTER__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__) ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__)    \
+    do {                                                        \
+        (__HANDLE__)->Instance->ARR = (__AUTORELOAD__);         \
+        (__HANDLE__)->Init.Period = (__AUTORELOAD__);           \
+    } while (0)
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__) ((__HANDLE__)->Instance->PSC = (__PRESC__))
+#define __HAL_TIM_GET_CLOCKDIVISION(__HANDLE__) ((__HANDLE__)->Instance->CR1 & (0x3U << 8U))
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+    (*(&(__HANDLE__)->Instance->CCR1 + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+#define __HAL_TIM_GET_COMPARE(__HANDLE__, __CHANNEL__) (*(&(__HANDLE__)->Instance->CCR1 + ((__CHANNEL__) >> 2U)))
+
+#define __HAL_TIM_ENABLE_OCxPRELOAD(__HANDLE__, __CHANNEL__)                                               \
+    (((__CHANNEL__) == TIM_CHANNEL_1)                                                                      \
+         ? ((__HANDLE__)->Instance->CCMR1 = (__HANDLE__)->Instance->CCMR1 | TIM_CCMR1_OC1PE)               \
+     : ((__CHANNEL__) == TIM_CHANNEL_2)                                                                    \
+         ? ((__HANDLE__)->Instance->CCMR1 = (__HANDLE__)->Instance->CCMR1 | TIM_CCMR1_OC2PE)               \
+     : ((__CHANNEL__) == TIM_CHANNEL_3)                                                                    \
+         ? ((__HANDLE__)->Instance->CCMR2 = (__HANDLE__)->Instance->CCMR2 | TIM_CCMR2_OC3PE)               \
+         : ((__HANDLE__)->Instance->CCMR2 = (__HANDLE__)->Instance->CCMR2 | TIM_CCMR2_OC4PE))
+
+#define TIM_CHANNEL_STATE_GET(__HANDLE__, __CHANNEL__) ((__HANDLE__)->ChannelState[((__CHANNEL__) >> 2U)])
+#define TIM_CHANNEL_STATE_SET(__HANDLE__, __CHANNEL__, __CHANNEL_STATE__) \
+    ((__HANDLE__)->ChannelState[((__CHANNEL__) >> 2U)] = (__CHANNEL_STATE__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim) noexcept;
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef* htim) noexcept;
+HAL_StatusTypeDef HAL_TIM_Encoder_Init(TIM_HandleTypeDef* htim, TIM_Encoder_InitTypeDef* sConfig) noexcept;
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim) noexcept;
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim) noexcept;
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) noexcept;
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim) noexcept;
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+HAL_StatusTypeDef
+HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef* htim, uint32_t Channel, const uint32_t* pData, uint16_t Length) noexcept;
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+
+HAL_StatusTypeDef
+HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef* htim, const TIM_IC_InitTypeDef* sConfig, uint32_t Channel) noexcept;
+HAL_StatusTypeDef HAL_TIM_IC_Start(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+HAL_StatusTypeDef HAL_TIM_IC_Stop(TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+uint32_t HAL_TIM_ReadCapturedValue(const TIM_HandleTypeDef* htim, uint32_t Channel) noexcept;
+
+void TIM_CCxChannelCmd(TIM_TypeDef* TIMx, uint32_t Channel, uint32_t ChannelState) noexcept;
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim);
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef* htim);
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef* htim);
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef* htim);
+
+#include "stm32f4xx_hal_tim_ex.h"
+
+#endif // STM32F4XX_HAL_TIM_H
\ No newline at end of file
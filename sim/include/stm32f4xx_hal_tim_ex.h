@@ -0,0 +1,17 @@
+#ifndef STM32F4XX_HAL_TIM_EX_H
+#define STM32F4XX_HAL_TIM_EX_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t MasterOutputTrigger;
+    uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+#define TIM_MASTERSLAVEMODE_DISABLE 0x00000000U
+#define TIM_MASTERSLAVEMODE_ENABLE 0x00000080U
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef* htim,
+                                                        const TIM_MasterConfigTypeDef* sMasterConfig) noexcept;
+
+#endif // STM32F4XX_HAL_TIM_EX_H
\ No newline at end of file
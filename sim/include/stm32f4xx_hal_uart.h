@@ -0,0 +1,58 @@
+#ifndef STM32F4XX_HAL_UART_H
+#define STM32F4XX_HAL_UART_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY = 0x24U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U,
+    HAL_UART_STATE_BUSY_TX_RX = 0x23U,
+    HAL_UART_STATE_TIMEOUT = 0xA0U,
+    HAL_UART_STATE_ERROR = 0xE0U,
+} HAL_UART_StateTypeDef;
+
+typedef struct __UART_HandleTypeDef {
+    USART_TypeDef* Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    HAL_LockTypeDef Lock;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#define UART_OVERSAMPLING_16 0x00000000U
+#define UART_OVERSAMPLING_8 ((uint32_t)USART_CR1_OVER8)
+
+#define UART_DIV_SAMPLING16(_PCLK_, _BAUD_) ((uint32_t)((((uint64_t)(_PCLK_)) * 25U) / (4U * ((uint64_t)(_BAUD_)))))
+#define UART_DIV_SAMPLING8(_PCLK_, _BAUD_) ((uint32_t)((((uint64_t)(_PCLK_)) * 25U) / (2U * ((uint64_t)(_BAUD_)))))
+#define UART_BRR_SAMPLING16(_PCLK_, _BAUD_) ((UART_DIV_SAMPLING16((_PCLK_), (_BAUD_)) * 16U + 50U) / 100U)
+#define UART_BRR_SAMPLING8(_PCLK_, _BAUD_) ((UART_DIV_SAMPLING8((_PCLK_), (_BAUD_)) * 8U + 50U) / 100U)
+
+HAL_StatusTypeDef HAL_HalfDuplex_Init(UART_HandleTypeDef* huart) noexcept;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* pData, uint16_t Size) noexcept;
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef* huart) noexcept;
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef* huart) noexcept;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+
+#endif // STM32F4XX_HAL_UART_H
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef STM32F4XX_HAL_USART_H
+#define STM32F4XX_HAL_USART_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t CLKLastBit;
+} USART_InitTypeDef;
+
+typedef struct __USART_HandleTypeDef {
+    USART_TypeDef* Instance;
+    USART_InitTypeDef Init;
+    __IO uint32_t ErrorCode;
+} USART_HandleTypeDef;
+
+#endif // STM32F4XX_HAL_USART_H
\ No newline at end of file
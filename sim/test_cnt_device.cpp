@@ -0,0 +1,206 @@
+#include "cnt_device.hpp"
+#include "sim.hpp"
+#include <cmath>
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// CNTDevice on the simulated TIM4 in encoder mode with a 100 count period, so position tracking crosses
+// the wrap every few steps, and velocity checked against pulse trains of known rate
+namespace {
+
+    constexpr std::int64_t PERIOD = 100LL;
+
+    TIM_HandleTypeDef timer_handle = {};
+
+    auto cnt_device = CNTDevice{};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        // the simulator keeps register contents across resets
+        TIM4->CR1 = 0UL;
+        TIM4->SR = 0UL;
+        TIM4->DIER = 0UL;
+
+        timer_handle.Instance = TIM4;
+        timer_handle.Init.Period = static_cast<std::uint32_t>(PERIOD - 1LL);
+        auto config = TIM_Encoder_InitTypeDef{.EncoderMode = TIM_ENCODERMODE_TI12,
+                                              .IC1Polarity = TIM_ICPOLARITY_RISING,
+                                              .IC1Selection = TIM_ICSELECTION_DIRECTTI,
+                                              .IC1Prescaler = TIM_ICPSC_DIV1,
+                                              .IC1Filter = 0UL,
+                                              .IC2Polarity = TIM_ICPOLARITY_RISING,
+                                              .IC2Selection = TIM_ICSELECTION_DIRECTTI,
+                                              .IC2Prescaler = TIM_ICPSC_DIV1,
+                                              .IC2Filter = 0UL};
+        HAL_TIM_Encoder_Init(&timer_handle, &config);
+
+        cnt_device = CNTDevice{.timer = &timer_handle};
+        cnt_device.initialize();
+    }
+
+    std::uint32_t get_timestamp() noexcept
+    {
+        return static_cast<std::uint32_t>(Sim::now() / 1000ULL);
+    }
+
+    // steps every interval, sampling every sample_interval edges, returns the last velocity
+    std::float32_t run_pulse_train(std::int32_t const steps,
+                                   Sim::Nanoseconds const interval,
+                                   std::size_t const edges,
+                                   std::size_t const sample_interval) noexcept
+    {
+        auto wait = interval;
+
+        for (std::size_t edge = 1UL; edge <= edges; ++edge) {
+            Sim::advance(wait);
+            Sim::encoder_step(&timer_handle, steps);
+            wait = interval;
+
+            // sampled off the edges, a third of the way to the next one
+            if (edge % sample_interval == 0UL) {
+                Sim::advance(interval / 3ULL);
+                cnt_device.sample(get_timestamp());
+                wait -= interval / 3ULL;
+            }
+        }
+
+        return cnt_device.get_snapshot().velocity;
+    }
+
+    bool is_near(std::float32_t const value, std::float32_t const expected) noexcept
+    {
+        return std::abs(value - expected) <= std::abs(expected) * 1.0E-3F32;
+    }
+
+    void test_position() noexcept
+    {
+        setup();
+
+        Sim::encoder_step(&timer_handle, 150);
+        check(cnt_device.get_position() == 150LL && cnt_device.get_count() == 50UL, "position across overflow");
+
+        Sim::encoder_step(&timer_handle, -300);
+        check(cnt_device.get_position() == -150LL && cnt_device.get_count() == 50UL, "position across underflows");
+
+        // forward over the wrap and straight back
+        Sim::encoder_step(&timer_handle, 49);
+        Sim::encoder_step(&timer_handle, 1);
+        Sim::encoder_step(&timer_handle, -1);
+        check(cnt_device.get_position() == -101LL, "reversal at the wrap");
+        Sim::encoder_step(&timer_handle, 1);
+        check(cnt_device.get_position() == -100LL, "reversal back over the wrap");
+
+        check(cnt_device.get_count_difference() == -100 && cnt_device.get_count_difference() == 0,
+              "count difference since the last call");
+    }
+
+    void test_late_update() noexcept
+    {
+        setup();
+
+        // the update interrupt held off while the counter runs more than half a period past the wrap
+        Sim::encoder_step(&timer_handle, 98);
+        __HAL_TIM_DISABLE_IT(&timer_handle, TIM_IT_UPDATE);
+        Sim::encoder_step(&timer_handle, 60);
+        check(cnt_device.get_position() == 158LL, "pending overflow read from DIR");
+
+        __HAL_TIM_CLEAR_FLAG(&timer_handle, TIM_FLAG_UPDATE);
+        cnt_device.update_callback(&timer_handle);
+        check(cnt_device.get_position() == 158LL, "late overflow applied from DIR");
+
+        Sim::encoder_step(&timer_handle, -100);
+        check(cnt_device.get_position() == 58LL, "pending underflow read from DIR");
+
+        __HAL_TIM_CLEAR_FLAG(&timer_handle, TIM_FLAG_UPDATE);
+        cnt_device.update_callback(&timer_handle);
+        __HAL_TIM_ENABLE_IT(&timer_handle, TIM_IT_UPDATE);
+        check(cnt_device.get_position() == 58LL, "late underflow applied from DIR");
+    }
+
+    void test_velocity() noexcept
+    {
+        setup();
+
+        // an edge every 100 us, wrapping every 10 ms
+        check(is_near(run_pulse_train(1, 100000ULL, 200UL, 10UL), 10000.0F32), "10000 counts/s");
+        check(is_near(run_pulse_train(-1, 100000ULL, 200UL, 10UL), -10000.0F32), "-10000 counts/s in reverse");
+
+        // 5 counts every 10 us, several wraps between samples
+        check(is_near(run_pulse_train(5, 10000ULL, 1000UL, 37UL), 500000.0F32), "500000 counts/s");
+
+        // a sample after every edge
+        check(is_near(run_pulse_train(1, 1000000ULL, 20UL, 1UL), 1000.0F32), "1000 counts/s");
+        check(cnt_device.get_position() == 5020LL, "position after the pulse trains");
+
+        // an edge every 20 ms, then samples every 1 ms that see none
+        setup();
+        auto const crawl = run_pulse_train(1, 20000000ULL, 5UL, 1UL);
+        check(is_near(crawl, 50.0F32), "50 counts/s");
+
+        auto bounded = true;
+        for (auto millisecond = 1UL; millisecond < 20UL; ++millisecond) {
+            Sim::advance(1000000ULL);
+            cnt_device.sample(get_timestamp());
+            bounded = bounded && cnt_device.get_snapshot().velocity == crawl;
+        }
+        check(bounded, "crawl held between edges");
+    }
+
+    void test_standstill() noexcept
+    {
+        setup();
+
+        run_pulse_train(1, 100000ULL, 100UL, 10UL);
+
+        // no edge for 10 ms bounds the speed by 4 counts over 10 ms
+        Sim::advance(10000000ULL);
+        cnt_device.sample(get_timestamp());
+        check(std::abs(cnt_device.get_snapshot().velocity) <= 400.0F32 + 1.0F32, "speed bounded without edges");
+
+        Sim::advance(100000000ULL);
+        cnt_device.sample(get_timestamp());
+        check(cnt_device.get_snapshot().velocity == 0.0F32, "standstill after the timeout");
+
+        // the first edge after standstill only starts the next measurement
+        Sim::encoder_step(&timer_handle, 1);
+        cnt_device.sample(get_timestamp());
+        check(cnt_device.get_snapshot().velocity == 0.0F32, "no velocity from a single edge");
+        check(cnt_device.get_snapshot().position == 101LL, "snapshot position");
+    }
+
+}; // namespace
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim)
+{
+    cnt_device.update_callback(htim);
+}
+
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef* htim)
+{
+    cnt_device.capture_callback(htim);
+}
+
+int main()
+{
+    test_position();
+    test_late_update();
+    test_velocity();
+    test_standstill();
+
+    std::printf("CNT device tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
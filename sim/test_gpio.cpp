@@ -0,0 +1,118 @@
+#include "gpio_group.hpp"
+#include "gpio_pin.hpp"
+#include "sim.hpp"
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// GPIOPin and GPIOGroup against the simulated port registers, the value bits checked pin by pin through
+// the run time gpio_read_pin
+namespace {
+
+    using LED = GPIOPin<GPIO::PA5>;
+
+    // contiguous on one port, written with a single shift
+    using Nibble = GPIOGroup<GPIO::PA8, GPIO::PA9, GPIO::PA10, GPIO::PA11>;
+
+    // scattered over three ports, out of order within port B
+    using Scattered = GPIOGroup<GPIO::PB3, GPIO::PC13, GPIO::PB1, GPIO::PA0, GPIO::PB2>;
+
+    static_assert(Nibble::SIZE == 4UL && Nibble::VALUE_MASK == 0xFU);
+    static_assert(Scattered::VALUE_MASK == 0x1FU);
+    static_assert(LED::SET_MASK == 0x20U && LED::RESET_MASK == 0x200000U);
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    template <GPIO... PINS>
+    std::uint32_t read_pins() noexcept
+    {
+        auto const pins = std::array<GPIO, sizeof...(PINS)>{PINS...};
+        auto value = std::uint32_t{0U};
+
+        for (std::size_t index = 0UL; index < pins.size(); ++index) {
+            if (gpio_read_pin(pins[index]) == GPIO_PIN_SET) {
+                value |= 1U << index;
+            }
+        }
+
+        return value;
+    }
+
+    void test_pin() noexcept
+    {
+        Sim::reset();
+
+        gpio_write_pin(GPIO::PA4, GPIO_PIN_SET);
+
+        LED::set();
+        check(LED::read() == GPIO_PIN_SET && gpio_read_pin(GPIO::PA5) == GPIO_PIN_SET, "pin set");
+
+        LED::toggle();
+        check(LED::read() == GPIO_PIN_RESET, "pin toggled");
+
+        LED::write(GPIO_PIN_SET);
+        LED::reset();
+        check(LED::read() == GPIO_PIN_RESET, "pin reset");
+        check(gpio_read_pin(GPIO::PA4) == GPIO_PIN_SET, "neighbouring pin untouched");
+    }
+
+    void test_contiguous() noexcept
+    {
+        Sim::reset();
+
+        gpio_write_pin(GPIO::PA7, GPIO_PIN_SET);
+
+        for (auto value = 0U; value <= Nibble::VALUE_MASK; ++value) {
+            Nibble::write(value);
+            check(Nibble::read() == value, "contiguous group reads back");
+            check(read_pins<GPIO::PA8, GPIO::PA9, GPIO::PA10, GPIO::PA11>() == value, "contiguous group bit order");
+        }
+
+        check(gpio_read_pin(GPIO::PA7) == GPIO_PIN_SET && gpio_read_pin(GPIO::PA12) == GPIO_PIN_RESET,
+              "contiguous group leaves other pins alone");
+    }
+
+    void test_scattered() noexcept
+    {
+        Sim::reset();
+
+        gpio_write_pin(GPIO::PB0, GPIO_PIN_SET);
+
+        for (auto value = 0U; value <= Scattered::VALUE_MASK; ++value) {
+            Scattered::write(value);
+            check(Scattered::read() == value, "scattered group reads back");
+            check(read_pins<GPIO::PB3, GPIO::PC13, GPIO::PB1, GPIO::PA0, GPIO::PB2>() == value,
+                  "scattered group bit order");
+        }
+
+        Scattered::set();
+        check(Scattered::read() == Scattered::VALUE_MASK, "group set");
+        Scattered::reset();
+        check(Scattered::read() == 0U, "group reset");
+
+        // bits above the group are ignored
+        Scattered::write(0xFFFFFFE0U);
+        check(Scattered::read() == 0U, "bits past the group ignored");
+        check(gpio_read_pin(GPIO::PB0) == GPIO_PIN_SET, "scattered group leaves other pins alone");
+    }
+
+}; // namespace
+
+int main()
+{
+    test_pin();
+    test_contiguous();
+    test_scattered();
+
+    std::printf("GPIO tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
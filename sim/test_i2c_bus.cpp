@@ -0,0 +1,243 @@
+#include "i2c_bus.hpp"
+#include "sim.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <span>
+
+using namespace STM32_Utility;
+
+// I2CBus queue against the simulated devices of sim/hal.cpp: order, data and full queue, in interrupt
+// and DMA mode
+namespace {
+
+    constexpr std::uint16_t EEPROM_ADDRESS = 0x50U;
+    constexpr std::uint16_t SENSOR_ADDRESS = 0x68U;
+    constexpr std::uint16_t ABSENT_ADDRESS = 0x51U;
+
+    I2C_HandleTypeDef i2c_handle = {};
+
+    std::array<std::uint8_t, 256UL> eeprom = {};
+    std::array<std::uint8_t, 16UL> sensor = {};
+
+    auto i2c_bus = I2CBus{};
+    auto eeprom_device = I2CDevice{.i2c_bus = &i2c_handle, .dev_address = EEPROM_ADDRESS};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // completions in the order the callbacks ran
+    std::size_t completed = 0UL;
+
+    struct Result {
+        HAL_StatusTypeDef status = HAL_BUSY;
+        std::size_t sequence = 0UL;
+        std::uint32_t error_code = HAL_I2C_ERROR_NONE;
+    };
+
+    void transaction_done(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        auto& done = *static_cast<Result*>(context);
+
+        done.status = result;
+        done.sequence = completed++;
+    }
+
+    void setup(bool const use_dma) noexcept
+    {
+        Sim::reset();
+
+        i2c_handle.Instance = I2C1;
+        i2c_handle.Init.ClockSpeed = 400000UL;
+        HAL_I2C_Init(&i2c_handle);
+
+        eeprom.fill(0xFFU);
+        for (std::size_t index = 0UL; index < sensor.size(); ++index) {
+            sensor[index] = static_cast<std::uint8_t>(0xA0UL + index);
+        }
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS, eeprom.data(), eeprom.size());
+        Sim::attach_i2c_device(&i2c_handle, SENSOR_ADDRESS, sensor.data(), sensor.size());
+
+        i2c_bus = I2CBus{.i2c_bus = &i2c_handle, .use_dma = use_dma};
+        completed = 0UL;
+    }
+
+    void test_order(bool const use_dma) noexcept
+    {
+        setup(use_dma);
+
+        auto written = std::array<std::uint8_t, 8UL>{1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+        auto read = std::array<std::uint8_t, 8UL>{};
+        auto pointer = std::array<std::uint8_t, 1UL>{0x04U};
+        auto received = std::array<std::uint8_t, 4UL>{};
+        auto results = std::array<Result, 4UL>{};
+
+        // the read is queued behind the write of the same bytes and must see them
+        check(i2c_bus.enqueue_write(
+                  eeprom_device, 0x20U, written.data(), written.size(), &transaction_done, &results[0]),
+              "write queued");
+        check(i2c_bus.enqueue_read(eeprom_device, 0x20U, read.data(), read.size(), &transaction_done, &results[1]),
+              "read queued");
+        check(i2c_bus.enqueue(I2CTransaction{.operation = I2COperation::TRANSMIT,
+                                             .dev_address = SENSOR_ADDRESS,
+                                             .data = pointer.data(),
+                                             .size = pointer.size(),
+                                             .callback = &transaction_done,
+                                             .context = &results[2]}),
+              "transmit queued");
+        check(i2c_bus.enqueue(I2CTransaction{.operation = I2COperation::RECEIVE,
+                                             .dev_address = SENSOR_ADDRESS,
+                                             .data = received.data(),
+                                             .size = received.size(),
+                                             .callback = &transaction_done,
+                                             .context = &results[3]}),
+              "receive queued");
+        check(i2c_bus.is_busy(), "busy while queued");
+
+        Sim::run_until_idle();
+
+        auto in_order = true;
+        for (std::size_t index = 0UL; index < results.size(); ++index) {
+            in_order = in_order && results[index].status == HAL_OK && results[index].sequence == index;
+        }
+
+        check(in_order, use_dma ? "DMA transactions complete in order" : "IT transactions complete in order");
+        check(std::ranges::equal(written, std::span{eeprom}.subspan(0x20UL, written.size())), "write lands");
+        check(read == written, "read sees the write queued ahead");
+        check(std::ranges::equal(received, std::span{sensor}.subspan(0x04UL, received.size())),
+              "receive continues at the transmitted pointer");
+        check(!i2c_bus.is_busy(), "idle when drained");
+    }
+
+    void test_full() noexcept
+    {
+        setup(false);
+
+        auto data = std::array<std::uint8_t, 2UL>{};
+        auto results = std::array<Result, I2CBus::QUEUE_SIZE>{};
+
+        for (auto& result : results) {
+            check(i2c_bus.enqueue_read(eeprom_device, 0x00U, data.data(), data.size(), &transaction_done, &result),
+                  "queued up to the queue size");
+        }
+
+        auto overflow = Result{};
+        check(i2c_bus.is_full(), "full at the queue size");
+        check(!i2c_bus.enqueue_read(eeprom_device, 0x00U, data.data(), data.size(), &transaction_done, &overflow),
+              "refused when full");
+
+        Sim::run_until_idle();
+
+        check(completed == results.size(), "every queued transaction completes");
+        check(overflow.status == HAL_BUSY, "refused transaction never called back");
+        check(!i2c_bus.is_full() && !i2c_bus.is_busy(), "empty when drained");
+    }
+
+    void test_nack() noexcept
+    {
+        setup(false);
+
+        auto absent_data = std::array<std::uint8_t, 2UL>{};
+        auto data = std::array<std::uint8_t, 2UL>{};
+        auto absent = Result{};
+        auto present = Result{};
+
+        check(i2c_bus.enqueue(I2CTransaction{.operation = I2COperation::MEMORY_READ,
+                                             .dev_address = ABSENT_ADDRESS,
+                                             .data = absent_data.data(),
+                                             .size = absent_data.size(),
+                                             .callback = &transaction_done,
+                                             .context = &absent,
+                                             .error_code = &absent.error_code}),
+              "read of an absent device queued");
+        check(i2c_bus.enqueue_read(eeprom_device, 0x00U, data.data(), data.size(), &transaction_done, &present),
+              "read behind it queued");
+
+        Sim::run_until_idle();
+
+        check(absent.status == HAL_ERROR && (absent.error_code & HAL_I2C_ERROR_AF) != 0UL, "absent device NACKs");
+        check(present.status == HAL_OK && present.sequence == 1UL, "queue continues after a NACK");
+    }
+
+    void test_wait() noexcept
+    {
+        setup(false);
+
+        auto data = std::array<std::uint8_t, 2UL>{};
+        auto result = Result{};
+
+        check(i2c_bus.enqueue(I2CTransaction{.operation = I2COperation::RECEIVE,
+                                             .dev_address = ABSENT_ADDRESS,
+                                             .data = data.data(),
+                                             .size = data.size(),
+                                             .callback = &transaction_done,
+                                             .context = &result}),
+              "receive from an absent device queued");
+        check(i2c_bus.wait() == HAL_ERROR && result.status == HAL_ERROR, "wait reports the failure");
+
+        check(i2c_bus.enqueue_read(eeprom_device, 0x00U, data.data(), data.size(), &transaction_done, &result),
+              "read queued");
+        check(i2c_bus.wait() == HAL_OK && result.status == HAL_OK, "wait reports the success");
+        check(!i2c_bus.is_busy(), "idle after wait");
+    }
+
+    void test_oversized() noexcept
+    {
+        setup(false);
+
+        auto data = std::array<std::uint8_t, 2UL>{};
+        auto result = Result{};
+
+        // the HAL would send only the low 16 bits of the size, here none at all
+        check(!i2c_bus.enqueue_read(
+                  eeprom_device, 0x00U, data.data(), I2CBus::MAX_TRANSFER_SIZE + 1UL, &transaction_done, &result),
+              "transaction over the 16 bit transfer size refused");
+        check(!i2c_bus.is_busy() && Sim::get_statistics(Sim::Bus::I2C).transfers == 0UL, "nothing started");
+    }
+
+}; // namespace
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_error_callback(hi2c);
+}
+
+int main()
+{
+    test_order(false);
+    test_order(true);
+    test_full();
+    test_nack();
+    test_wait();
+    test_oversized();
+
+    std::printf("I2C bus tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "i2c_eeprom.hpp"
+#include "sim.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <span>
+
+using namespace STM32_Utility;
+
+// I2CEEPROM against a simulated 24C32: 4 KiB, 32 byte pages wrapping like the real chip's, and a write
+// cycle during which it NACKs its address
+namespace {
+
+    constexpr std::uint16_t EEPROM_ADDRESS = 0x50U;
+    constexpr std::size_t PAGE_SIZE = 32UL;
+    constexpr Sim::Nanoseconds WRITE_TIME = 3000000ULL;
+
+    I2C_HandleTypeDef i2c_handle = {};
+
+    std::array<std::uint8_t, 4096UL> memory = {};
+
+    auto eeprom = I2CEEPROM{};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    void setup(Sim::Nanoseconds const write_time = WRITE_TIME) noexcept
+    {
+        Sim::reset();
+
+        i2c_handle.Instance = I2C1;
+        i2c_handle.Init.ClockSpeed = 400000UL;
+        HAL_I2C_Init(&i2c_handle);
+
+        memory.fill(0xFFU);
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS, memory.data(), memory.size(), 2UL, PAGE_SIZE, write_time);
+
+        eeprom = I2CEEPROM{.device = I2CDevice{.i2c_bus = &i2c_handle,
+                                               .dev_address = EEPROM_ADDRESS,
+                                               .mem_address_size = I2C_MEMADD_SIZE_16BIT},
+                           .page_size = PAGE_SIZE,
+                           .memory_size = memory.size()};
+    }
+
+    template <std::size_t SIZE>
+    std::array<std::uint8_t, SIZE> make_pattern() noexcept
+    {
+        auto pattern = std::array<std::uint8_t, SIZE>{};
+        for (std::size_t index = 0UL; index < SIZE; ++index) {
+            pattern[index] = static_cast<std::uint8_t>(index * 3UL + 1UL);
+        }
+
+        return pattern;
+    }
+
+    void test_page_split() noexcept
+    {
+        setup();
+
+        // 28 bytes up to the first boundary, two full pages, then 8 bytes: four write cycles
+        auto data = make_pattern<100UL>();
+        auto const start = Sim::now();
+
+        check(eeprom.write(100U, data.data(), data.size()).has_value(), "write across pages");
+
+        auto const elapsed = Sim::now() - start;
+
+        check(std::ranges::equal(data, std::span{memory}.subspan(100UL, data.size())), "no wrap within a page");
+        check(memory[99] == 0xFFU && memory[200] == 0xFFU, "neighbours untouched");
+        check(elapsed >= 4ULL * WRITE_TIME && elapsed < 5ULL * WRITE_TIME, "one write cycle per page");
+
+        // reads run across page boundaries in one transfer
+        auto read = std::array<std::uint8_t, 100UL>{};
+        Sim::reset_statistics();
+
+        check(eeprom.read(100U, read.data(), read.size()).has_value(), "read across pages");
+        check(read == data, "read back intact");
+        check(Sim::get_statistics(Sim::Bus::I2C).transfers == 1UL, "read in one transfer");
+    }
+
+    void test_aligned() noexcept
+    {
+        setup();
+
+        auto data = make_pattern<PAGE_SIZE>();
+        auto const start = Sim::now();
+
+        check(eeprom.write(3U * PAGE_SIZE, data.data(), data.size()).has_value(), "page aligned write");
+        check(Sim::now() - start < 2ULL * WRITE_TIME, "a single page in a single write cycle");
+        check(std::ranges::equal(data, std::span{memory}.subspan(3UL * PAGE_SIZE, PAGE_SIZE)), "page lands");
+    }
+
+    void test_bounds() noexcept
+    {
+        setup();
+
+        auto data = make_pattern<100UL>();
+        auto const past_end = static_cast<std::uint16_t>(memory.size() - 50UL);
+
+        check(eeprom.write(past_end, data.data(), data.size()).error_or(HAL_OK) == HAL_ERROR,
+              "write past the end rejected");
+        check(eeprom.read(past_end, data.data(), data.size()).error_or(HAL_OK) == HAL_ERROR,
+              "read past the end rejected");
+        check(std::ranges::all_of(memory, [](std::uint8_t const byte) { return byte == 0xFFU; }),
+              "rejected write leaves the chip untouched");
+        check(eeprom.write(past_end, data.data(), 50UL).has_value(), "write up to the end");
+    }
+
+    void test_small_chip() noexcept
+    {
+        setup();
+
+        // a 24C02 on the same bus, 256 bytes behind an 8 bit address, left at the default memory_size
+        auto small_memory = std::array<std::uint8_t, 256UL>{};
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS + 1U, small_memory.data(), small_memory.size(), 1UL, 8UL);
+
+        auto const small = I2CEEPROM{.device = I2CDevice{.i2c_bus = &i2c_handle, .dev_address = EEPROM_ADDRESS + 1U},
+                                     .page_size = 8UL};
+        auto data = make_pattern<16UL>();
+
+        check(small.write(0xF0U, data.data(), data.size()).has_value(), "write up to the last byte");
+        check(std::ranges::equal(data, std::span{small_memory}.subspan(0xF0UL, data.size())), "last page lands");
+
+        // the HAL sends only the low address byte, so these would land at 0x00
+        check(small.write(0xF8U, data.data(), data.size()).error_or(HAL_OK) == HAL_ERROR,
+              "write past the 8 bit address range rejected");
+        check(small.read(0x100U, data.data(), 1UL).error_or(HAL_OK) == HAL_ERROR,
+              "read past the 8 bit address range rejected");
+        check(small_memory[0] == 0U, "nothing wrapped to the start");
+    }
+
+    void test_oversized_segment() noexcept
+    {
+        setup();
+
+        auto pointer = std::array<std::uint8_t, 2UL>{};
+        auto data = std::array<std::uint8_t, 4UL>{};
+
+        // the HAL would read only the low 16 bits of the size
+        check(eeprom.device
+                      .transfer_segments({
+                          I2CSegment{.direction = I2CDirection::WRITE, .data = pointer.data(), .size = pointer.size()},
+                          I2CSegment{.direction = I2CDirection::READ,
+                                     .data = data.data(),
+                                     .size = I2CDevice::MAX_SEGMENT_SIZE + 1UL},
+                      })
+                      .error_or(HAL_OK) == HAL_ERROR,
+              "segment over the 16 bit transfer size rejected");
+        check(Sim::get_statistics(Sim::Bus::I2C).transfers == 0UL, "nothing sent");
+    }
+
+    void test_write_timeout() noexcept
+    {
+        // a write cycle far beyond the 5 ms the driver is told to wait
+        setup(20000000ULL);
+
+        auto data = make_pattern<4UL>();
+
+        check(eeprom.write(0U, data.data(), data.size()).error_or(HAL_OK) == HAL_TIMEOUT,
+              "stuck write cycle times out");
+    }
+
+}; // namespace
+
+int main()
+{
+    test_page_split();
+    test_aligned();
+    test_bounds();
+    test_small_chip();
+    test_oversized_segment();
+    test_write_timeout();
+
+    std::printf("I2C EEPROM tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "i2c_bus.hpp"
+#include "i2c_scanner.hpp"
+#include "sim.hpp"
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// I2CScanner against the simulated devices of sim/hal.cpp, with reads of another device queued behind
+// every probe so the bus starts the next transaction before the probe's callback runs
+namespace {
+
+    constexpr std::uint16_t EEPROM_ADDRESS = 0x50U;
+    constexpr std::uint16_t SENSOR_ADDRESS = 0x68U;
+
+    I2C_HandleTypeDef i2c_handle = {};
+
+    std::array<std::uint8_t, 256UL> eeprom = {};
+    std::array<std::uint8_t, 16UL> sensor = {};
+
+    auto i2c_bus = I2CBus{};
+    auto i2c_scanner = I2CScanner{};
+    auto eeprom_device = I2CDevice{.i2c_bus = &i2c_handle, .dev_address = EEPROM_ADDRESS};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    struct ScanResult {
+        HAL_StatusTypeDef status = HAL_OK;
+        bool done = false;
+    };
+
+    void scan_done(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        auto& scan = *static_cast<ScanResult*>(context);
+
+        scan.status = result;
+        scan.done = true;
+    }
+
+    // keeps one read of the EEPROM queued for as long as the scan runs
+    struct Background {
+        std::array<std::uint8_t, 4UL> data = {};
+        std::size_t reads = 0UL;
+        std::size_t errors = 0UL;
+        bool intact = true;
+    };
+
+    void background_done(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        auto& background = *static_cast<Background*>(context);
+
+        background.reads += 1UL;
+        background.errors += result != HAL_OK ? 1UL : 0UL;
+        background.intact =
+            background.intact && background.data[0] == eeprom[0x10] && background.data[3] == eeprom[0x13];
+
+        if (i2c_scanner.is_busy()) {
+            (void)i2c_bus.enqueue_read(
+                eeprom_device, 0x10U, background.data.data(), background.data.size(), &background_done, &background);
+        }
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        i2c_handle.Instance = I2C1;
+        i2c_handle.Init.ClockSpeed = 400000UL;
+        HAL_I2C_Init(&i2c_handle);
+
+        for (std::size_t index = 0UL; index < eeprom.size(); ++index) {
+            eeprom[index] = static_cast<std::uint8_t>(index * 7UL);
+        }
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS, eeprom.data(), eeprom.size());
+        Sim::attach_i2c_device(&i2c_handle, SENSOR_ADDRESS, sensor.data(), sensor.size());
+
+        i2c_bus = I2CBus{.i2c_bus = &i2c_handle};
+        i2c_scanner = I2CScanner{.bus = &i2c_bus};
+    }
+
+    I2CAddressMap make_map(std::initializer_list<std::uint16_t> const addresses) noexcept
+    {
+        auto map = I2CAddressMap{};
+        for (auto const address : addresses) {
+            map.set(address);
+        }
+
+        return map;
+    }
+
+    void test_scan_interleaved() noexcept
+    {
+        setup();
+
+        auto scan = ScanResult{};
+        auto background = Background{};
+        i2c_scanner.callback = &scan_done;
+        i2c_scanner.context = &scan;
+
+        // the read runs first, each probe then finishes with the next read queued behind it
+        check(i2c_bus.enqueue_read(
+                  eeprom_device, 0x10U, background.data.data(), background.data.size(), &background_done, &background),
+              "background read queued");
+        check(i2c_scanner.start(), "scan started");
+
+        Sim::run_until_idle();
+
+        auto const probed = static_cast<std::size_t>(I2C_LAST_ADDRESS - I2C_FIRST_ADDRESS + 1U);
+        auto const statistics = Sim::get_statistics(Sim::Bus::I2C);
+
+        check(scan.done && scan.status == HAL_OK, "scan completes");
+        check(i2c_scanner.get_present() == make_map({EEPROM_ADDRESS, SENSOR_ADDRESS}), "scan finds both devices");
+        check(i2c_scanner.get_changed() == make_map({EEPROM_ADDRESS, SENSOR_ADDRESS}), "first scan changes both");
+        check(background.reads > 100UL && background.errors == 0UL && background.intact, "reads interleave intact");
+
+        // a NACK is never retried, so every absent address is probed exactly once
+        check(statistics.errors == probed - 2UL, "NACKs recognized behind queued reads");
+        check(statistics.transfers == probed + background.reads, "one probe per address");
+    }
+
+    void test_rescan() noexcept
+    {
+        setup();
+
+        auto scan = ScanResult{};
+        i2c_scanner.callback = &scan_done;
+        i2c_scanner.context = &scan;
+
+        check(i2c_scanner.start(), "scan started");
+        Sim::run_until_idle();
+
+        // the sensor is unplugged from its connector
+        Sim::detach_i2c_devices();
+        Sim::attach_i2c_device(&i2c_handle, EEPROM_ADDRESS, eeprom.data(), eeprom.size());
+        Sim::reset_statistics();
+
+        scan = ScanResult{};
+        i2c_scanner.invalidate(0x60U, 0x6FU);
+        check(i2c_scanner.rescan(), "rescan started");
+        Sim::run_until_idle();
+
+        check(scan.done && scan.status == HAL_OK, "rescan completes");
+        check(Sim::get_statistics(Sim::Bus::I2C).transfers == 16UL, "rescan probes only invalidated addresses");
+        check(i2c_scanner.get_present() == make_map({EEPROM_ADDRESS}), "rescan drops the unplugged device");
+        check(i2c_scanner.get_changed() == make_map({SENSOR_ADDRESS}), "rescan reports the change");
+    }
+
+    void test_stuck_bus() noexcept
+    {
+        setup();
+
+        Sim::hold_i2c_bus(&i2c_handle);
+
+        check(!i2c_scanner.start(), "scan refused on a held bus");
+        check(!i2c_scanner.is_busy(), "scanner idle after refusal");
+    }
+
+}; // namespace
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_complete_callback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    i2c_bus.transfer_error_callback(hi2c);
+}
+
+int main()
+{
+    test_scan_interleaved();
+    test_rescan();
+    test_stuck_bus();
+
+    std::printf("I2C scanner tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "async_device.hpp"
+#include "ow_device.hpp"
+#include "sim.hpp"
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// 1-Wire driver against the simulated slaves of sim/hal.cpp on the half-duplex USART1
+namespace {
+
+    // DS18B20 at 12 bit resolution
+    constexpr Sim::Nanoseconds CONVERSION_TIME = 750000000ULL;
+
+    UART_HandleTypeDef uart_handle = {};
+
+    // the device of the awaitable transfers, completed from the UART callbacks below
+    auto async_device = OWDevice{.uart_bus = &uart_handle};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // DS18B20 family code, 48 bit serial number and the CRC8 over both
+    constexpr std::uint64_t make_rom(std::uint64_t const serial) noexcept
+    {
+        auto const rom = 0x28ULL | ((serial << 8U) & 0x00FFFFFFFFFFFF00ULL);
+
+        auto bytes = std::array<std::uint8_t, 7UL>{};
+        for (std::size_t byte = 0UL; byte < bytes.size(); ++byte) {
+            bytes[byte] = static_cast<std::uint8_t>(rom >> (8UL * byte));
+        }
+
+        return rom | (static_cast<std::uint64_t>(ow_crc8(bytes.data(), bytes.size())) << 56U);
+    }
+
+    constexpr OWScratchpad make_scratchpad(std::uint8_t const temperature) noexcept
+    {
+        auto scratchpad = OWScratchpad{temperature, 0x01U, 0x4BU, 0x46U, 0x7FU, 0xFFU, 0x0CU, 0x10U};
+        scratchpad[8] = ow_crc8(scratchpad.data(), 8UL);
+
+        return scratchpad;
+    }
+
+    constexpr auto FIRST_ROM = make_rom(0x0000A1B2C3D4ULL);
+    constexpr auto SECOND_ROM = make_rom(0x0000A1B2C3D5ULL);
+
+    constexpr auto FIRST_SCRATCHPAD = make_scratchpad(0x50U);
+    constexpr auto SECOND_SCRATCHPAD = make_scratchpad(0x91U);
+
+    static_assert(ow_rom_is_valid(FIRST_ROM) && ow_rom_is_valid(SECOND_ROM));
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        uart_handle.Instance = USART1;
+        uart_handle.Init.BaudRate = 115200UL;
+        HAL_HalfDuplex_Init(&uart_handle);
+    }
+
+    void test_presence() noexcept
+    {
+        setup();
+
+        auto const device = OWDevice{.uart_bus = &uart_handle};
+
+        check(!device.reset(), "no presence pulse on an empty bus");
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data());
+
+        check(device.reset(), "presence pulse");
+        check(uart_handle.Init.BaudRate == 115200UL, "slot baud rate restored after reset");
+    }
+
+    void test_scratchpad() noexcept
+    {
+        setup();
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data());
+        Sim::attach_ow_device(&uart_handle, SECOND_ROM, SECOND_SCRATCHPAD.data());
+
+        auto const device = OWDevice{.uart_bus = &uart_handle, .dev_address = SECOND_ROM};
+
+        check(device.read_scratchpad(FIRST_ROM) == FIRST_SCRATCHPAD, "MATCH ROM selects the first device");
+        check(device.read_scratchpad(SECOND_ROM) == SECOND_SCRATCHPAD, "MATCH ROM selects the second device");
+        check(!device.read_scratchpad(make_rom(0x0000A1B2C3D6ULL)).has_value(), "unknown ROM answers nothing");
+        check(!device.read_scratchpad(0ULL).has_value(), "SKIP ROM with two devices collides");
+
+        auto const raw = device.read_bytes<9UL>(0xBEU);
+        check(raw && *raw == SECOND_SCRATCHPAD, "read_bytes selects dev_address");
+    }
+
+    void test_search() noexcept
+    {
+        setup();
+
+        auto const device = OWDevice{.uart_bus = &uart_handle};
+        auto roms = std::array<std::uint64_t, 8UL>{};
+
+        check(device.search_rom(roms.data(), roms.size()) == 0UL, "search on an empty bus");
+
+        // serial numbers disagreeing in low, middle and high bits, so the search branches at several
+        // depths, and one device whose ROM fails its CRC somewhere between them
+        auto const expected = std::array<std::uint64_t, 5UL>{make_rom(0x000000000001ULL),
+                                                             make_rom(0x000000000002ULL),
+                                                             make_rom(0x000000000003ULL),
+                                                             make_rom(0x000001000001ULL),
+                                                             make_rom(0x800000000000ULL)};
+        auto const corrupt = make_rom(0x000000800000ULL) ^ (1ULL << 60U);
+
+        for (std::size_t index = 0UL; index < expected.size(); ++index) {
+            Sim::attach_ow_device(&uart_handle, expected[index], FIRST_SCRATCHPAD.data(), 0ULL, index % 2UL == 1UL);
+        }
+        Sim::attach_ow_device(&uart_handle, corrupt, FIRST_SCRATCHPAD.data(), 0ULL, true);
+
+        auto const found = device.search_rom(roms.data(), roms.size());
+
+        check(found == expected.size(), "search finds every valid ROM");
+        check(std::ranges::all_of(expected,
+                                  [&](std::uint64_t const rom) {
+                                      return std::count(roms.begin(), roms.begin() + found, rom) == 1L;
+                                  }),
+              "search reads every ROM intact");
+        check(std::find(roms.begin(), roms.end(), corrupt) == roms.end(), "search skips a ROM failing its CRC");
+
+        auto const limited = device.search_rom(roms.data(), 2UL);
+        check(limited == 2UL && std::count(expected.begin(), expected.end(), roms[0]) == 1L &&
+                  std::count(expected.begin(), expected.end(), roms[1]) == 1L && roms[0] != roms[1],
+              "search stops when the array is full");
+
+        auto const alarms = device.alarm_search(roms.data(), roms.size());
+        check(alarms == 2UL && std::count(roms.begin(), roms.begin() + 2, expected[1]) == 1L &&
+                  std::count(roms.begin(), roms.begin() + 2, expected[3]) == 1L,
+              "alarm search finds alarmed devices");
+
+        // every ROM found selects its device alone
+        auto selected = true;
+        for (auto const rom : expected) {
+            selected = selected && device.read_scratchpad(rom) == FIRST_SCRATCHPAD;
+        }
+        check(selected, "found ROMs select their device");
+    }
+
+    void test_transfer_errors() noexcept
+    {
+        setup();
+
+        auto const device = OWDevice{.uart_bus = &uart_handle, .dev_address = FIRST_ROM};
+
+        check(device.read_bytes<9UL>(0xBEU).error_or(HAL_OK) == HAL_ERROR, "missing presence pulse");
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data());
+
+        // a receiver still busy from elsewhere fails the first frame, which leaves the data alone
+        uart_handle.RxState = HAL_UART_STATE_BUSY_RX;
+
+        auto data = std::array<std::uint8_t, 12UL>{};
+        data.fill(0xA5U);
+
+        check(device.receive_bytes(data.data(), data.size()).error_or(HAL_OK) == HAL_BUSY, "receive error reported");
+        check(std::ranges::all_of(data, [](std::uint8_t const byte) { return byte == 0xA5U; }), "no stale data");
+        check(device.transmit_byte(0xCCU).error_or(HAL_OK) == HAL_BUSY, "transmit error reported");
+
+        uart_handle.RxState = HAL_UART_STATE_READY;
+
+        check(device.read_byte(0xBEU) == FIRST_SCRATCHPAD[0], "transfers resume");
+    }
+
+    void test_conversion() noexcept
+    {
+        setup();
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data(), CONVERSION_TIME);
+
+        auto const device = OWDevice{.uart_bus = &uart_handle};
+
+        check(device.start_conversion() && !device.is_conversion_done(), "conversion holds read slots low");
+
+        auto const start = Sim::now();
+        auto const converted = device.convert_all();
+        auto const elapsed = Sim::now() - start;
+
+        // reset pulse and command ahead of the conversion, one read slot per poll after it
+        check(converted, "convert_all");
+        check(elapsed >= CONVERSION_TIME && elapsed < CONVERSION_TIME + 3000000ULL, "convert_all polls until done");
+        check(device.read_scratchpad(0ULL) == FIRST_SCRATCHPAD, "SKIP ROM with a single device");
+
+        Sim::detach_ow_devices();
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data(), 2ULL * CONVERSION_TIME);
+
+        check(!device.convert_all(), "convert_all times out");
+    }
+
+    struct AsyncResults {
+        Expected<std::size_t> found = 0UL;
+        std::array<std::uint64_t, 4UL> roms = {};
+        Expected<std::size_t> alarms = 0UL;
+        std::optional<OWScratchpad> scratchpad = std::nullopt;
+        std::optional<OWScratchpad> skipped = std::nullopt;
+        Expected<> converted = std::unexpected{HAL_BUSY};
+        std::uint32_t ticks_during_search = 0UL;
+        bool done = false;
+    };
+
+    std::uint32_t ticks = 0UL;
+
+    Task<> ticker_task(AsyncResults const& results) noexcept
+    {
+        while (!results.done) {
+            ++ticks;
+            co_await async_delay(1UL);
+        }
+    }
+
+    Task<> search_task(AsyncResults& results) noexcept
+    {
+        auto const start = ticks;
+        results.found = co_await async_search_rom(async_device, results.roms.data(), results.roms.size());
+        results.ticks_during_search = ticks - start;
+
+        results.alarms = co_await async_alarm_search(async_device, results.roms.data() + 2, 2UL);
+        results.scratchpad = co_await async_read_scratchpad(async_device, SECOND_ROM);
+        results.converted = co_await async_convert_all(async_device);
+
+        Sim::detach_ow_devices();
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data());
+        results.skipped = co_await async_read_scratchpad(async_device, 0ULL);
+
+        results.done = true;
+    }
+
+    void test_async() noexcept
+    {
+        setup();
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data(), CONVERSION_TIME);
+        Sim::attach_ow_device(&uart_handle, SECOND_ROM, SECOND_SCRATCHPAD.data(), CONVERSION_TIME, true);
+
+        auto scheduler = Scheduler{};
+        auto results = AsyncResults{};
+
+        check(scheduler.spawn(search_task(results)) && scheduler.spawn(ticker_task(results)), "async tasks spawned");
+
+        auto const start = Sim::now();
+        scheduler.run();
+        auto const elapsed = Sim::now() - start;
+
+        auto const found = results.found.value_or(0UL);
+        check(found == 2UL && std::count(results.roms.begin(), results.roms.begin() + 2, FIRST_ROM) == 1L &&
+                  std::count(results.roms.begin(), results.roms.begin() + 2, SECOND_ROM) == 1L,
+              "async search finds every ROM");
+        check(results.alarms.value_or(0UL) == 1UL && results.roms[2] == SECOND_ROM, "async alarm search");
+        check(results.scratchpad == SECOND_SCRATCHPAD, "async MATCH ROM read");
+        check(results.converted.has_value() && elapsed >= CONVERSION_TIME, "async convert_all");
+        check(results.skipped == FIRST_SCRATCHPAD, "async SKIP ROM read");
+
+        // two passes of 64 bits, three slots each, take tens of milliseconds of bus time
+        check(results.ticks_during_search >= 20UL, "other tasks run during a search");
+    }
+
+    struct ExhaustedResults {
+        Expected<std::size_t> found = 0UL;
+        Expected<> converted = {};
+        std::optional<OWScratchpad> scratchpad = OWScratchpad{};
+        Expected<> nested = {};
+        std::array<void*, COROUTINE_FRAMES> frames = {};
+    };
+
+    Task<> nested_task() noexcept
+    {
+        co_await async_yield();
+    }
+
+    Task<> exhausted_task(ExhaustedResults& results) noexcept
+    {
+        // every frame of the pool taken, so no awaited task can start
+        for (auto& frame : results.frames) {
+            frame = coroutine_allocate(1UL);
+        }
+
+        results.found = co_await async_search_rom(async_device, nullptr, 0UL);
+        results.converted = co_await async_convert_all(async_device);
+        results.scratchpad = co_await async_read_scratchpad(async_device, 0ULL);
+        results.nested = co_await nested_task();
+
+        for (auto const frame : results.frames) {
+            if (frame) {
+                coroutine_deallocate(frame);
+            }
+        }
+    }
+
+    void test_async_exhausted() noexcept
+    {
+        setup();
+
+        Sim::attach_ow_device(&uart_handle, FIRST_ROM, FIRST_SCRATCHPAD.data());
+
+        auto scheduler = Scheduler{};
+        auto results = ExhaustedResults{};
+
+        check(scheduler.spawn(exhausted_task(results)), "exhausting task spawned");
+        scheduler.run();
+
+        check(results.found.error_or(HAL_OK) == HAL_ERROR, "failed search frame is no empty bus");
+        check(results.converted.error_or(HAL_OK) == HAL_ERROR, "failed conversion frame reported");
+        check(!results.scratchpad.has_value(), "failed scratchpad frame reported");
+        check(results.nested.error_or(HAL_OK) == HAL_ERROR, "failed Task<> frame reported");
+    }
+
+}; // namespace
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart)
+{
+    async_device.transfer_complete_callback(huart);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+    async_device.transfer_error_callback(huart);
+}
+
+int main()
+{
+    test_presence();
+    test_scratchpad();
+    test_conversion();
+    test_search();
+    test_transfer_errors();
+    test_async();
+    test_async_exhausted();
+
+    std::printf("1-Wire tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "ring_buffer.hpp"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace STM32_Utility;
+
+// Stress test of the ring buffers with real threads standing in for interrupt contexts, built with
+// ThreadSanitizer when the toolchain has it, see sim/CMakeLists.txt. Every value is tagged with its
+// producer and a per-producer sequence number, so the consumer sees any loss, duplicate or reordering.
+namespace {
+
+    constexpr std::uint32_t PRODUCERS = 4UL;
+    constexpr std::uint32_t VALUES = 200000UL;
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    constexpr std::uint32_t tag(std::uint32_t const producer, std::uint32_t const sequence) noexcept
+    {
+        return producer << 24U | sequence;
+    }
+
+    template <std::size_t SIZE>
+    void test_mpsc_producers(char const* const name) noexcept
+    {
+        static auto queue = MPSCRingBuffer<std::uint32_t, SIZE>{};
+
+        auto producers = std::vector<std::thread>{};
+        for (auto producer = std::uint32_t{0U}; producer < PRODUCERS; ++producer) {
+            producers.emplace_back([producer] {
+                for (auto sequence = std::uint32_t{0U}; sequence < VALUES; ++sequence) {
+                    while (!queue.push(tag(producer, sequence))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        auto expected = std::array<std::uint32_t, PRODUCERS>{};
+        auto ordered = true;
+        auto values = std::array<std::uint32_t, SIZE>{};
+
+        for (auto received = 0UL; received < PRODUCERS * VALUES;) {
+            auto const popped = queue.pop_bulk(values);
+            if (popped == 0UL) {
+                std::this_thread::yield();
+            }
+
+            for (auto index = 0UL; index < popped; ++index) {
+                auto const producer = values[index] >> 24U;
+                auto const sequence = values[index] & 0xFFFFFFUL;
+
+                // a missing, repeated or overtaken value breaks the run of one producer
+                if (producer >= PRODUCERS || sequence != expected[producer]) {
+                    ordered = false;
+                } else {
+                    expected[producer] += 1UL;
+                }
+            }
+            received += popped;
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        auto complete = true;
+        for (auto const count : expected) {
+            complete = complete && count == VALUES;
+        }
+
+        check(ordered, name);
+        check(complete, name);
+        check(queue.is_empty() && !queue.pop().has_value(), name);
+    }
+
+    // exact fill level around the wrap point, single threaded
+    void test_spsc_wrap() noexcept
+    {
+        auto queue = SPSCRingBuffer<std::uint32_t, 8UL>{};
+
+        for (auto value = std::uint32_t{0U}; value < 5U; ++value) {
+            queue.push(value);
+        }
+        for (auto value = std::uint32_t{0U}; value < 5U; ++value) {
+            check(queue.pop() == value, "SPSC pop before wrap");
+        }
+
+        // free space ends at the wrap point, the rest follows after the commit
+        auto space = queue.prepare();
+        check(space.size() == 3UL && space.data() == queue.buffer.data() + 5, "SPSC prepare up to wrap");
+        for (auto index = 0UL; index < space.size(); ++index) {
+            space[index] = static_cast<std::uint32_t>(100UL + index);
+        }
+        queue.commit(space.size());
+
+        space = queue.prepare();
+        check(space.size() == 5UL && space.data() == queue.buffer.data(), "SPSC prepare after wrap");
+        for (auto index = 0UL; index < space.size(); ++index) {
+            space[index] = static_cast<std::uint32_t>(103UL + index);
+        }
+        queue.commit(space.size());
+
+        check(queue.is_full() && queue.prepare().empty() && !queue.push(0U), "SPSC full");
+
+        auto stored = queue.peek();
+        check(stored.size() == 3UL && stored[0] == 100UL, "SPSC peek up to wrap");
+        queue.consume(2UL);
+        stored = queue.peek();
+        check(stored.size() == 1UL && stored[0] == 102UL, "SPSC peek after partial consume");
+        queue.consume(1UL);
+        stored = queue.peek();
+        check(stored.size() == 5UL && stored[0] == 103UL && stored[4] == 107UL, "SPSC peek after wrap");
+        queue.consume(stored.size());
+
+        check(queue.is_empty(), "SPSC empty");
+    }
+
+    // the producer fills prepared runs of varying length, the consumer releases partial peeks
+    void test_spsc_threads() noexcept
+    {
+        static auto queue = SPSCRingBuffer<std::uint32_t, 8UL>{};
+
+        auto producer = std::thread{[] {
+            for (auto next = std::uint32_t{0U}, run = std::uint32_t{1U}; next < VALUES; run = run % 5U + 1U) {
+                auto const space = queue.prepare();
+                auto const count = std::min<std::size_t>({space.size(), run, VALUES - next});
+                if (count == 0UL) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for (auto index = 0UL; index < count; ++index) {
+                    space[index] = next++;
+                }
+                queue.commit(count);
+            }
+        }};
+
+        auto expected = 0UL;
+        auto ordered = true;
+        auto bounded = true;
+
+        for (auto run = 1UL; expected < VALUES; run = run % 3UL + 1UL) {
+            auto const stored = queue.peek();
+            if (stored.empty()) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            bounded = bounded && stored.data() + stored.size() <= queue.buffer.data() + queue.buffer.size();
+
+            auto const count = std::min(stored.size(), run);
+            for (auto index = 0UL; index < count; ++index) {
+                ordered = ordered && stored[index] == expected++;
+            }
+            queue.consume(count);
+        }
+
+        producer.join();
+
+        check(ordered, "SPSC prepare/commit + peek/consume, threads");
+        check(bounded, "SPSC peek within buffer");
+        check(queue.is_empty(), "SPSC drained");
+    }
+
+}; // namespace
+
+int main()
+{
+    test_mpsc_producers<4UL>("MPSC 4 producers, capacity 4");
+    test_mpsc_producers<64UL>("MPSC 4 producers, capacity 64");
+    test_spsc_wrap();
+    test_spsc_threads();
+
+    std::printf("ring buffer tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "spi_bus.hpp"
+#include "sim.hpp"
+#include <algorithm>
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// SPIBus arbitration on the simulated SPI3: every byte on the wire is checked to go to exactly one chip
+// select, under the CR1 configuration of that device
+namespace {
+
+    SPI_HandleTypeDef spi_handle = {};
+
+    auto spi_bus = SPIBus{};
+    auto dac = SPIBusDevice{};
+    auto flash = SPIBusDevice{};
+    auto adc = SPIBusDevice{};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // bytes clocked out while no device, several devices or a device in the wrong mode was selected
+    std::size_t misrouted = 0UL;
+
+    std::uint8_t bus_responder(void* const, std::uint8_t const tx_byte) noexcept
+    {
+        auto selected = static_cast<SPIBusDevice const*>(nullptr);
+        auto selections = 0UL;
+
+        for (auto const device : {&dac, &flash, &adc}) {
+            if (gpio_read_pin(device->chip_select) == GPIO_PIN_RESET) {
+                selected = device;
+                selections += 1UL;
+            }
+        }
+
+        if (selections != 1UL ||
+            (spi_handle.Instance->CR1 & SPIConfig::CR1_MASK) != selected->config.get_cr1_bits()) {
+            misrouted += 1UL;
+        }
+
+        return tx_byte;
+    }
+
+    // devices in the order their transfers completed
+    std::array<SPIBusDevice const*, 32UL> completions = {};
+    std::size_t completed = 0UL;
+
+    void transfer_done(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        if (result == HAL_OK && completed < completions.size()) {
+            completions[completed++] = static_cast<SPIBusDevice const*>(context);
+        }
+    }
+
+    std::array<std::uint8_t, 4UL> tx_data = {1U, 2U, 3U, 4U};
+    std::array<std::uint8_t, 4UL> rx_data = {};
+
+    void enqueue(SPIBusDevice const& device) noexcept
+    {
+        check(spi_bus.enqueue_transfer(device,
+                                       tx_data.data(),
+                                       rx_data.data(),
+                                       rx_data.size(),
+                                       &transfer_done,
+                                       const_cast<SPIBusDevice*>(&device)),
+              "transfer queued");
+    }
+
+    bool completed_in(std::initializer_list<SPIBusDevice const*> const order) noexcept
+    {
+        return completed == order.size() && std::equal(order.begin(), order.end(), completions.begin());
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        spi_handle.Instance = SPI3;
+        spi_handle.Init.Mode = SPI_MODE_MASTER;
+        HAL_SPI_Init(&spi_handle);
+        Sim::attach_spi_responder(&spi_handle, bus_responder);
+
+        spi_bus = SPIBus{.spi_bus = &spi_handle};
+        dac = SPIBusDevice{.chip_select = GPIO::PC0,
+                           .config = SPIConfig::from_mode(&spi_handle, 1U, 20000000UL),
+                           .priority = 1U};
+        flash = SPIBusDevice{.chip_select = GPIO::PC1, .config = SPIConfig::from_mode(&spi_handle, 0U, 42000000UL)};
+        adc = SPIBusDevice{.chip_select = GPIO::PC2, .config = SPIConfig::from_mode(&spi_handle, 3U, 5000000UL)};
+
+        for (auto const device : {&dac, &flash, &adc}) {
+            gpio_write_pin(device->chip_select, GPIO_PIN_SET);
+        }
+
+        misrouted = 0UL;
+        completed = 0UL;
+    }
+
+    void test_priority() noexcept
+    {
+        setup();
+
+        // the first flash transfer starts right away, the DAC overtakes everything queued behind it
+        enqueue(flash);
+        enqueue(adc);
+        enqueue(flash);
+        enqueue(dac);
+        enqueue(dac);
+
+        Sim::run_until_idle();
+
+        check(completed_in({&flash, &dac, &dac, &adc, &flash}), "higher priority first, then arrival order");
+        check(misrouted == 0UL, "priority: every byte to the selected device in its mode");
+        check(rx_data == tx_data, "priority: data intact");
+    }
+
+    void test_batching() noexcept
+    {
+        setup();
+
+        // the ADC waits for at most BATCH_LIMIT flash transfers matching the current configuration
+        enqueue(flash);
+        enqueue(adc);
+        for (auto index = 0UL; index < SPIBus::BATCH_LIMIT + 2UL; ++index) {
+            enqueue(flash);
+        }
+
+        Sim::run_until_idle();
+
+        check(completed == SPIBus::BATCH_LIMIT + 4UL, "batching: every transfer completes");
+        check(completions[SPIBus::BATCH_LIMIT + 1UL] == &adc, "batching: overtaking bounded by BATCH_LIMIT");
+        check(misrouted == 0UL, "batching: every byte to the selected device in its mode");
+
+        // the flash runs in the reset configuration, so only the switches to the ADC and back count
+        check(spi_bus.get_stats().reconfigurations == 2UL, "batching: one reconfiguration per switch");
+        check(spi_bus.get_stats().transfers == SPIBus::BATCH_LIMIT + 4UL, "batching: transfers counted");
+    }
+
+    void test_acquire() noexcept
+    {
+        setup();
+
+        enqueue(flash);
+        check(!spi_bus.acquire(adc), "acquire refused while a transfer runs");
+
+        Sim::run_until_idle();
+
+        check(spi_bus.acquire(adc), "acquire on an idle bus");
+        check((spi_handle.Instance->CR1 & SPIConfig::CR1_MASK) == adc.config.get_cr1_bits(), "acquire configures");
+        check(spi_handle.Init.CLKPolarity == SPI_POLARITY_HIGH && spi_handle.Init.CLKPhase == SPI_PHASE_2EDGE,
+              "acquire keeps the handle's init in sync");
+
+        // queued while held, started only by release
+        enqueue(dac);
+        Sim::run_until_idle();
+        check(completed == 1UL, "held bus starts nothing");
+
+        gpio_write_pin(adc.chip_select, GPIO_PIN_RESET);
+        check(HAL_SPI_TransmitReceive(&spi_handle, tx_data.data(), rx_data.data(), 4U, HAL_MAX_DELAY) == HAL_OK,
+              "blocking transfer on the held bus");
+        gpio_write_pin(adc.chip_select, GPIO_PIN_SET);
+
+        check(!spi_bus.acquire(flash), "acquire refused while held");
+        spi_bus.release();
+        Sim::run_until_idle();
+
+        check(completed_in({&flash, &dac}), "release starts the queued transfer");
+        check(misrouted == 0UL, "acquire: every byte to the selected device in its mode");
+    }
+
+    void test_frames() noexcept
+    {
+        setup();
+
+        dac.config = SPIConfig::from_mode(&spi_handle, 1U, 20000000UL, SPI_DATASIZE_16BIT);
+
+        // sizes count bytes, a 16 bit device gets half as many frames and nothing past its buffers
+        auto tx = std::array<std::uint8_t, 8UL>{1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+        auto rx = std::array<std::uint8_t, 12UL>{};
+        rx.fill(0xEEU);
+
+        check(spi_bus.enqueue_transfer(dac, tx.data(), rx.data(), tx.size(), &transfer_done, &dac),
+              "16 bit transfer queued");
+        check(spi_bus.wait() == HAL_OK, "wait reports the success");
+
+        check(Sim::get_statistics(Sim::Bus::SPI).bytes == tx.size(), "bytes converted to frames");
+        check(std::equal(tx.begin(), tx.end(), rx.begin()) && rx[8] == 0xEEU && rx[11] == 0xEEU,
+              "16 bit transfer stays within its buffers");
+        check(misrouted == 0UL, "frames: every byte to the selected device in its mode");
+
+        check(!spi_bus.enqueue_transfer(dac, tx.data(), rx.data(), 7UL, &transfer_done, &dac),
+              "half a frame refused");
+        check(!spi_bus.enqueue_transfer(flash, tx.data(), rx.data(), SPIBus::MAX_TRANSFER_SIZE + 1UL, nullptr),
+              "more frames than the DMA counter refused");
+        check(!spi_bus.is_busy(), "refused transfers never start");
+    }
+
+}; // namespace
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_bus.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_bus.transfer_error_callback(hspi);
+}
+
+int main()
+{
+    test_priority();
+    test_batching();
+    test_acquire();
+    test_frames();
+
+    std::printf("SPI bus tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
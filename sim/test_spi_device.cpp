@@ -0,0 +1,99 @@
+#include "spi_device.hpp"
+#include "sim.hpp"
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// SPIDevice command words on the simulated SPI1, for a register map of 16 bit frames where the
+// auto-increment bit belongs only on bursts of more than one frame
+namespace {
+
+    struct RegisterProtocol : SPIProtocol {
+        static constexpr std::uint8_t RW_BIT = 15U;
+        static constexpr std::uint8_t INCREMENT_BIT = 14U;
+        static constexpr std::uint8_t ADDRESS_BITS = 16U;
+        static constexpr std::uint8_t FRAME_BITS = 16U;
+    };
+
+    using RegisterDevice = SPIDevice<RegisterProtocol>;
+
+    // halfword command frames sit in memory little endian
+    static_assert(RegisterDevice::get_command(0x12U, true, 2UL) == std::array<std::uint8_t, 2UL>{0x12U, 0x80U});
+    static_assert(RegisterDevice::get_command(0x12U, true, 4UL) == std::array<std::uint8_t, 2UL>{0x12U, 0xC0U});
+    static_assert(SPIDevice<>::get_command(0x12U, false, 1UL) == std::array<std::uint8_t, 1UL>{0x12U});
+
+    SPI_HandleTypeDef spi_handle = {};
+
+    auto device = RegisterDevice{};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // bytes clocked out since the last setup
+    std::array<std::uint8_t, 16UL> clocked = {};
+    std::size_t clocked_count = 0UL;
+
+    std::uint8_t recording_responder(void* const, std::uint8_t const tx_byte) noexcept
+    {
+        if (clocked_count < clocked.size()) {
+            clocked[clocked_count++] = tx_byte;
+        }
+
+        return 0xA5U;
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        spi_handle.Instance = SPI1;
+        spi_handle.Init.Mode = SPI_MODE_MASTER;
+        spi_handle.Init.DataSize = SPI_DATASIZE_16BIT;
+        HAL_SPI_Init(&spi_handle);
+        Sim::attach_spi_responder(&spi_handle, recording_responder);
+
+        device = RegisterDevice{.chip_select = GPIO::PA4, .spi_bus = &spi_handle};
+        device.initialize();
+
+        clocked_count = 0UL;
+    }
+
+    void test_single_frame() noexcept
+    {
+        setup();
+
+        // one 16 bit register, two bytes but a single frame
+        auto const data = device.read_bytes<2UL>(0x12U);
+
+        check(data.has_value() && *data == std::array<std::uint8_t, 2UL>{0xA5U, 0xA5U}, "register read");
+        check(clocked_count == 4UL && clocked[0] == 0x12U && clocked[1] == 0x80U, "no increment on one frame");
+    }
+
+    void test_burst() noexcept
+    {
+        setup();
+
+        auto data = std::array<std::uint8_t, 4UL>{1U, 2U, 3U, 4U};
+
+        check(device.write_bytes(0x20U, data).has_value(), "burst write");
+        check(clocked_count == 6UL && clocked[0] == 0x20U && clocked[1] == 0x40U, "increment on two frames");
+    }
+
+}; // namespace
+
+int main()
+{
+    test_single_frame();
+    test_burst();
+
+    std::printf("SPI device tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "spi_dma_device.hpp"
+#include "sim.hpp"
+#include <algorithm>
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// SPIDMADevice on the simulated SPI1 with a peer answering every byte with its complement, so each
+// received buffer tells which transmit buffer was clocked out while it was being filled
+namespace {
+
+    SPI_HandleTypeDef spi_handle = {};
+
+    auto spi_dma_device = SPIDMADevice{};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // bytes clocked while chip select was high
+    std::size_t deselected = 0UL;
+
+    std::uint8_t complement_responder(void* const, std::uint8_t const tx_byte) noexcept
+    {
+        if (gpio_read_pin(spi_dma_device.chip_select) != GPIO_PIN_RESET) {
+            deselected += 1UL;
+        }
+
+        return static_cast<std::uint8_t>(~tx_byte);
+    }
+
+    struct Buffer {
+        std::array<std::uint8_t, 64UL> tx = {};
+        std::array<std::uint8_t, 64UL> rx = {};
+        HAL_StatusTypeDef status = HAL_BUSY;
+        std::size_t sequence = 0UL;
+    };
+
+    std::array<Buffer, 4UL> buffers = {};
+    std::size_t completed = 0UL;
+
+    // refills the queue from the completion, the way a double buffered producer does
+    bool refill = false;
+    std::size_t refills = 0UL;
+
+    SPITransfer make_transfer(Buffer& buffer) noexcept;
+
+    void transfer_done(void* const context, HAL_StatusTypeDef const result) noexcept
+    {
+        auto& buffer = *static_cast<Buffer*>(context);
+
+        buffer.status = result;
+        buffer.sequence = completed++;
+
+        if (refill && refills < 2UL) {
+            auto& next = buffers[2UL + refills++];
+            check(spi_dma_device.submit(make_transfer(next)), "refilled from the callback");
+        }
+    }
+
+    SPITransfer make_transfer(Buffer& buffer) noexcept
+    {
+        return SPITransfer{.tx_data = buffer.tx.data(),
+                           .rx_data = buffer.rx.data(),
+                           .size = buffer.tx.size(),
+                           .callback = &transfer_done,
+                           .context = &buffer};
+    }
+
+    bool is_complement(Buffer const& buffer) noexcept
+    {
+        return std::ranges::equal(buffer.tx, buffer.rx, [](std::uint8_t const tx, std::uint8_t const rx) {
+            return rx == static_cast<std::uint8_t>(~tx);
+        });
+    }
+
+    void setup() noexcept
+    {
+        Sim::reset();
+
+        spi_handle.Instance = SPI1;
+        spi_handle.Init.Mode = SPI_MODE_MASTER;
+        spi_handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;
+        HAL_SPI_Init(&spi_handle);
+        Sim::attach_spi_responder(&spi_handle, complement_responder);
+
+        spi_dma_device.chip_select = GPIO::PA4;
+        spi_dma_device.spi_bus = &spi_handle;
+        spi_dma_device.initialize();
+
+        for (std::size_t index = 0UL; index < buffers.size(); ++index) {
+            buffers[index] = Buffer{};
+            for (std::size_t byte = 0UL; byte < buffers[index].tx.size(); ++byte) {
+                buffers[index].tx[byte] = static_cast<std::uint8_t>(index * 0x40UL + byte);
+            }
+        }
+
+        deselected = 0UL;
+        completed = 0UL;
+        refill = false;
+        refills = 0UL;
+    }
+
+    void test_back_to_back() noexcept
+    {
+        setup();
+
+        // the second transfer is queued while the first is in flight
+        check(spi_dma_device.submit(make_transfer(buffers[0])), "first transfer started");
+        check(spi_dma_device.submit(make_transfer(buffers[1])), "second transfer queued");
+        check(spi_dma_device.is_full(), "full with one transfer in flight and one queued");
+        check(!spi_dma_device.submit(make_transfer(buffers[2])), "third transfer refused while full");
+
+        check(spi_dma_device.wait() == HAL_OK, "wait reports the success");
+
+        check(completed == 2UL && buffers[2].status == HAL_BUSY, "only the accepted transfers complete");
+        check(buffers[0].status == HAL_OK && buffers[0].sequence == 0UL, "first completes first");
+        check(buffers[1].status == HAL_OK && buffers[1].sequence == 1UL, "second completes second");
+        check(is_complement(buffers[0]) && is_complement(buffers[1]), "each buffer received its own answer");
+        check(deselected == 0UL, "chip select low for every byte");
+        check(gpio_read_pin(spi_dma_device.chip_select) == GPIO_PIN_SET, "chip select released when idle");
+    }
+
+    void test_refill() noexcept
+    {
+        setup();
+        refill = true;
+
+        check(spi_dma_device.submit(make_transfer(buffers[0])), "first transfer started");
+        check(spi_dma_device.submit(make_transfer(buffers[1])), "second transfer queued");
+
+        Sim::run_until_idle();
+
+        auto in_order = completed == buffers.size();
+        for (std::size_t index = 0UL; index < buffers.size(); ++index) {
+            in_order = in_order && buffers[index].status == HAL_OK && buffers[index].sequence == index;
+        }
+
+        check(in_order, "refilled transfers complete in submission order");
+        check(std::ranges::all_of(buffers, is_complement), "refilled buffers received their own answers");
+        check(deselected == 0UL && !spi_dma_device.is_busy(), "refill: chip select low for every byte");
+    }
+
+    void test_oversized() noexcept
+    {
+        setup();
+
+        auto transfer = make_transfer(buffers[0]);
+        transfer.size = SPIDMADevice::MAX_TRANSFER_SIZE + 1UL;
+
+        check(!spi_dma_device.submit(transfer), "transfer over the DMA counter refused");
+        check(!spi_dma_device.is_busy() && Sim::get_statistics(Sim::Bus::SPI).transfers == 0UL, "nothing started");
+    }
+
+}; // namespace
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    spi_dma_device.transfer_error_callback(hspi);
+}
+
+int main()
+{
+    test_back_to_back();
+    test_refill();
+    test_oversized();
+
+    std::printf("SPI DMA device tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "spi_stream.hpp"
+#include "sim.hpp"
+#include <cstdio>
+
+using namespace STM32_Utility;
+
+// SPIStream on the simulated SPI2 with data-ready edges from the EXTI lines of PB0 and PB1, checking the
+// sample, overrun and drop counters against a known edge count
+namespace {
+
+    constexpr Sim::Nanoseconds PERIOD = 1000000ULL;
+
+    SPI_HandleTypeDef spi_handle = {};
+
+    // the ring buffers make the streams non-copyable, setup drains them instead of assigning new ones
+    auto stream = SPIStream<4UL, 16UL>{
+        .spi_bus = &spi_handle, .chip_select = GPIO::PB12, .data_ready = GPIO::PB0, .read_command = 0x80U | 0x1FU};
+    auto fifo_stream = SPIStream<4UL, 16UL, 4UL>{.spi_bus = &spi_handle,
+                                                 .chip_select = GPIO::PB12,
+                                                 .data_ready = GPIO::PB1,
+                                                 .read_command = 0x80U | 0x30U,
+                                                 .frame_interval = 1000UL};
+
+    std::size_t failures = 0UL;
+
+    void check(bool const condition, char const* const name) noexcept
+    {
+        if (!condition) {
+            std::printf("FAILED: %s\n", name);
+            ++failures;
+        }
+    }
+
+    // a sensor answering every byte after the command with the next value of a counter
+    std::uint8_t counter = 0U;
+
+    std::uint8_t sensor_responder(void* const, std::uint8_t const) noexcept
+    {
+        return counter++;
+    }
+
+    void setup(std::uint32_t const prescaler = SPI_BAUDRATEPRESCALER_4) noexcept
+    {
+        Sim::reset();
+
+        spi_handle.Instance = SPI2;
+        spi_handle.Init.Mode = SPI_MODE_MASTER;
+        spi_handle.Init.BaudRatePrescaler = prescaler;
+        HAL_SPI_Init(&spi_handle);
+        Sim::attach_spi_responder(&spi_handle, sensor_responder);
+
+        while (stream.samples.pop().has_value()) {
+        }
+        while (fifo_stream.samples.pop().has_value()) {
+        }
+        stream.reset_stats();
+        fifo_stream.reset_stats();
+
+        counter = 0U;
+    }
+
+    void test_samples() noexcept
+    {
+        setup();
+
+        check(stream.start() == HAL_OK, "stream started");
+        Sim::start_exti(GPIO_PIN_0, PERIOD);
+
+        auto sequential = true;
+        auto popped = 0UL;
+        auto expected = std::uint8_t{0U};
+
+        // sampled half way between edges, when the burst of the last one has completed
+        Sim::advance(PERIOD / 2ULL);
+        for (auto edge = 0UL; edge < 40UL; ++edge) {
+            Sim::advance(PERIOD);
+
+            while (auto const sample = stream.samples.pop()) {
+                // the byte clocked in during the command is not part of the frame
+                expected = static_cast<std::uint8_t>(expected + 1U);
+                for (auto const byte : sample->data) {
+                    sequential = sequential && byte == expected;
+                    expected = static_cast<std::uint8_t>(expected + 1U);
+                }
+                popped += 1UL;
+            }
+        }
+
+        Sim::stop_exti(GPIO_PIN_0);
+        stream.stop();
+
+        auto const stats = stream.get_stats();
+
+        check(popped == 40UL && stats.samples == 40UL, "one sample per edge");
+        check(sequential, "frames in order, command byte skipped");
+        check(stats.overruns == 0UL && stats.dropped == 0UL && stats.errors == 0UL, "nothing lost when drained");
+        check(stats.interval.count == 39UL, "interval measured between edges");
+    }
+
+    void test_dropped() noexcept
+    {
+        setup();
+
+        // nobody pops, so the ring buffer fills and every later sample is dropped
+        stream.start();
+        Sim::start_exti(GPIO_PIN_0, PERIOD);
+        Sim::advance(40ULL * PERIOD + PERIOD / 2ULL);
+        Sim::stop_exti(GPIO_PIN_0);
+        stream.stop();
+
+        auto const stats = stream.get_stats();
+
+        check(stats.samples == 16UL, "samples up to the ring buffer size");
+        check(stats.dropped == 40UL - 16UL, "the rest counted as dropped");
+        check(stats.overruns == 0UL, "a full buffer is no overrun");
+    }
+
+    void test_overrun() noexcept
+    {
+        // 5 bytes at 42 MHz / 256 take 244 us, longer than the 100 us between edges
+        setup(SPI_BAUDRATEPRESCALER_256);
+
+        stream.start();
+        Sim::start_exti(GPIO_PIN_0, PERIOD / 10ULL);
+        Sim::advance(PERIOD + PERIOD / 20ULL);
+        Sim::stop_exti(GPIO_PIN_0);
+        Sim::run_until_idle();
+        stream.stop();
+
+        auto const stats = stream.get_stats();
+
+        // edges at 100, 400, 700 and 1000 us start a burst, the two after each of the first three overrun
+        check(stats.samples == 4UL, "a burst every third edge");
+        check(stats.overruns == 6UL, "edges during a burst counted as overruns");
+        check(stats.samples + stats.overruns == 10UL, "every edge accounted for");
+        check(stats.dropped == 0UL, "an overrun is no drop");
+    }
+
+    void test_watermark() noexcept
+    {
+        setup();
+
+        fifo_stream.start();
+        Sim::start_exti(GPIO_PIN_1, 4ULL * PERIOD);
+        Sim::advance(4ULL * PERIOD + PERIOD / 2ULL);
+        Sim::stop_exti(GPIO_PIN_1);
+        fifo_stream.stop();
+
+        auto batch = std::array<SPIStreamSample<4UL>, 4UL>{};
+        auto const popped = fifo_stream.samples.pop_bulk(batch);
+
+        auto spaced = popped == batch.size();
+        for (std::size_t frame = 1UL; spaced && frame < batch.size(); ++frame) {
+            spaced = batch[frame].timestamp - batch[frame - 1UL].timestamp == fifo_stream.frame_interval;
+        }
+
+        check(fifo_stream.get_stats().samples == 4UL, "one burst drains the watermark");
+        check(spaced, "frames dated back by the frame interval");
+        check(batch[3].data[0] == 13U && batch[0].data[0] == 1U, "frames split from one burst");
+
+        // a watermark of 4 frames into a buffer with room for 2
+        setup();
+        for (auto index = 0UL; index < 14UL; ++index) {
+            fifo_stream.samples.push(SPIStreamSample<4UL>{});
+        }
+
+        fifo_stream.start();
+        Sim::start_exti(GPIO_PIN_1, 4ULL * PERIOD);
+        Sim::advance(4ULL * PERIOD + PERIOD / 2ULL);
+        Sim::stop_exti(GPIO_PIN_1);
+        fifo_stream.stop();
+
+        check(fifo_stream.get_stats().samples == 2UL && fifo_stream.get_stats().dropped == 2UL,
+              "partial burst counted as dropped");
+    }
+
+}; // namespace
+
+void HAL_GPIO_EXTI_Callback(std::uint16_t GPIO_Pin)
+{
+    stream.data_ready_callback(GPIO_Pin);
+    fifo_stream.data_ready_callback(GPIO_Pin);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    stream.transfer_complete_callback(hspi);
+    fifo_stream.transfer_complete_callback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    stream.transfer_error_callback(hspi);
+    fifo_stream.transfer_error_callback(hspi);
+}
+
+int main()
+{
+    test_samples();
+    test_dropped();
+    test_overrun();
+    test_watermark();
+
+    std::printf("SPI stream tests: %zu failed\n", failures);
+
+    return failures == 0UL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "spi_bus.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace STM32_Utility {
+
+    SPIConfig SPIConfig::from_mode(SPIHandle const spi_bus,
+                                   std::uint8_t const mode,
+                                   std::uint32_t const frequency,
+                                   std::uint32_t const data_size) noexcept
+    {
+        assert(mode < 4U);
+
+        return SPIConfig{.polarity = (mode & 0x2U) ? SPI_POLARITY_HIGH : SPI_POLARITY_LOW,
+                         .phase = (mode & 0x1U) ? SPI_PHASE_2EDGE : SPI_PHASE_1EDGE,
+                         .prescaler = get_spi_prescaler(spi_bus, frequency),
+                         .data_size = data_size};
+    }
+
+    std::uint32_t SPIConfig::get_cr1_bits(this SPIConfig const& self) noexcept
+    {
+        return (self.polarity | self.phase | self.prescaler | self.data_size | self.first_bit) & CR1_MASK;
+    }
+
+    std::size_t SPIConfig::get_frame_size(this SPIConfig const& self) noexcept
+    {
+        return self.data_size == SPI_DATASIZE_16BIT ? 2UL : 1UL;
+    }
+
+    bool SPIBus::enqueue(this SPIBus& self, SPIBusTransaction const& transaction) noexcept
+    {
+        assert(transaction.device);
+        assert(transaction.transfer.tx_data || transaction.transfer.rx_data);
+
+        auto const frame_size = transaction.device->config.get_frame_size();
+        auto const size = transaction.transfer.size;
+
+        if (size == 0UL || size % frame_size != 0UL || size / frame_size > MAX_TRANSFER_SIZE) {
+            return false;
+        }
+
+        {
+            auto const critical_section = CriticalSection{};
+
+            if (self.count == self.queue.size()) {
+                return false;
+            }
+
+            self.queue[self.count] = transaction;
+            self.count = self.count + 1UL;
+        }
+
+        self.start_next();
+
+        return true;
+    }
+
+    bool SPIBus::enqueue_transfer(this SPIBus& self,
+                                  SPIBusDevice const& device,
+                                  std::uint8_t* const tx_data,
+                                  std::uint8_t* const rx_data,
+                                  std::size_t const size,
+                                  TransferCallback const callback,
+                                  void* const context) noexcept
+    {
+        return self.enqueue(SPIBusTransaction{.device = &device,
+                                              .transfer = SPITransfer{.tx_data = tx_data,
+                                                                      .rx_data = rx_data,
+                                                                      .size = size,
+                                                                      .callback = callback,
+                                                                      .context = context}});
+    }
+
+    bool SPIBus::acquire(this SPIBus& self, SPIBusDevice const& device) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        if (self.running || self.held) {
+            return false;
+        }
+
+        for (std::size_t index = 0UL; index < self.count; ++index) {
+            if (self.queue[index].device->priority > device.priority) {
+                return false;
+            }
+        }
+
+        self.held = true;
+        self.configure(device.config);
+
+        return true;
+    }
+
+    void SPIBus::release(this SPIBus& self) noexcept
+    {
+        {
+            auto const critical_section = CriticalSection{};
+
+            assert(self.held);
+
+            self.held = false;
+        }
+
+        self.start_next();
+    }
+
+    bool SPIBus::is_busy(this SPIBus const& self) noexcept
+    {
+        return self.running || self.count != 0UL;
+    }
+
+    bool SPIBus::is_full(this SPIBus const& self) noexcept
+    {
+        return self.count == self.queue.size();
+    }
+
+    HAL_StatusTypeDef SPIBus::wait(this SPIBus const& self) noexcept
+    {
+        while (self.is_busy()) {
+            // a completion pending since the check still ends __WFI with PRIMASK set
+            auto const critical_section = CriticalSection{};
+            if (self.is_busy()) {
+                __WFI();
+            }
+        }
+
+        return self.status;
+    }
+
+    SPIBusStats SPIBus::get_stats(this SPIBus const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        return self.stats;
+    }
+
+    void SPIBus::reset_stats(this SPIBus& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.stats = {};
+    }
+
+    void SPIBus::transfer_complete_callback(this SPIBus& self, SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.running) {
+            self.finish(HAL_OK);
+        }
+    }
+
+    void SPIBus::transfer_error_callback(this SPIBus& self, SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.running) {
+            HAL_SPI_Abort(self.spi_bus);
+            self.finish(HAL_ERROR);
+        }
+    }
+
+    void SPIBus::configure(this SPIBus& self, SPIConfig const& config) noexcept
+    {
+        assert(self.spi_bus);
+
+        auto const cr1 = self.spi_bus->Instance->CR1;
+        auto const bits = config.get_cr1_bits();
+
+        if ((cr1 & SPIConfig::CR1_MASK) == bits) {
+            return;
+        }
+
+        // clock and frame format may only change while the peripheral is disabled, the HAL enables it
+        // again at the start of the next transfer
+        self.spi_bus->Instance->CR1 = cr1 & ~SPI_CR1_SPE;
+        self.spi_bus->Instance->CR1 = (cr1 & ~(SPIConfig::CR1_MASK | SPI_CR1_SPE)) | bits;
+
+        self.spi_bus->Init.CLKPolarity = config.polarity;
+        self.spi_bus->Init.CLKPhase = config.phase;
+        self.spi_bus->Init.BaudRatePrescaler = config.prescaler;
+        self.spi_bus->Init.DataSize = config.data_size;
+        self.spi_bus->Init.FirstBit = config.first_bit;
+
+        self.stats.reconfigurations += 1UL;
+    }
+
+    std::size_t SPIBus::select(this SPIBus& self) noexcept
+    {
+        auto const current = self.spi_bus->Instance->CR1 & SPIConfig::CR1_MASK;
+        auto const matches = [&](std::size_t const index) {
+            return self.queue[index].device->config.get_cr1_bits() == current;
+        };
+
+        // oldest of the highest priority, and the one to run instead, the oldest of those matching
+        auto oldest = std::size_t{0UL};
+        auto selected = std::size_t{0UL};
+
+        for (std::size_t index = 1UL; index < self.count; ++index) {
+            auto const priority = self.queue[index].device->priority;
+
+            if (priority > self.queue[oldest].device->priority) {
+                oldest = index;
+                selected = index;
+            } else if (priority == self.queue[oldest].device->priority && self.overtaken < BATCH_LIMIT &&
+                       !matches(selected) && matches(index)) {
+                selected = index;
+            }
+        }
+
+        self.overtaken = selected != oldest ? self.overtaken + 1UL : 0UL;
+
+        return selected;
+    }
+
+    HAL_StatusTypeDef SPIBus::start(this SPIBus& self) noexcept
+    {
+        auto const& device = *self.active.device;
+        auto const& transfer = self.active.transfer;
+        auto const size = static_cast<std::uint16_t>(transfer.size / device.config.get_frame_size());
+        auto result = HAL_ERROR;
+
+        self.configure(device.config);
+
+        gpio_write_pin(device.chip_select, GPIO_PIN_RESET);
+
+        if (transfer.tx_data && transfer.rx_data) {
+            result = HAL_SPI_TransmitReceive_DMA(self.spi_bus, transfer.tx_data, transfer.rx_data, size);
+        } else if (transfer.tx_data) {
+            result = HAL_SPI_Transmit_DMA(self.spi_bus, transfer.tx_data, size);
+        } else if (transfer.rx_data) {
+            result = HAL_SPI_Receive_DMA(self.spi_bus, transfer.rx_data, size);
+        }
+
+        if (result != HAL_OK) {
+            gpio_write_pin(device.chip_select, GPIO_PIN_SET);
+        }
+
+        return result;
+    }
+
+    void SPIBus::start_next(this SPIBus& self) noexcept
+    {
+        // a transfer failing to start is reported with interrupts enabled, its callback may enqueue again
+        while (true) {
+            auto failed = SPITransfer{};
+            auto result = HAL_OK;
+            {
+                auto const critical_section = CriticalSection{};
+
+                if (self.count == 0UL || self.running || self.held) {
+                    return;
+                }
+
+                self.active = self.take(self.select());
+
+                if (result = self.start(); result == HAL_OK) {
+                    self.running = true;
+                    return;
+                }
+                failed = self.active.transfer;
+                self.status = result;
+            }
+
+            if (failed.callback) {
+                failed.callback(failed.context, result);
+            }
+        }
+    }
+
+    void SPIBus::finish(this SPIBus& self, HAL_StatusTypeDef const result) noexcept
+    {
+        gpio_write_pin(self.active.device->chip_select, GPIO_PIN_SET);
+
+        auto finished = SPITransfer{};
+        {
+            auto const critical_section = CriticalSection{};
+
+            finished = self.active.transfer;
+            self.stats.transfers += 1UL;
+            self.running = false;
+            self.status = result;
+        }
+
+        self.start_next();
+
+        if (finished.callback) {
+            finished.callback(finished.context, result);
+        }
+    }
+
+    SPIBusTransaction SPIBus::take(this SPIBus& self, std::size_t const index) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        auto const transaction = self.queue[index];
+
+        std::copy(self.queue.begin() + static_cast<std::ptrdiff_t>(index) + 1L,
+                  self.queue.begin() + self.count,
+                  self.queue.begin() + static_cast<std::ptrdiff_t>(index));
+        self.count = self.count - 1U;
+
+        return transaction;
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
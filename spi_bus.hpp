@@ -0,0 +1,131 @@
+#ifndef SPI_BUS_HPP
+#define SPI_BUS_HPP
+
+#include "common.hpp"
+#include "gpio.hpp"
+#include "spi_dma_device.hpp"
+
+namespace STM32_Utility {
+
+    // The CR1 fields one device on a shared bus needs, as the HAL init values of each field
+    struct SPIConfig {
+    public:
+        // SPI mode 0-3 as CPOL << 1 | CPHA, the prescaler chosen for the fastest SCK not above frequency
+        static SPIConfig from_mode(SPIHandle const spi_bus,
+                                   std::uint8_t const mode,
+                                   std::uint32_t const frequency,
+                                   std::uint32_t const data_size = SPI_DATASIZE_8BIT) noexcept;
+
+        std::uint32_t get_cr1_bits(this SPIConfig const& self) noexcept;
+
+        // bytes per frame, 2 for SPI_DATASIZE_16BIT
+        std::size_t get_frame_size(this SPIConfig const& self) noexcept;
+
+        bool operator==(SPIConfig const& other) const noexcept = default;
+
+        std::uint32_t polarity = SPI_POLARITY_LOW;
+        std::uint32_t phase = SPI_PHASE_1EDGE;
+        std::uint32_t prescaler = SPI_BAUDRATEPRESCALER_2;
+        std::uint32_t data_size = SPI_DATASIZE_8BIT;
+        std::uint32_t first_bit = SPI_FIRSTBIT_MSB;
+
+        static constexpr std::uint32_t CR1_MASK =
+            SPI_CR1_CPHA | SPI_CR1_CPOL | SPI_CR1_BR | SPI_CR1_LSBFIRST | SPI_CR1_DFF;
+    };
+
+    struct SPIBusDevice {
+        GPIO chip_select = GPIO::NC;
+        SPIConfig config = {};
+
+        // higher goes first, transactions of equal priority keep their order unless batched
+        std::uint8_t priority = 0U;
+    };
+
+    struct SPIBusTransaction {
+        SPIBusDevice const* device = nullptr;
+        // size in bytes, whole frames of the device's data_size, converted to the HAL's frame count on start
+        SPITransfer transfer = {};
+    };
+
+    struct SPIBusStats {
+        std::uint32_t transfers = 0UL;
+        std::uint32_t reconfigurations = 0UL;
+    };
+
+    // Several devices with different modes and clocks on one SPI peripheral. A device switch rewrites
+    // only the CR1 fields that differ instead of running HAL_SPI_Init, and the handle's init is kept in
+    // sync so timeouts and the HAL's data size checks stay right. Queued DMA transactions run highest
+    // priority first, and among equal priorities ones matching the current configuration may overtake
+    // older ones, at most BATCH_LIMIT times in a row so no device waits forever.
+    struct SPIBus {
+    public:
+        // false when the queue is full, or the size is no whole number of frames or more than the DMA counter
+        // allows
+        bool enqueue(this SPIBus& self, SPIBusTransaction const& transaction) noexcept;
+
+        bool enqueue_transfer(this SPIBus& self,
+                              SPIBusDevice const& device,
+                              std::uint8_t* const tx_data,
+                              std::uint8_t* const rx_data,
+                              std::size_t const size,
+                              TransferCallback const callback,
+                              void* const context = nullptr) noexcept;
+
+        // Exclusive bus for blocking transfers, e.g. through an SPIDevice, configured for device. Fails
+        // while a transaction runs, the bus is held, or a queued transaction outranks device.
+        bool acquire(this SPIBus& self, SPIBusDevice const& device) noexcept;
+        void release(this SPIBus& self) noexcept;
+
+        bool is_busy(this SPIBus const& self) noexcept;
+        bool is_full(this SPIBus const& self) noexcept;
+
+        // sleeps until the queue drains, the status of the last transaction, earlier ones report through
+        // their callbacks
+        HAL_StatusTypeDef wait(this SPIBus const& self) noexcept;
+
+        SPIBusStats get_stats(this SPIBus const& self) noexcept;
+        void reset_stats(this SPIBus& self) noexcept;
+
+        // call from HAL_SPI_TxCpltCallback, HAL_SPI_RxCpltCallback and HAL_SPI_TxRxCpltCallback
+        void transfer_complete_callback(this SPIBus& self, SPIHandle const spi_bus) noexcept;
+
+        // call from HAL_SPI_ErrorCallback
+        void transfer_error_callback(this SPIBus& self, SPIHandle const spi_bus) noexcept;
+
+        SPIHandle spi_bus = nullptr;
+
+        static constexpr std::size_t QUEUE_SIZE = 16UL;
+        static constexpr std::uint32_t BATCH_LIMIT = 4UL;
+
+        // frames, 16 bit NDTR of the DMA stream
+        static constexpr std::size_t MAX_TRANSFER_SIZE = 0xFFFFUL;
+
+        // in arrival order
+        std::array<SPIBusTransaction, QUEUE_SIZE> queue = {};
+        std::uint32_t volatile count = 0UL;
+
+        SPIBusTransaction active = {};
+        bool volatile running = false;
+        bool volatile held = false;
+        HAL_StatusTypeDef volatile status = HAL_OK;
+
+        // consecutive transactions that overtook an older one of equal priority
+        std::uint32_t overtaken = 0UL;
+
+        SPIBusStats stats = {};
+
+    private:
+        void configure(this SPIBus& self, SPIConfig const& config) noexcept;
+
+        std::size_t select(this SPIBus& self) noexcept;
+
+        HAL_StatusTypeDef start(this SPIBus& self) noexcept;
+        void start_next(this SPIBus& self) noexcept;
+        void finish(this SPIBus& self, HAL_StatusTypeDef const result) noexcept;
+
+        SPIBusTransaction take(this SPIBus& self, std::size_t const index) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // SPI_BUS_HPP
\ No newline at end of file
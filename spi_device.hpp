@@ -1,110 +1,401 @@
 #ifndef SPI_DEVICE_HPP
 #define SPI_DEVICE_HPP
 
+#include "clock.hpp"
 #include "common.hpp"
 #include "gpio.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <span>
 
 namespace STM32_Utility {
 
+    // Command word of a register based SPI device, sent MSB first before the data. Devices with another
+    // encoding derive from it and hide the constants that differ:
+    // struct LIS3DHProtocol : SPIProtocol { static constexpr std::uint8_t INCREMENT_BIT = 6U; };
+    struct SPIProtocol {
+        // bit of the command word flagging the direction, set on reads when READ_HIGH, on writes otherwise
+        static constexpr std::uint8_t RW_BIT = 7U;
+        static constexpr bool READ_HIGH = true;
+
+        // bit of the command word set on bursts of more than one frame, none when not below ADDRESS_BITS
+        static constexpr std::uint8_t INCREMENT_BIT = 0xFFU;
+
+        // width of the command word, 8 or 16
+        static constexpr std::uint8_t ADDRESS_BITS = 8U;
+
+        // SCK cycles between the command of a read and its first data bit
+        static constexpr std::uint8_t DUMMY_CYCLES = 0U;
+
+        // 8 or 16, the DataSize of the SPI init, 16 bit frames are halfwords in memory
+        static constexpr std::uint8_t FRAME_BITS = 8U;
+    };
+
+    template <typename PROTOCOL = SPIProtocol>
     struct SPIDevice {
     public:
+        using Protocol = PROTOCOL;
+
+        static_assert(Protocol::ADDRESS_BITS == 8U || Protocol::ADDRESS_BITS == 16U);
+        static_assert(Protocol::FRAME_BITS == 8U || Protocol::FRAME_BITS == 16U);
+        static_assert(Protocol::RW_BIT < Protocol::ADDRESS_BITS);
+        static_assert(Protocol::INCREMENT_BIT != Protocol::RW_BIT);
+        static_assert(Protocol::ADDRESS_BITS % Protocol::FRAME_BITS == 0U, "command must fill whole frames");
+        static_assert(Protocol::DUMMY_CYCLES % Protocol::FRAME_BITS == 0U, "dummy cycles must fill whole frames");
+
+        static constexpr std::size_t FRAME_SIZE = Protocol::FRAME_BITS / 8UL;
+        static constexpr std::size_t COMMAND_SIZE = Protocol::ADDRESS_BITS / 8UL;
+        static constexpr std::size_t READ_PREFIX_SIZE = COMMAND_SIZE + Protocol::DUMMY_CYCLES / 8UL;
+
         template <std::size_t SIZE>
-        void transmit_bytes(this SPIDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> transmit_bytes(this SPIDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept;
 
-        void transmit_bytes(this SPIDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<>
+        transmit_bytes(this SPIDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        void transmit_byte(this SPIDevice const& self, std::uint8_t const data) noexcept;
+        Expected<> transmit_byte(this SPIDevice const& self, std::uint8_t const data) noexcept;
 
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> receive_bytes(this SPIDevice const& self) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> receive_bytes(this SPIDevice const& self) noexcept;
 
-        void receive_bytes(this SPIDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
+        Expected<> receive_bytes(this SPIDevice const& self, std::uint8_t* const data, std::size_t const size) noexcept;
 
-        std::uint8_t receive_byte(this SPIDevice const& self) noexcept;
+        Expected<std::uint8_t> receive_byte(this SPIDevice const& self) noexcept;
 
+        // one full duplex transfer of the command and SIZE bytes
         template <std::size_t SIZE>
-        std::array<std::uint8_t, SIZE> read_bytes(this SPIDevice const& self, std::uint8_t const address) noexcept;
+        Expected<std::array<std::uint8_t, SIZE>> read_bytes(this SPIDevice const& self,
+                                                             std::uint16_t const address) noexcept;
 
-        void read_bytes(this SPIDevice const& self,
-                        std::uint8_t const address,
-                        std::uint8_t* const data,
-                        std::size_t const size) noexcept;
+        Expected<> read_bytes(this SPIDevice const& self,
+                              std::uint16_t const address,
+                              std::uint8_t* const data,
+                              std::size_t const size) noexcept;
 
-        std::uint8_t read_byte(this SPIDevice const& self, std::uint8_t const address) noexcept;
+        Expected<std::uint8_t> read_byte(this SPIDevice const& self, std::uint16_t const address) noexcept;
 
         template <std::size_t SIZE>
-        void write_bytes(this SPIDevice const& self,
-                         std::uint8_t const address,
-                         std::array<std::uint8_t, SIZE> const& data) noexcept;
+        Expected<> write_bytes(this SPIDevice const& self,
+                               std::uint16_t const address,
+                               std::array<std::uint8_t, SIZE> const& data) noexcept;
 
-        void write_bytes(this SPIDevice const& self,
-                         std::uint8_t const address,
-                         std::uint8_t* const data,
-                         std::size_t const size) noexcept;
+        Expected<> write_bytes(this SPIDevice const& self,
+                               std::uint16_t const address,
+                               std::uint8_t* const data,
+                               std::size_t const size) noexcept;
 
-        void write_byte(this SPIDevice const& self, std::uint8_t const address, std::uint8_t const data) noexcept;
+        Expected<>
+        write_byte(this SPIDevice const& self, std::uint16_t const address, std::uint8_t const data) noexcept;
+
+        Expected<> transmit_segments(this SPIDevice const& self,
+                                     std::initializer_list<std::span<std::uint8_t const>> const segments) noexcept;
+
+        TransferStatsSnapshot get_stats(this SPIDevice const& self) noexcept;
 
         void initialize(this SPIDevice const& self) noexcept;
         void deinitialize(this SPIDevice const& self) noexcept;
 
+        // command bytes in memory order, constant folded for a constant address and size
+        static constexpr std::array<std::uint8_t, COMMAND_SIZE>
+        get_command(std::uint16_t const address, bool const read, std::size_t const size) noexcept;
+
         GPIO chip_select = GPIO::NC;
 
         SPIHandle spi_bus = nullptr;
 
+        // HAL timeout in ticks, 0 - sized for each transfer from its length and the SCK frequency
+        std::uint32_t timeout = 0UL;
+
     private:
-        static std::uint8_t address_to_read_command(std::uint8_t const address) noexcept;
-        static std::uint8_t address_to_write_command(std::uint8_t const address) noexcept;
+        HAL_StatusTypeDef transfer_segments(this SPIDevice const& self,
+                                            std::initializer_list<std::span<std::uint8_t const>> const segments) noexcept;
+
+        std::uint32_t get_stats_device(this SPIDevice const& self) noexcept;
+
+        std::uint32_t get_timeout(this SPIDevice const& self, std::size_t const size) noexcept;
 
-        static constexpr std::uint32_t TIMEOUT = 100UL;
+        // HAL sizes count frames, not bytes
+        static constexpr std::uint16_t get_frames(std::size_t const size) noexcept;
+
+        static constexpr std::uint16_t RW_FLAG = static_cast<std::uint16_t>(1U << Protocol::RW_BIT);
+        static constexpr std::uint16_t READ_FLAG = Protocol::READ_HIGH ? RW_FLAG : 0U;
+        static constexpr std::uint16_t WRITE_FLAG = Protocol::READ_HIGH ? 0U : RW_FLAG;
+        static constexpr std::uint16_t INCREMENT_FLAG =
+            Protocol::INCREMENT_BIT < Protocol::ADDRESS_BITS ? static_cast<std::uint16_t>(1U << Protocol::INCREMENT_BIT)
+                                                             : 0U;
+        static constexpr std::uint16_t ADDRESS_MASK =
+            static_cast<std::uint16_t>(((1UL << Protocol::ADDRESS_BITS) - 1UL) ^ RW_FLAG ^ INCREMENT_FLAG);
     };
 
+    template <typename PROTOCOL>
     template <std::size_t SIZE>
-    void SPIDevice::transmit_bytes(this SPIDevice const& self, std::array<std::uint8_t, SIZE> const& data) noexcept
+    Expected<> SPIDevice<PROTOCOL>::transmit_bytes(this SPIDevice const& self,
+                                                   std::array<std::uint8_t, SIZE> const& data) noexcept
     {
-        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
-        HAL_SPI_Transmit(self.spi_bus, data.data(), data.size(), TIMEOUT);
-        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::TRANSMIT, SIZE, [&] {
+            gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+            auto const result = HAL_SPI_Transmit(self.spi_bus, data.data(), get_frames(SIZE), self.get_timeout(SIZE));
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+            return result;
+        }));
     }
 
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::transmit_bytes(this SPIDevice const& self,
+                                                   std::uint8_t* const data,
+                                                   std::size_t const size) noexcept
+    {
+        assert(data);
+
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::TRANSMIT, size, [&] {
+            gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+            auto const result = HAL_SPI_Transmit(self.spi_bus, data, get_frames(size), self.get_timeout(size));
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+            return result;
+        }));
+    }
+
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::transmit_byte(this SPIDevice const& self, std::uint8_t const data) noexcept
+    {
+        return self.transmit_bytes(std::array<std::uint8_t, 1UL>{data});
+    }
+
+    template <typename PROTOCOL>
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> SPIDevice::receive_bytes(this SPIDevice const& self) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> SPIDevice<PROTOCOL>::receive_bytes(this SPIDevice const& self) noexcept
     {
         auto data = std::array<std::uint8_t, SIZE>{};
 
-        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
-        HAL_SPI_Receive(self.spi_bus, data.data(), data.size(), TIMEOUT);
-        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::RECEIVE, SIZE, [&] {
+                   gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+                   auto const result =
+                       HAL_SPI_Receive(self.spi_bus, data.data(), get_frames(SIZE), self.get_timeout(SIZE));
+                   gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+                   return result;
+               }))
+            .transform([&] { return data; });
+    }
 
-        return data;
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::receive_bytes(this SPIDevice const& self,
+                                                  std::uint8_t* const data,
+                                                  std::size_t const size) noexcept
+    {
+        assert(data);
+
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::RECEIVE, size, [&] {
+            gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+            auto const result = HAL_SPI_Receive(self.spi_bus, data, get_frames(size), self.get_timeout(size));
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+            return result;
+        }));
     }
 
+    template <typename PROTOCOL>
+    Expected<std::uint8_t> SPIDevice<PROTOCOL>::receive_byte(this SPIDevice const& self) noexcept
+    {
+        return self.template receive_bytes<1UL>().transform([](auto const& data) { return data[0]; });
+    }
+
+    template <typename PROTOCOL>
     template <std::size_t SIZE>
-    std::array<std::uint8_t, SIZE> SPIDevice::read_bytes(this SPIDevice const& self,
-                                                         std::uint8_t const address) noexcept
+    Expected<std::array<std::uint8_t, SIZE>> SPIDevice<PROTOCOL>::read_bytes(this SPIDevice const& self,
+                                                                              std::uint16_t const address) noexcept
     {
+        auto const command = get_command(address, true, SIZE);
+
+        // the bytes clocked in during the command and dummy cycles are dropped
+        auto tx_data = std::array<std::uint8_t, READ_PREFIX_SIZE + SIZE>{};
+        auto rx_data = std::array<std::uint8_t, READ_PREFIX_SIZE + SIZE>{};
+        std::copy(command.begin(), command.end(), tx_data.begin());
+
         auto data = std::array<std::uint8_t, SIZE>{};
-        auto command = address_to_read_command(address);
 
-        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
-        HAL_SPI_TransmitReceive(self.spi_bus, &command, data.data(), data.size(), TIMEOUT);
-        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::READ, SIZE, [&] {
+                   gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+                   auto const result = HAL_SPI_TransmitReceive(self.spi_bus,
+                                                               tx_data.data(),
+                                                               rx_data.data(),
+                                                               get_frames(tx_data.size()),
+                                                               self.get_timeout(tx_data.size()));
+                   gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+                   return result;
+               }))
+            .transform([&] {
+                std::copy(rx_data.begin() + READ_PREFIX_SIZE, rx_data.end(), data.begin());
+                return data;
+            });
+    }
+
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::read_bytes(this SPIDevice const& self,
+                                               std::uint16_t const address,
+                                               std::uint8_t* const data,
+                                               std::size_t const size) noexcept
+    {
+        assert(data);
+
+        auto prefix = std::array<std::uint8_t, READ_PREFIX_SIZE>{};
+        auto const command = get_command(address, true, size);
+        std::copy(command.begin(), command.end(), prefix.begin());
+
+        // command and dummy cycles first, then the data straight into the caller's buffer
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::READ, size, [&] {
+            gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+            auto const prefix_frames = get_frames(prefix.size());
+            auto result = HAL_SPI_Transmit(self.spi_bus, prefix.data(), prefix_frames, self.get_timeout(prefix.size()));
+            if (result == HAL_OK) {
+                result = HAL_SPI_Receive(self.spi_bus, data, get_frames(size), self.get_timeout(size));
+            }
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+            return result;
+        }));
+    }
+
+    template <typename PROTOCOL>
+    Expected<std::uint8_t> SPIDevice<PROTOCOL>::read_byte(this SPIDevice const& self,
+                                                          std::uint16_t const address) noexcept
+    {
+        static_assert(FRAME_SIZE == 1UL, "single bytes need 8 bit frames");
 
-        return data;
+        return self.template read_bytes<1UL>(address).transform([](auto const& data) { return data[0]; });
     }
 
+    template <typename PROTOCOL>
     template <std::size_t SIZE>
-    void SPIDevice::write_bytes(this SPIDevice const& self,
-                                std::uint8_t const address,
-                                std::array<std::uint8_t, SIZE> const& data) noexcept
+    Expected<> SPIDevice<PROTOCOL>::write_bytes(this SPIDevice const& self,
+                                                std::uint16_t const address,
+                                                std::array<std::uint8_t, SIZE> const& data) noexcept
     {
-        auto const command = address_to_write_command(address);
-        auto address_data = std::array<std::uint8_t, 1UL + SIZE>{};
-        std::memcpy(address_data.data(), &command, 1UL);
-        std::memcpy(address_data.data() + 1UL, data.data(), data.size());
+        auto const command = get_command(address, false, SIZE);
+
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::WRITE, SIZE, [&] {
+            return self.transfer_segments(
+                {std::span<std::uint8_t const>{command}, std::span<std::uint8_t const>{data}});
+        }));
+    }
+
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::write_bytes(this SPIDevice const& self,
+                                                std::uint16_t const address,
+                                                std::uint8_t* const data,
+                                                std::size_t const size) noexcept
+    {
+        assert(data);
+
+        auto const command = get_command(address, false, size);
+
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::WRITE, size, [&] {
+            return self.transfer_segments(
+                {std::span<std::uint8_t const>{command}, std::span<std::uint8_t const>{data, size}});
+        }));
+    }
+
+    template <typename PROTOCOL>
+    Expected<> SPIDevice<PROTOCOL>::write_byte(this SPIDevice const& self,
+                                               std::uint16_t const address,
+                                               std::uint8_t const data) noexcept
+    {
+        static_assert(FRAME_SIZE == 1UL, "single bytes need 8 bit frames");
+
+        return self.write_bytes(address, std::array<std::uint8_t, 1UL>{data});
+    }
+
+    template <typename PROTOCOL>
+    Expected<>
+    SPIDevice<PROTOCOL>::transmit_segments(this SPIDevice const& self,
+                                           std::initializer_list<std::span<std::uint8_t const>> const segments) noexcept
+    {
+        auto size = 0UL;
+        for (auto const segment : segments) {
+            size += segment.size();
+        }
+
+        return to_expected(stats_measure(self.spi_bus, self.get_stats_device(), TransferOperation::TRANSMIT, size, [&] {
+            return self.transfer_segments(segments);
+        }));
+    }
+
+    template <typename PROTOCOL>
+    TransferStatsSnapshot SPIDevice<PROTOCOL>::get_stats(this SPIDevice const& self) noexcept
+    {
+        return stats_get_snapshot(self.spi_bus, self.get_stats_device());
+    }
+
+    template <typename PROTOCOL>
+    void SPIDevice<PROTOCOL>::initialize(this SPIDevice const& self) noexcept
+    {
+        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+    }
+
+    template <typename PROTOCOL>
+    void SPIDevice<PROTOCOL>::deinitialize(this SPIDevice const& self) noexcept
+    {
+        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+    }
+
+    template <typename PROTOCOL>
+    constexpr std::array<std::uint8_t, SPIDevice<PROTOCOL>::COMMAND_SIZE>
+    SPIDevice<PROTOCOL>::get_command(std::uint16_t const address, bool const read, std::size_t const size) noexcept
+    {
+        assert((address & ADDRESS_MASK) == address);
+
+        auto const word = static_cast<std::uint16_t>((address & ADDRESS_MASK) | (read ? READ_FLAG : WRITE_FLAG) |
+                                                     (get_frames(size) > 1U ? INCREMENT_FLAG : 0U));
+
+        if constexpr (COMMAND_SIZE == 1UL) {
+            return {static_cast<std::uint8_t>(word)};
+        } else if constexpr (FRAME_SIZE == 1UL) {
+            return {static_cast<std::uint8_t>(word >> 8U), static_cast<std::uint8_t>(word)};
+        } else {
+            // one halfword frame, little endian in memory, shifted out MSB first
+            return {static_cast<std::uint8_t>(word), static_cast<std::uint8_t>(word >> 8U)};
+        }
+    }
+
+    template <typename PROTOCOL>
+    HAL_StatusTypeDef
+    SPIDevice<PROTOCOL>::transfer_segments(this SPIDevice const& self,
+                                           std::initializer_list<std::span<std::uint8_t const>> const segments) noexcept
+    {
+        auto result = HAL_OK;
 
         gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
-        HAL_SPI_Transmit(self.spi_bus, address_data.data(), address_data.size(), TIMEOUT);
+        for (auto const segment : segments) {
+            if (!segment.empty() && result == HAL_OK) {
+                result = HAL_SPI_Transmit(self.spi_bus,
+                                          const_cast<std::uint8_t*>(segment.data()),
+                                          get_frames(segment.size()),
+                                          self.get_timeout(segment.size()));
+            }
+        }
         gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+        return result;
+    }
+
+    template <typename PROTOCOL>
+    std::uint32_t SPIDevice<PROTOCOL>::get_stats_device(this SPIDevice const& self) noexcept
+    {
+        return static_cast<std::uint16_t>(self.chip_select);
+    }
+
+    template <typename PROTOCOL>
+    std::uint32_t SPIDevice<PROTOCOL>::get_timeout(this SPIDevice const& self, std::size_t const size) noexcept
+    {
+        return self.timeout != 0UL ? self.timeout
+                                   : get_transfer_timeout(8ULL * (size + 1ULL), get_spi_clock_frequency(self.spi_bus));
+    }
+
+    template <typename PROTOCOL>
+    constexpr std::uint16_t SPIDevice<PROTOCOL>::get_frames(std::size_t const size) noexcept
+    {
+        assert(size % FRAME_SIZE == 0UL && size / FRAME_SIZE <= 0xFFFFUL);
+
+        return static_cast<std::uint16_t>(size / FRAME_SIZE);
     }
 
 }; // namespace STM32_Utility
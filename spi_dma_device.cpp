@@ -0,0 +1,140 @@
+#include "spi_dma_device.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    bool SPIDMADevice::submit(this SPIDMADevice& self, SPITransfer const& transfer) noexcept
+    {
+        assert(transfer.tx_data || transfer.rx_data);
+
+        if (transfer.size > MAX_TRANSFER_SIZE) {
+            return false;
+        }
+
+        auto const critical_section = CriticalSection{};
+
+        if (self.pending == self.transfers.size()) {
+            return false;
+        }
+
+        self.transfers[(self.active + self.pending) % self.transfers.size()] = transfer;
+        self.pending = self.pending + 1UL;
+
+        if (self.pending == 1UL) {
+            if (auto const result = self.start(); result != HAL_OK) {
+                self.pending = 0UL;
+                self.status = result;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SPIDMADevice::is_busy(this SPIDMADevice const& self) noexcept
+    {
+        return self.pending != 0UL;
+    }
+
+    bool SPIDMADevice::is_full(this SPIDMADevice const& self) noexcept
+    {
+        return self.pending == self.transfers.size();
+    }
+
+    HAL_StatusTypeDef SPIDMADevice::wait(this SPIDMADevice const& self) noexcept
+    {
+        while (self.is_busy()) {
+            // a completion pending since the check still ends __WFI with PRIMASK set
+            auto const critical_section = CriticalSection{};
+            if (self.is_busy()) {
+                __WFI();
+            }
+        }
+
+        return self.status;
+    }
+
+    void SPIDMADevice::transfer_complete_callback(this SPIDMADevice& self, SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.is_busy()) {
+            self.finish(HAL_OK);
+        }
+    }
+
+    void SPIDMADevice::transfer_error_callback(this SPIDMADevice& self, SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.is_busy()) {
+            HAL_SPI_Abort(self.spi_bus);
+            self.finish(HAL_ERROR);
+        }
+    }
+
+    void SPIDMADevice::initialize(this SPIDMADevice const& self) noexcept
+    {
+        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+    }
+
+    void SPIDMADevice::deinitialize(this SPIDMADevice& self) noexcept
+    {
+        if (self.is_busy()) {
+            HAL_SPI_DMAStop(self.spi_bus);
+            self.pending = 0UL;
+        }
+
+        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+    }
+
+    HAL_StatusTypeDef SPIDMADevice::start(this SPIDMADevice& self) noexcept
+    {
+        auto const& transfer = self.transfers[self.active];
+        auto const size = static_cast<std::uint16_t>(transfer.size);
+        auto result = HAL_ERROR;
+
+        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+
+        if (transfer.tx_data && transfer.rx_data) {
+            result = HAL_SPI_TransmitReceive_DMA(self.spi_bus, transfer.tx_data, transfer.rx_data, size);
+        } else if (transfer.tx_data) {
+            result = HAL_SPI_Transmit_DMA(self.spi_bus, transfer.tx_data, size);
+        } else if (transfer.rx_data) {
+            result = HAL_SPI_Receive_DMA(self.spi_bus, transfer.rx_data, size);
+        }
+
+        if (result != HAL_OK) {
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+        }
+
+        return result;
+    }
+
+    void SPIDMADevice::finish(this SPIDMADevice& self, HAL_StatusTypeDef result) noexcept
+    {
+        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+        auto finished = self.transfers[self.active];
+
+        while (true) {
+            self.status = result;
+            self.active = (self.active + 1UL) % self.transfers.size();
+            self.pending = self.pending - 1UL;
+
+            if (self.pending == 0UL) {
+                break;
+            }
+
+            if (result = self.start(); result == HAL_OK) {
+                break;
+            }
+
+            if (finished.callback) {
+                finished.callback(finished.context, self.status);
+            }
+            finished = self.transfers[self.active];
+        }
+
+        if (finished.callback) {
+            finished.callback(finished.context, self.status);
+        }
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
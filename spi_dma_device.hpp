@@ -0,0 +1,57 @@
+#ifndef SPI_DMA_DEVICE_HPP
+#define SPI_DMA_DEVICE_HPP
+
+#include "common.hpp"
+#include "gpio.hpp"
+
+namespace STM32_Utility {
+
+    struct SPITransfer {
+        std::uint8_t* tx_data = nullptr;
+        std::uint8_t* rx_data = nullptr;
+        std::size_t size = 0UL;
+
+        TransferCallback callback = nullptr;
+        void* context = nullptr;
+    };
+
+    struct SPIDMADevice {
+    public:
+        // false when the queue is full or the transfer is longer than the DMA counter allows
+        bool submit(this SPIDMADevice& self, SPITransfer const& transfer) noexcept;
+
+        bool is_busy(this SPIDMADevice const& self) noexcept;
+        bool is_full(this SPIDMADevice const& self) noexcept;
+
+        // sleeps until both transfers are done, the status of the last one
+        HAL_StatusTypeDef wait(this SPIDMADevice const& self) noexcept;
+
+        // call from HAL_SPI_TxCpltCallback, HAL_SPI_RxCpltCallback and HAL_SPI_TxRxCpltCallback
+        void transfer_complete_callback(this SPIDMADevice& self, SPIHandle const spi_bus) noexcept;
+
+        // call from HAL_SPI_ErrorCallback
+        void transfer_error_callback(this SPIDMADevice& self, SPIHandle const spi_bus) noexcept;
+
+        void initialize(this SPIDMADevice const& self) noexcept;
+        void deinitialize(this SPIDMADevice& self) noexcept;
+
+        // 16 bit NDTR of the DMA stream
+        static constexpr std::size_t MAX_TRANSFER_SIZE = 0xFFFFUL;
+
+        GPIO chip_select = GPIO::NC;
+
+        SPIHandle spi_bus = nullptr;
+
+        std::array<SPITransfer, 2UL> transfers = {};
+        std::uint32_t volatile active = 0UL;
+        std::uint32_t volatile pending = 0UL;
+        HAL_StatusTypeDef volatile status = HAL_OK;
+
+    private:
+        HAL_StatusTypeDef start(this SPIDMADevice& self) noexcept;
+        void finish(this SPIDMADevice& self, HAL_StatusTypeDef const result) noexcept;
+    };
+
+}; // namespace STM32_Utility
+
+#endif // SPI_DMA_DEVICE_HPP
\ No newline at end of file
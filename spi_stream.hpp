@@ -0,0 +1,268 @@
+#ifndef SPI_STREAM_HPP
+#define SPI_STREAM_HPP
+
+#include "clock.hpp"
+#include "common.hpp"
+#include "gpio.hpp"
+#include "ring_buffer.hpp"
+#include "stats.hpp"
+#include <cassert>
+
+namespace STM32_Utility {
+
+    template <std::size_t FRAME_SIZE>
+    struct SPIStreamSample {
+        // DWT->CYCCNT when the data-ready interrupt ran
+        std::uint32_t timestamp = 0UL;
+        std::array<std::uint8_t, FRAME_SIZE> data = {};
+    };
+
+    struct SPIStreamStats {
+    public:
+        // spread of the data-ready period in HCLK cycles
+        std::uint32_t get_jitter(this SPIStreamStats const& self) noexcept
+        {
+            return self.interval.count == 0UL ? 0UL : self.interval.max_cycles - self.interval.min_cycles;
+        }
+
+        std::uint32_t samples = 0UL;
+        // data-ready edges while the previous burst was still in flight, each one a lost burst
+        std::uint32_t overruns = 0UL;
+        // samples the full ring buffer had no room for
+        std::uint32_t dropped = 0UL;
+        std::uint32_t errors = 0UL;
+
+        // cycles between data-ready edges
+        LatencyHistogram interval = {};
+        // cycles from the data-ready edge until the samples are in the ring buffer
+        LatencyHistogram latency = {};
+    };
+
+    // Continuous acquisition from a sensor signalling data-ready on an EXTI line. Each edge lowers
+    // chip_select and starts a DMA burst of read_command followed by WATERMARK frames, so a FIFO
+    // watermark interrupt drains the whole FIFO at once. Completion raises chip_select and pushes the
+    // frames, timestamped, into samples, so the main loop only pops them.
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK = 1UL>
+    struct SPIStream {
+    public:
+        static_assert(FRAME_SIZE > 0UL && WATERMARK > 0UL && WATERMARK <= SIZE);
+
+        using Sample = SPIStreamSample<FRAME_SIZE>;
+
+        static constexpr std::size_t BURST_SIZE = 1UL + FRAME_SIZE * WATERMARK;
+
+        static_assert(BURST_SIZE <= 0xFFFFUL, "burst exceeds a single DMA transfer");
+
+        // an already asserted data-ready line starts the first burst right away, as its edge is gone
+        HAL_StatusTypeDef start(this SPIStream& self) noexcept;
+        void stop(this SPIStream& self) noexcept;
+
+        bool is_running(this SPIStream const& self) noexcept;
+
+        SPIStreamStats get_stats(this SPIStream const& self) noexcept;
+        void reset_stats(this SPIStream& self) noexcept;
+
+        // call from HAL_GPIO_EXTI_Callback
+        void data_ready_callback(this SPIStream& self, std::uint16_t const gpio_pin) noexcept;
+
+        // call from HAL_SPI_TxRxCpltCallback
+        void transfer_complete_callback(this SPIStream& self, SPIHandle const spi_bus) noexcept;
+
+        // call from HAL_SPI_ErrorCallback
+        void transfer_error_callback(this SPIStream& self, SPIHandle const spi_bus) noexcept;
+
+        SPIHandle spi_bus = nullptr;
+        GPIO chip_select = GPIO::NC;
+        GPIO data_ready = GPIO::NC;
+
+        // first byte of every burst, e.g. the read command of the data or FIFO register
+        std::uint8_t read_command = 0U;
+
+        // HCLK cycles between the frames of one burst, earlier frames are dated back by it
+        std::uint32_t frame_interval = 0UL;
+
+        SPSCRingBuffer<Sample, SIZE> samples = {};
+
+        std::array<std::uint8_t, BURST_SIZE> tx_buffer = {};
+        std::array<std::uint8_t, BURST_SIZE> rx_buffer = {};
+
+        bool volatile running = false;
+        bool volatile busy = false;
+
+        std::uint32_t edge_timestamp = 0UL;
+        std::uint32_t previous_edge = 0UL;
+        bool has_edge = false;
+
+        SPIStreamStats stats = {};
+
+    private:
+        HAL_StatusTypeDef begin(this SPIStream& self, std::uint32_t const timestamp) noexcept;
+        void finish(this SPIStream& self) noexcept;
+    };
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    HAL_StatusTypeDef SPIStream<FRAME_SIZE, SIZE, WATERMARK>::start(this SPIStream& self) noexcept
+    {
+        assert(self.spi_bus);
+
+        if (self.running) {
+            return HAL_BUSY;
+        }
+
+        enable_cycle_counter();
+
+        self.tx_buffer.fill(0U);
+        self.tx_buffer[0] = self.read_command;
+
+        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+        self.busy = false;
+        self.has_edge = false;
+        self.running = true;
+
+        if (gpio_read_pin(self.data_ready) == GPIO_PIN_SET) {
+            auto const critical_section = CriticalSection{};
+
+            if (!self.busy) {
+                return self.begin(stats_get_cycles());
+            }
+        }
+
+        return HAL_OK;
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::stop(this SPIStream& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.running = false;
+
+        if (self.busy) {
+            HAL_SPI_DMAStop(self.spi_bus);
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+            self.busy = false;
+        }
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    bool SPIStream<FRAME_SIZE, SIZE, WATERMARK>::is_running(this SPIStream const& self) noexcept
+    {
+        return self.running;
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    SPIStreamStats SPIStream<FRAME_SIZE, SIZE, WATERMARK>::get_stats(this SPIStream const& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        return self.stats;
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::reset_stats(this SPIStream& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.stats = {};
+        self.has_edge = false;
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::data_ready_callback(this SPIStream& self,
+                                                                     std::uint16_t const gpio_pin) noexcept
+    {
+        if (!self.running || gpio_pin != gpio_pin_to_mask(self.data_ready)) {
+            return;
+        }
+
+        auto const timestamp = stats_get_cycles();
+
+        if (self.has_edge) {
+            self.stats.interval.record(timestamp - self.previous_edge);
+        }
+        self.previous_edge = timestamp;
+        self.has_edge = true;
+
+        if (self.busy) {
+            self.stats.overruns += 1UL;
+            return;
+        }
+
+        self.begin(timestamp);
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::transfer_complete_callback(this SPIStream& self,
+                                                                            SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.busy) {
+            self.finish();
+        }
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::transfer_error_callback(this SPIStream& self,
+                                                                         SPIHandle const spi_bus) noexcept
+    {
+        if (spi_bus == self.spi_bus && self.busy) {
+            HAL_SPI_Abort(self.spi_bus);
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+            self.stats.errors += 1UL;
+            self.busy = false;
+        }
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    HAL_StatusTypeDef SPIStream<FRAME_SIZE, SIZE, WATERMARK>::begin(this SPIStream& self,
+                                                                    std::uint32_t const timestamp) noexcept
+    {
+        self.edge_timestamp = timestamp;
+        self.busy = true;
+
+        gpio_write_pin(self.chip_select, GPIO_PIN_RESET);
+
+        auto const result = HAL_SPI_TransmitReceive_DMA(self.spi_bus,
+                                                        self.tx_buffer.data(),
+                                                        self.rx_buffer.data(),
+                                                        static_cast<std::uint16_t>(BURST_SIZE));
+        if (result != HAL_OK) {
+            gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+            self.stats.errors += 1UL;
+            self.busy = false;
+        }
+
+        return result;
+    }
+
+    template <std::size_t FRAME_SIZE, std::size_t SIZE, std::size_t WATERMARK>
+    void SPIStream<FRAME_SIZE, SIZE, WATERMARK>::finish(this SPIStream& self) noexcept
+    {
+        gpio_write_pin(self.chip_select, GPIO_PIN_SET);
+
+        // frames are written straight into the ring buffer, the newest one dated at the edge
+        for (std::size_t frame = 0UL; frame < WATERMARK; ++frame) {
+            auto const space = self.samples.prepare();
+            if (space.empty()) {
+                self.stats.dropped += static_cast<std::uint32_t>(WATERMARK - frame);
+                break;
+            }
+
+            auto& sample = space.front();
+            sample.timestamp =
+                self.edge_timestamp - static_cast<std::uint32_t>(WATERMARK - 1UL - frame) * self.frame_interval;
+            std::copy_n(self.rx_buffer.data() + 1UL + frame * FRAME_SIZE, FRAME_SIZE, sample.data.data());
+
+            self.samples.commit(1UL);
+            self.stats.samples += 1UL;
+        }
+
+        self.stats.latency.record(stats_get_cycles() - self.edge_timestamp);
+        self.busy = false;
+    }
+
+}; // namespace STM32_Utility
+
+#endif // SPI_STREAM_HPP
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "stats.hpp"
+#include "clock.hpp"
+#include "log.hpp"
+#include <bit>
+
+namespace STM32_Utility {
+
+    namespace {
+
+        struct StatsEntry {
+            void const* bus = nullptr;
+            std::uint32_t device = 0UL;
+            TransferStats stats = {};
+        };
+
+        // no storage at all unless enabled
+        constinit std::array<StatsEntry, STATS_ENABLED ? STATS_ENTRIES : 0UL> stats_entries = {};
+
+        // reported once, every later device past the last entry goes uncounted as well
+        constinit bool stats_exhausted = false;
+
+        TransferStats* stats_claim(void const* const bus, std::uint32_t const device) noexcept
+        {
+            auto const critical_section = CriticalSection{};
+
+            for (auto& entry : stats_entries) {
+                if (entry.bus == bus && entry.device == device) {
+                    return &entry.stats;
+                }
+                if (entry.bus == nullptr) {
+                    entry.device = device;
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                    entry.bus = bus;
+                    return &entry.stats;
+                }
+            }
+
+            if (!stats_exhausted) {
+                stats_exhausted = true;
+                log_fault("STATS ERROR");
+            }
+
+            return nullptr;
+        }
+
+        TransferStats* stats_get(void const* const bus, std::uint32_t const device) noexcept
+        {
+            if (auto const stats = stats_find(bus, device); stats != nullptr) {
+                return stats;
+            }
+
+            return stats_claim(bus, device);
+        }
+
+    }; // namespace
+
+    void LatencyHistogram::record(this LatencyHistogram& self, std::uint32_t const cycles) noexcept
+    {
+        self.min_cycles = self.count == 0UL ? cycles : std::min(self.min_cycles, cycles);
+        self.max_cycles = std::max(self.max_cycles, cycles);
+        self.total_cycles += cycles;
+        self.count += 1UL;
+        self.buckets[static_cast<std::size_t>(std::bit_width(cycles))] += 1UL;
+    }
+
+    std::uint32_t LatencyHistogram::get_percentile(this LatencyHistogram const& self,
+                                                   std::uint32_t const permille) noexcept
+    {
+        if (self.count == 0UL) {
+            return 0UL;
+        }
+
+        auto const rank = (static_cast<std::uint64_t>(self.count) * permille + 999ULL) / 1000ULL;
+        auto cumulative = 0ULL;
+
+        for (auto bucket = 0UL; bucket < STATS_BUCKETS; ++bucket) {
+            cumulative += self.buckets[bucket];
+            if (cumulative >= rank) {
+                auto const upper_bound = static_cast<std::uint32_t>((1ULL << bucket) - 1ULL);
+                return std::clamp(upper_bound, self.min_cycles, self.max_cycles);
+            }
+        }
+
+        return self.max_cycles;
+    }
+
+    std::uint32_t LatencyHistogram::get_p99(this LatencyHistogram const& self) noexcept
+    {
+        return self.get_percentile(990UL);
+    }
+
+    std::uint32_t LatencyHistogram::get_mean(this LatencyHistogram const& self) noexcept
+    {
+        return self.count == 0UL ? 0UL : static_cast<std::uint32_t>(self.total_cycles / self.count);
+    }
+
+    void TransferStats::record(this TransferStats& self,
+                               TransferOperation const operation,
+                               std::size_t const bytes,
+                               HAL_StatusTypeDef const result,
+                               bool const nack,
+                               std::uint32_t const cycles) noexcept
+    {
+        // the bus entry takes every device on the bus, which may complete from different priorities
+        auto const critical_section = CriticalSection{};
+
+        self.data.transactions += 1UL;
+
+        if (nack) {
+            self.data.nacks += 1UL;
+        } else if (result == HAL_TIMEOUT) {
+            self.data.timeouts += 1UL;
+        } else if (result != HAL_OK) {
+            self.data.errors += 1UL;
+        } else {
+            self.data.bytes += static_cast<std::uint32_t>(bytes);
+        }
+
+        self.data.latency[std::to_underlying(operation)].record(cycles);
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.sequence.store(self.sequence.load(std::memory_order_relaxed) + 1U, std::memory_order_release);
+    }
+
+    TransferStatsSnapshot TransferStats::get_snapshot(this TransferStats const& self) noexcept
+    {
+        auto snapshot = TransferStatsSnapshot{};
+
+        // writes cannot be preempted, so only a write landing during the copy repeats it
+        for (std::size_t retry = 0UL; retry < SNAPSHOT_RETRIES; ++retry) {
+            auto const sequence = self.sequence.load(std::memory_order_acquire);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            snapshot = self.data;
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            if (sequence == self.sequence.load(std::memory_order_acquire)) {
+                return snapshot;
+            }
+        }
+
+        // transfers completing faster than the copy would keep it retrying forever
+        auto const critical_section = CriticalSection{};
+
+        return self.data;
+    }
+
+    void TransferStats::reset(this TransferStats& self) noexcept
+    {
+        auto const critical_section = CriticalSection{};
+
+        self.data = TransferStatsSnapshot{};
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        self.sequence.store(self.sequence.load(std::memory_order_relaxed) + 1U, std::memory_order_release);
+    }
+
+    void stats_initialize() noexcept
+    {
+        if constexpr (STATS_ENABLED) {
+            // a reset of CYCCNT would corrupt spans measured by delay_microseconds, samplers and streams
+            enable_cycle_counter();
+        }
+    }
+
+    TransferStats* stats_find(void const* const bus, std::uint32_t const device) noexcept
+    {
+        for (auto& entry : stats_entries) {
+            if (entry.bus == bus && entry.device == device) {
+                return &entry.stats;
+            }
+        }
+
+        return nullptr;
+    }
+
+    TransferStatsSnapshot stats_get_snapshot(void const* const bus, std::uint32_t const device) noexcept
+    {
+        if (auto const stats = stats_find(bus, device); stats != nullptr) {
+            return stats->get_snapshot();
+        }
+
+        return TransferStatsSnapshot{};
+    }
+
+    void stats_reset() noexcept
+    {
+        for (auto& entry : stats_entries) {
+            entry.stats.reset();
+        }
+    }
+
+    void stats_record(void const* const bus,
+                      std::uint32_t const device,
+                      TransferOperation const operation,
+                      std::size_t const bytes,
+                      HAL_StatusTypeDef const result,
+                      bool const nack,
+                      std::uint32_t const cycles) noexcept
+    {
+        if (auto const stats = stats_get(bus, STATS_BUS); stats != nullptr) {
+            stats->record(operation, bytes, result, nack, cycles);
+        }
+
+        if (device == STATS_BUS) {
+            return;
+        }
+
+        if (auto const stats = stats_get(bus, device); stats != nullptr) {
+            stats->record(operation, bytes, result, nack, cycles);
+        }
+    }
+
+}; // namespace STM32_Utility
\ No newline at end of file
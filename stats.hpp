@@ -0,0 +1,141 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include "common.hpp"
+#include <atomic>
+
+// 0 - disabled, 1 - count transfers and time them with DWT->CYCCNT
+#ifndef STM32_UTILITY_STATS
+#define STM32_UTILITY_STATS 0
+#endif
+
+#ifndef STM32_UTILITY_STATS_ENTRIES
+#define STM32_UTILITY_STATS_ENTRIES 8
+#endif
+
+namespace STM32_Utility {
+
+    inline constexpr bool STATS_ENABLED = STM32_UTILITY_STATS != 0;
+
+    inline constexpr std::size_t STATS_ENTRIES = STM32_UTILITY_STATS_ENTRIES;
+    inline constexpr std::size_t STATS_BUCKETS = 33UL;
+
+    // device id of the counters aggregating every device on a bus
+    inline constexpr std::uint32_t STATS_BUS = 0xFFFFFFFFUL;
+
+    enum struct TransferOperation : std::uint8_t {
+        TRANSMIT,
+        RECEIVE,
+        READ,
+        WRITE,
+        PROBE,
+    };
+
+    inline constexpr std::size_t TRANSFER_OPERATIONS = 5UL;
+
+    // bucket n holds latencies of bit width n, so its upper bound is 2^n - 1 cycles
+    struct LatencyHistogram {
+    public:
+        void record(this LatencyHistogram& self, std::uint32_t const cycles) noexcept;
+
+        std::uint32_t get_percentile(this LatencyHistogram const& self, std::uint32_t const permille) noexcept;
+        std::uint32_t get_p99(this LatencyHistogram const& self) noexcept;
+        std::uint32_t get_mean(this LatencyHistogram const& self) noexcept;
+
+        std::uint32_t count = 0UL;
+        std::uint32_t min_cycles = 0UL;
+        std::uint32_t max_cycles = 0UL;
+        std::uint64_t total_cycles = 0ULL;
+        std::array<std::uint32_t, STATS_BUCKETS> buckets = {};
+    };
+
+    struct TransferStatsSnapshot {
+        std::uint32_t transactions = 0UL;
+        std::uint32_t bytes = 0UL;
+        std::uint32_t errors = 0UL;
+        std::uint32_t timeouts = 0UL;
+        std::uint32_t nacks = 0UL;
+
+        std::array<LatencyHistogram, TRANSFER_OPERATIONS> latency = {};
+    };
+
+    struct TransferStats {
+    public:
+        // safe from any priority, the counters are updated with interrupts disabled
+        void record(this TransferStats& self,
+                    TransferOperation const operation,
+                    std::size_t const bytes,
+                    HAL_StatusTypeDef const result,
+                    bool const nack,
+                    std::uint32_t const cycles) noexcept;
+
+        // copied without masking interrupts, or inside a critical section once a copy was torn
+        // SNAPSHOT_RETRIES times in a row
+        TransferStatsSnapshot get_snapshot(this TransferStats const& self) noexcept;
+
+        void reset(this TransferStats& self) noexcept;
+
+        // records and resets so far
+        std::atomic<std::uint32_t> sequence = 0UL;
+        TransferStatsSnapshot data = {};
+
+    private:
+        static constexpr std::size_t SNAPSHOT_RETRIES = 3UL;
+    };
+
+    // enables DWT->CYCCNT without resetting it, call once before any transfer when STM32_UTILITY_STATS is set
+    void stats_initialize() noexcept;
+
+    TransferStats* stats_find(void const* const bus, std::uint32_t const device) noexcept;
+
+    // empty snapshot when nothing was recorded for bus and device or stats are disabled
+    TransferStatsSnapshot stats_get_snapshot(void const* const bus, std::uint32_t const device = STATS_BUS) noexcept;
+
+    void stats_reset() noexcept;
+
+    void stats_record(void const* const bus,
+                      std::uint32_t const device,
+                      TransferOperation const operation,
+                      std::size_t const bytes,
+                      HAL_StatusTypeDef const result,
+                      bool const nack,
+                      std::uint32_t const cycles) noexcept;
+
+    inline std::uint32_t stats_get_cycles() noexcept
+    {
+        return DWT->CYCCNT;
+    }
+
+    inline bool stats_is_nack(I2CHandle const i2c_bus) noexcept
+    {
+        return (i2c_bus->ErrorCode & HAL_I2C_ERROR_AF) != 0UL;
+    }
+
+    inline bool stats_is_nack(SPIHandle const) noexcept
+    {
+        return false;
+    }
+
+    template <typename Handle, typename Transfer>
+    inline HAL_StatusTypeDef stats_measure(Handle const bus,
+                                           std::uint32_t const device,
+                                           TransferOperation const operation,
+                                           std::size_t const bytes,
+                                           Transfer&& transfer) noexcept
+    {
+        if constexpr (!STATS_ENABLED) {
+            return transfer();
+        } else {
+            auto const start = stats_get_cycles();
+            auto const result = transfer();
+            auto const cycles = stats_get_cycles() - start;
+
+            stats_record(bus, device, operation, bytes, result, result != HAL_OK && stats_is_nack(bus), cycles);
+
+            return result;
+        }
+    }
+
+}; // namespace STM32_Utility
+
+#endif // STATS_HPP
\ No newline at end of file